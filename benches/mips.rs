@@ -0,0 +1,273 @@
+use std::{
+    env,
+    fs::{self, File},
+    io::{self, Read},
+    path::{Path, PathBuf},
+    process::{Command, Stdio},
+    time::{Duration, Instant},
+};
+
+/// Fixed workload set. Names are stable across runs so results can be
+/// diffed; add new entries at the end. The `test-bench` programs check
+/// their own results and exit non-zero on a mismatch.
+const WORKLOADS: &[(&str, &str)] = &[
+    ("fib", "bins/fib"),
+    ("loop_count", "test-bins/asm/loop_count"),
+    ("nested_loops", "test-bins/c/nested_loops"),
+    ("recursion", "test-bins/c/recursion"),
+    ("qsort_ints", "test-bins/c/qsort_ints"),
+    ("linked_list", "test-bins/c/linked_list"),
+    ("string_ops", "test-bins/c/string_ops"),
+    ("math_mix", "test-bins/c/math_mix"),
+    ("printf_formats", "test-bins/c/printf_formats"),
+    ("file_readwrite", "test-bins/c/file_readwrite"),
+    ("csmith_1", "test-bins/csmith/csmith_1"),
+    ("csmith_48", "test-bins/csmith/csmith_48"),
+    ("csmith_73", "test-bins/csmith/csmith_73"),
+    ("dhrystone", "test-bins/bench/dhrystone"),
+    ("coremark", "test-bins/bench/coremark"),
+    ("sha256", "test-bins/bench/sha256"),
+    ("crc32", "test-bins/bench/crc32"),
+    ("lz", "test-bins/bench/lz"),
+    ("json", "test-bins/bench/json"),
+    ("matmul", "test-bins/bench/matmul"),
+    ("tree", "test-bins/bench/tree"),
+];
+
+struct Args {
+    tier: Option<String>,
+    runs: usize,
+    out: Option<PathBuf>,
+    filter: Vec<String>,
+}
+
+/// One timed run of a workload.
+struct Sample {
+    wall: Duration,
+    instructions: u64,
+    syscalls: u64,
+    peak_rss_kb: u64,
+    status: i32,
+}
+
+struct Report {
+    name: &'static str,
+    binary: &'static str,
+    samples: Vec<Sample>,
+}
+
+fn parse_args() -> Args {
+    let mut args = Args {
+        tier: None,
+        runs: 3,
+        out: None,
+        filter: Vec::new(),
+    };
+    let mut iter = env::args().skip(1);
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            // Passed by `cargo bench` to every harness.
+            "--bench" => {}
+            "--tier" => args.tier = iter.next(),
+            "--runs" => {
+                args.runs = iter
+                    .next()
+                    .and_then(|n| n.parse().ok())
+                    .filter(|&n| n > 0)
+                    .expect("--runs expects a positive count")
+            }
+            "--out" => args.out = iter.next().map(PathBuf::from),
+            _ if arg.starts_with("--") => panic!("unknown option {arg}"),
+            _ => args.filter.push(arg),
+        }
+    }
+    args
+}
+
+fn ensure_bins(binaries: &[&str]) {
+    let status = Command::new("make")
+        .args(binaries)
+        .status()
+        .expect("Failed to run make");
+    assert!(status.success(), "make {} failed", binaries.join(" "));
+}
+
+/// Run the interpreter once and collect its exit counters and the child's
+/// resource usage. Guest stdout is discarded; stderr is read to find the
+/// `--exec-stats` lines (one per guest process, so forks are summed).
+fn run_once(exe: &Path, tier: Option<&str>) -> io::Result<Sample> {
+    let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
+    cmd.arg("--exec-stats");
+    if let Some(tier) = tier {
+        cmd.args(["--tier", tier]);
+    }
+    cmd.arg(exe)
+        .stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .stderr(Stdio::piped());
+
+    let start = Instant::now();
+    let mut child = cmd.spawn()?;
+    let mut stderr = String::new();
+    child
+        .stderr
+        .take()
+        .expect("stderr is piped")
+        .read_to_string(&mut stderr)?;
+
+    // Reap with wait4 rather than Child::wait to get the rusage of this
+    // child alone.
+    let mut status = 0;
+    let mut usage: libc::rusage = unsafe { std::mem::zeroed() };
+    let pid = child.id() as libc::pid_t;
+    if unsafe { libc::wait4(pid, &mut status, 0, &mut usage) } < 0 {
+        return Err(io::Error::last_os_error());
+    }
+    let wall = start.elapsed();
+
+    let mut instructions = 0;
+    let mut syscalls = 0;
+    for line in stderr.lines() {
+        if let Some((insts, calls)) = parse_exec_stats(line) {
+            instructions += insts;
+            syscalls += calls;
+        }
+    }
+
+    Ok(Sample {
+        wall,
+        instructions,
+        syscalls,
+        peak_rss_kb: usage.ru_maxrss as u64,
+        status: if libc::WIFEXITED(status) {
+            libc::WEXITSTATUS(status)
+        } else {
+            -1
+        },
+    })
+}
+
+/// Parse "executed: N instructions, M syscalls".
+fn parse_exec_stats(line: &str) -> Option<(u64, u64)> {
+    let rest = line.strip_prefix("executed: ")?;
+    let (insts, rest) = rest.split_once(" instructions, ")?;
+    let calls = rest.strip_suffix(" syscalls")?;
+    Some((insts.parse().ok()?, calls.parse().ok()?))
+}
+
+impl Report {
+    /// Whether any run exited non-zero.
+    fn failed(&self) -> bool {
+        self.samples.iter().any(|s| s.status != 0)
+    }
+
+    /// Sample with the median wall time; counts are the same in every run
+    /// of a deterministic guest.
+    fn median(&self) -> &Sample {
+        let mut order: Vec<&Sample> = self.samples.iter().collect();
+        order.sort_by_key(|s| s.wall);
+        order[order.len() / 2]
+    }
+
+    fn to_json(&self) -> String {
+        let sample = self.median();
+        let secs = sample.wall.as_secs_f64();
+        let rate = |count: u64| {
+            if secs > 0.0 { count as f64 / secs } else { 0.0 }
+        };
+        let walls: Vec<String> = self
+            .samples
+            .iter()
+            .map(|s| format!("{:.3}", s.wall.as_secs_f64() * 1e3))
+            .collect();
+        format!(
+            concat!(
+                "{{\"name\": \"{}\", \"binary\": \"{}\", \"status\": {}, ",
+                "\"wall_ms\": {:.3}, \"wall_ms_runs\": [{}], ",
+                "\"instructions\": {}, \"mips\": {:.3}, ",
+                "\"syscalls\": {}, \"syscalls_per_sec\": {:.1}, ",
+                "\"peak_rss_kb\": {}}}"
+            ),
+            self.name,
+            self.binary,
+            sample.status,
+            secs * 1e3,
+            walls.join(", "),
+            sample.instructions,
+            rate(sample.instructions) / 1e6,
+            sample.syscalls,
+            rate(sample.syscalls),
+            self.samples
+                .iter()
+                .map(|s| s.peak_rss_kb)
+                .max()
+                .unwrap_or(0),
+        )
+    }
+}
+
+fn main() {
+    let args = parse_args();
+    let workloads: Vec<&(&str, &str)> = WORKLOADS
+        .iter()
+        .filter(|(name, _)| args.filter.is_empty() || args.filter.iter().any(|f| name.contains(f)))
+        .collect();
+    ensure_bins(&workloads.iter().map(|(_, bin)| *bin).collect::<Vec<_>>());
+
+    let mut reports = Vec::new();
+    for &&(name, binary) in &workloads {
+        let samples = (0..args.runs)
+            .map(|_| run_once(Path::new(binary), args.tier.as_deref()))
+            .collect::<io::Result<Vec<_>>>()
+            .unwrap_or_else(|e| panic!("{name}: {e}"));
+        let report = Report {
+            name,
+            binary,
+            samples,
+        };
+        let sample = report.median();
+        eprintln!(
+            "{name:<16} {:>10.3} ms {:>14} insts {:>9.2} MIPS {:>8} KiB  exit {}{}",
+            sample.wall.as_secs_f64() * 1e3,
+            sample.instructions,
+            sample.instructions as f64 / sample.wall.as_secs_f64() / 1e6,
+            sample.peak_rss_kb,
+            sample.status,
+            if report.failed() { "  FAILED" } else { "" },
+        );
+        reports.push(report);
+    }
+
+    let entries: Vec<String> = reports
+        .iter()
+        .map(|r| format!("    {}", r.to_json()))
+        .collect();
+    let json = format!(
+        "{{\n  \"tier\": \"{}\",\n  \"runs\": {},\n  \"workloads\": [\n{}\n  ]\n}}\n",
+        args.tier.as_deref().unwrap_or("interpreter"),
+        args.runs,
+        entries.join(",\n"),
+    );
+    match &args.out {
+        Some(path) => {
+            if let Some(dir) = path.parent() {
+                fs::create_dir_all(dir).expect("create output directory");
+            }
+            File::create(path)
+                .and_then(|mut f| io::Write::write_all(&mut f, json.as_bytes()))
+                .expect("write bench output");
+        }
+        None => print!("{json}"),
+    }
+
+    // The programs check their own results, so a non-zero exit means the
+    // emulator computed something wrong and its figures mean nothing.
+    let failed: Vec<&str> = reports
+        .iter()
+        .filter(|r| r.failed())
+        .map(|r| r.name)
+        .collect();
+    if !failed.is_empty() {
+        panic!("workloads exited non-zero: {}", failed.join(", "));
+    }
+}
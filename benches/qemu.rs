@@ -0,0 +1,230 @@
+use std::{
+    env, fs, io,
+    path::{Path, PathBuf},
+    process::{Command, Stdio},
+    time::{Duration, Instant},
+};
+
+const QEMU: &str = "qemu-m68k-static";
+
+/// Same corpora as tests/cli.rs and tests/csmith.rs: (source root, binary
+/// root, make target).
+const SUITES: &[(&str, &str, &str)] = &[
+    ("test-files/c", "test-bins/c", "test-bins"),
+    ("test-csmith", "test-bins/csmith", "test-csmith-bins"),
+];
+
+struct Args {
+    runs: usize,
+    /// Flag tests where behistun is more than this many times slower.
+    slow_factor: f64,
+    tier: Option<String>,
+    filter: Vec<String>,
+}
+
+/// Median and interquartile range of one engine's wall times, in seconds.
+struct Timing {
+    median: f64,
+    iqr: f64,
+}
+
+struct Row {
+    name: String,
+    qemu: Timing,
+    behistun: Timing,
+}
+
+impl Row {
+    fn ratio(&self) -> f64 {
+        self.behistun.median / self.qemu.median
+    }
+}
+
+fn parse_args() -> Args {
+    let mut args = Args {
+        runs: 5,
+        slow_factor: 10.0,
+        tier: None,
+        filter: Vec::new(),
+    };
+    let mut iter = env::args().skip(1);
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            // Passed by `cargo bench` to every harness.
+            "--bench" => {}
+            "--runs" => {
+                args.runs = iter
+                    .next()
+                    .and_then(|n| n.parse().ok())
+                    .filter(|&n| n > 0)
+                    .expect("--runs expects a positive count")
+            }
+            "--slow-factor" => {
+                args.slow_factor = iter
+                    .next()
+                    .and_then(|n| n.parse().ok())
+                    .expect("--slow-factor expects a number")
+            }
+            "--tier" => args.tier = iter.next(),
+            _ if arg.starts_with("--") => panic!("unknown option {arg}"),
+            _ => args.filter.push(arg),
+        }
+    }
+    args
+}
+
+fn tool_available(bin: &str) -> bool {
+    Command::new(bin)
+        .arg("--version")
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .map(|s| s.success())
+        .unwrap_or(false)
+}
+
+fn load_args(path: &Path) -> Vec<String> {
+    let args_path = path.with_extension("args");
+    if let Ok(text) = fs::read_to_string(args_path) {
+        text.split_whitespace().map(|s| s.to_string()).collect()
+    } else {
+        Vec::new()
+    }
+}
+
+/// C sources under `root`, sorted so the table order is stable.
+fn find_sources(root: &Path, out: &mut Vec<PathBuf>) -> io::Result<()> {
+    for entry in fs::read_dir(root)? {
+        let path = entry?.path();
+        if path.is_dir() {
+            find_sources(&path, out)?;
+        } else if path.extension().is_some_and(|ext| ext == "c") {
+            out.push(path);
+        }
+    }
+    out.sort();
+    Ok(())
+}
+
+/// Time one run of `cmd`. A run that fails is an error rather than a
+/// sample, so a crash is never timed as a fast success.
+fn time_once(mut cmd: Command) -> io::Result<Duration> {
+    cmd.stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .stderr(Stdio::null());
+    let start = Instant::now();
+    let status = cmd.status()?;
+    let elapsed = start.elapsed();
+    if !status.success() {
+        return Err(io::Error::other(format!(
+            "{} exited with {status}",
+            cmd.get_program().display()
+        )));
+    }
+    Ok(elapsed)
+}
+
+fn timing(mut samples: Vec<Duration>) -> Timing {
+    samples.sort();
+    let secs = |i: usize| samples[i].as_secs_f64();
+    let n = samples.len();
+    Timing {
+        median: secs(n / 2),
+        iqr: secs(n * 3 / 4) - secs(n / 4),
+    }
+}
+
+fn measure(exe: &Path, args: &[String], opts: &Args) -> io::Result<Row> {
+    let mut qemu = Vec::new();
+    let mut behistun = Vec::new();
+    // Alternate engines so drift in machine load hits both equally.
+    for _ in 0..opts.runs {
+        let mut cmd = Command::new(QEMU);
+        cmd.arg(exe).args(args);
+        qemu.push(time_once(cmd)?);
+
+        let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
+        if let Some(tier) = &opts.tier {
+            cmd.args(["--tier", tier]);
+        }
+        cmd.arg(exe).args(args);
+        behistun.push(time_once(cmd)?);
+    }
+    Ok(Row {
+        name: exe.display().to_string(),
+        qemu: timing(qemu),
+        behistun: timing(behistun),
+    })
+}
+
+fn main() {
+    let args = parse_args();
+    if !tool_available(QEMU) {
+        eprintln!("skipping qemu comparison (missing {QEMU})");
+        return;
+    }
+
+    let mut rows = Vec::new();
+    for &(src_root, bin_root, target) in SUITES {
+        let status = Command::new("make")
+            .arg(target)
+            .status()
+            .expect("Failed to run make");
+        assert!(status.success(), "make {target} failed");
+
+        let mut sources = Vec::new();
+        find_sources(Path::new(src_root), &mut sources)
+            .unwrap_or_else(|e| panic!("{src_root}: {e}"));
+        for src in sources {
+            let rel = src.strip_prefix(src_root).unwrap().with_extension("");
+            let exe = Path::new(bin_root).join(rel);
+            let name = exe.display().to_string();
+            if !args.filter.is_empty() && !args.filter.iter().any(|f| name.contains(f)) {
+                continue;
+            }
+            match measure(&exe, &load_args(&src), &args) {
+                Ok(row) => rows.push(row),
+                Err(e) => eprintln!("skipping {name}: {e}"),
+            }
+        }
+    }
+    if rows.is_empty() {
+        return;
+    }
+
+    // Slowest relative to qemu first: the top of the table is the list of
+    // workloads worth profiling.
+    rows.sort_by(|a, b| b.ratio().total_cmp(&a.ratio()));
+    println!(
+        "{:<44} {:>10} {:>9} {:>10} {:>9} {:>8}",
+        "test", "qemu ms", "iqr", "behistun", "iqr", "ratio"
+    );
+    let mut log_sum = 0.0;
+    let mut slow = 0;
+    for row in &rows {
+        let ratio = row.ratio();
+        log_sum += ratio.ln();
+        let flag = if ratio > args.slow_factor {
+            slow += 1;
+            "  SLOW"
+        } else {
+            ""
+        };
+        println!(
+            "{:<44} {:>10.3} {:>9.3} {:>10.3} {:>9.3} {:>7.2}x{flag}",
+            row.name,
+            row.qemu.median * 1e3,
+            row.qemu.iqr * 1e3,
+            row.behistun.median * 1e3,
+            row.behistun.iqr * 1e3,
+            ratio,
+        );
+    }
+    println!(
+        "\n{} tests, geometric mean {:.2}x qemu, {} more than {}x slower",
+        rows.len(),
+        (log_sum / rows.len() as f64).exp(),
+        slow,
+        args.slow_factor,
+    );
+}
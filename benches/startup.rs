@@ -0,0 +1,147 @@
+use std::{
+    env,
+    io::{self, BufRead, BufReader},
+    process::{Command, Stdio},
+    time::{Duration, Instant},
+};
+
+/// Guests that do next to nothing, so a launch is almost all startup.
+const WORKLOADS: &[(&str, &str)] = &[("hello", "test-bins/c/hello"), ("true", "test-bins/c/true")];
+
+struct Args {
+    launches: usize,
+    tier: Option<String>,
+    extra: Vec<String>,
+    filter: Vec<String>,
+}
+
+/// One launch of the interpreter.
+struct Launch {
+    /// From spawn to the interpreter announcing the first guest instruction.
+    first_instruction: Duration,
+    /// The interpreter's own part of that, from the top of `main`.
+    setup: Duration,
+    /// From spawn to exit.
+    total: Duration,
+}
+
+fn parse_args() -> Args {
+    let mut args = Args {
+        launches: 1000,
+        tier: None,
+        extra: Vec::new(),
+        filter: Vec::new(),
+    };
+    let mut iter = env::args().skip(1);
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            // Passed by `cargo bench` to every harness.
+            "--bench" => {}
+            "--launches" => {
+                args.launches = iter
+                    .next()
+                    .and_then(|n| n.parse().ok())
+                    .filter(|&n| n > 0)
+                    .expect("--launches expects a positive count")
+            }
+            "--tier" => args.tier = iter.next(),
+            // Passed through to the interpreter, e.g. `--flag --predecode`.
+            "--flag" => args.extra.extend(iter.next()),
+            _ if arg.starts_with("--") => panic!("unknown option {arg}"),
+            _ => args.filter.push(arg),
+        }
+    }
+    args
+}
+
+fn launch(binary: &str, args: &Args) -> io::Result<Launch> {
+    let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
+    cmd.arg("--startup-time");
+    if let Some(tier) = &args.tier {
+        cmd.args(["--tier", tier]);
+    }
+    cmd.args(&args.extra)
+        .arg(binary)
+        .stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .stderr(Stdio::piped());
+
+    let start = Instant::now();
+    let mut child = cmd.spawn()?;
+    let mut first_instruction = None;
+    let mut setup = Duration::ZERO;
+    let stderr = BufReader::new(child.stderr.take().expect("stderr is piped"));
+    for line in stderr.lines() {
+        let line = line?;
+        if let Some(us) = line
+            .strip_prefix("first instruction: ")
+            .and_then(|rest| rest.strip_suffix(" us"))
+        {
+            first_instruction.get_or_insert_with(|| start.elapsed());
+            setup = Duration::from_micros(us.parse().unwrap_or(0));
+        }
+    }
+    let status = child.wait()?;
+    let total = start.elapsed();
+    if !status.success() {
+        return Err(io::Error::other(format!("{binary} exited with {status}")));
+    }
+    let first_instruction = first_instruction
+        .ok_or_else(|| io::Error::other(format!("{binary}: no first instruction reported")))?;
+    Ok(Launch {
+        first_instruction,
+        setup,
+        total,
+    })
+}
+
+/// Median and 90th percentile, in microseconds.
+fn percentiles(mut times: Vec<Duration>) -> (f64, f64) {
+    times.sort();
+    let at = |q: f64| times[((times.len() - 1) as f64 * q).round() as usize];
+    (at(0.5).as_secs_f64() * 1e6, at(0.9).as_secs_f64() * 1e6)
+}
+
+fn main() {
+    let args = parse_args();
+    let workloads: Vec<&(&str, &str)> = WORKLOADS
+        .iter()
+        .filter(|(name, _)| args.filter.is_empty() || args.filter.iter().any(|f| name.contains(f)))
+        .collect();
+    let binaries: Vec<&str> = workloads.iter().map(|(_, bin)| *bin).collect();
+    let status = Command::new("make")
+        .args(&binaries)
+        .status()
+        .expect("Failed to run make");
+    assert!(status.success(), "make {} failed", binaries.join(" "));
+
+    let mut entries = Vec::new();
+    for &&(name, binary) in &workloads {
+        let launches = (0..args.launches)
+            .map(|_| launch(binary, &args))
+            .collect::<io::Result<Vec<_>>>()
+            .unwrap_or_else(|e| panic!("{name}: {e}"));
+        let (ttfi, ttfi_p90) = percentiles(launches.iter().map(|l| l.first_instruction).collect());
+        let (setup, setup_p90) = percentiles(launches.iter().map(|l| l.setup).collect());
+        let (total, total_p90) = percentiles(launches.iter().map(|l| l.total).collect());
+        eprintln!(
+            "{name:<8} first instruction {ttfi:>8.1} us (p90 {ttfi_p90:>8.1}), \
+             setup {setup:>8.1} us, total {total:>8.1} us (p90 {total_p90:>8.1})"
+        );
+        entries.push(format!(
+            concat!(
+                "    {{\"name\": \"{}\", \"binary\": \"{}\", ",
+                "\"first_instruction_us\": {:.1}, \"first_instruction_p90_us\": {:.1}, ",
+                "\"setup_us\": {:.1}, \"setup_p90_us\": {:.1}, ",
+                "\"total_us\": {:.1}, \"total_p90_us\": {:.1}}}"
+            ),
+            name, binary, ttfi, ttfi_p90, setup, setup_p90, total, total_p90,
+        ));
+    }
+    print!(
+        "{{\n  \"tier\": \"{}\",\n  \"launches\": {},\n  \"workloads\": [\n{}\n  ]\n}}\n",
+        args.tier.as_deref().unwrap_or("interpreter"),
+        args.launches,
+        entries.join(",\n"),
+    );
+}
@@ -0,0 +1,240 @@
+// Decode a `behistun --trace` file into a readable listing, disassembling
+// each block entry from the guest ELF.
+
+#[allow(dead_code)]
+#[path = "../decoder/mod.rs"]
+mod decoder;
+#[allow(dead_code)]
+#[path = "../loader.rs"]
+mod loader;
+#[path = "../memory.rs"]
+mod memory;
+#[allow(dead_code)]
+#[path = "../symbols.rs"]
+mod symbols;
+#[allow(dead_code)]
+#[path = "../syscall.rs"]
+mod syscall;
+#[allow(dead_code)]
+#[path = "../trace.rs"]
+mod trace;
+
+use std::{
+    collections::HashMap,
+    env, fs,
+    io::{self, BufWriter, Write},
+};
+
+use anyhow::{Context, Result, bail};
+use goblin::Object;
+
+use crate::{
+    decoder::Decoder,
+    loader::{ElfFile, load_memory_image},
+    symbols::Symbols,
+    syscall::m68k_syscall_name,
+    trace::{
+        MAGIC, TAG_BITS, TAG_BLOCK, TAG_EXEC, TAG_RESULT, TAG_SYSCALL, TAG_WRITE_BYTE,
+        TAG_WRITE_LONG, TAG_WRITE_WORD, VERSION,
+    },
+};
+
+pub fn unzigzag(value: u64) -> i64 {
+    (value >> 1) as i64 ^ -((value & 1) as i64)
+}
+
+/// Decode a varint at `*pos`, advancing past it.
+pub fn get_varint(buf: &[u8], pos: &mut usize) -> Option<u64> {
+    let mut value = 0u64;
+    for shift in (0..64).step_by(7) {
+        let byte = *buf.get(*pos)?;
+        *pos += 1;
+        value |= u64::from(byte & 0x7f) << shift;
+        if byte & 0x80 == 0 {
+            return Some(value);
+        }
+    }
+    None
+}
+
+struct Args {
+    trace: String,
+    /// Guest binary to disassemble; defaults to the one named in the trace.
+    elf: Option<String>,
+    /// Print per-kind event counts instead of the listing.
+    summary: bool,
+}
+
+/// Guest image the trace is currently executing.
+struct Image {
+    decoder: Decoder,
+    symbols: Symbols,
+    /// Disassembly by pc, so hot loops are decoded once.
+    listing: HashMap<u32, String>,
+}
+
+impl Image {
+    fn load(path: &str) -> Result<Self> {
+        let data = ElfFile::open(path)?;
+        let Object::Elf(elf) = Object::parse(&data)? else {
+            bail!("{path}: not an ELF file");
+        };
+        Ok(Self {
+            decoder: Decoder::new(load_memory_image(&elf, &data)?),
+            symbols: Symbols::from_elf(&elf),
+            listing: HashMap::new(),
+        })
+    }
+
+    fn line(&mut self, pc: u32) -> &str {
+        self.listing.entry(pc).or_insert_with(|| {
+            let text = match self.decoder.decode_instruction(pc as usize) {
+                Ok(inst) => inst.kind.to_string(),
+                Err(e) => format!("<{e}>"),
+            };
+            format!(
+                "{pc:#010x} {:<28} {text}",
+                format!("<{}>", self.symbols.describe(pc as usize))
+            )
+        })
+    }
+}
+
+fn parse_args() -> Result<Args> {
+    let mut trace = None;
+    let mut elf = None;
+    let mut summary = false;
+    let mut iter = env::args().skip(1);
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            "--elf" => elf = Some(iter.next().context("--elf expects a path")?),
+            "--summary" => summary = true,
+            _ if arg.starts_with("--") => bail!("unknown option {arg}"),
+            _ if trace.is_none() => trace = Some(arg),
+            _ => bail!("unexpected argument {arg}"),
+        }
+    }
+    let Some(trace) = trace else {
+        bail!("usage: behistun-trace [--elf BINARY] [--summary] TRACE");
+    };
+    Ok(Args {
+        trace,
+        elf,
+        summary,
+    })
+}
+
+fn main() {
+    if let Err(err) = run() {
+        eprintln!("Error: {err:#}");
+        std::process::exit(1);
+    }
+}
+
+fn run() -> Result<()> {
+    let args = parse_args()?;
+    let data = fs::read(&args.trace).with_context(|| format!("reading {}", args.trace))?;
+    if data.len() < 5 || &data[..4] != MAGIC {
+        bail!("{}: not a behistun trace", args.trace);
+    }
+    if data[4] != VERSION {
+        bail!(
+            "{}: trace version {} (expected {VERSION})",
+            args.trace,
+            data[4]
+        );
+    }
+    let mut pos = 5;
+    let exe_len = get_varint(&data, &mut pos).context("truncated header")? as usize;
+    let exe = String::from_utf8_lossy(data.get(pos..pos + exe_len).context("truncated header")?)
+        .into_owned();
+    pos += exe_len;
+
+    let mut image = if args.summary {
+        None
+    } else {
+        Some(Image::load(args.elf.as_deref().unwrap_or(&exe))?)
+    };
+    let mut counts = [0u64; 1 << TAG_BITS];
+    let mut out = BufWriter::new(io::stdout().lock());
+
+    while pos < data.len() {
+        let Some(header) = data.get(pos..pos + 4) else {
+            eprintln!("warning: trailing partial chunk header");
+            break;
+        };
+        let len = u32::from_le_bytes(header.try_into().unwrap()) as usize;
+        pos += 4;
+        let Some(chunk) = data.get(pos..pos + len) else {
+            eprintln!("warning: trace ends inside a chunk; rest ignored");
+            break;
+        };
+        pos += len;
+
+        let (mut cur, mut last_pc, mut last_write) = (0, 0u32, 0u32);
+        while cur < chunk.len() {
+            let word = get_varint(chunk, &mut cur).context("corrupt event")?;
+            let tag = word & ((1 << TAG_BITS) - 1);
+            let value = word >> TAG_BITS;
+            counts[tag as usize] += 1;
+            match tag {
+                TAG_BLOCK => {
+                    last_pc = last_pc.wrapping_add(unzigzag(value) as u32);
+                    if let Some(image) = &mut image {
+                        writeln!(out, "{}", image.line(last_pc))?;
+                    }
+                }
+                TAG_WRITE_BYTE | TAG_WRITE_WORD | TAG_WRITE_LONG => {
+                    last_write = last_write.wrapping_add(unzigzag(value) as u32);
+                    let size = ["b", "w", "l"][tag as usize - 1];
+                    if image.is_some() {
+                        writeln!(out, "    write.{size} {last_write:#010x}")?;
+                    }
+                }
+                TAG_SYSCALL => {
+                    let mut regs = [0u64; 6];
+                    for reg in &mut regs {
+                        *reg = get_varint(chunk, &mut cur).context("corrupt syscall")?;
+                    }
+                    if image.is_some() {
+                        let name = match m68k_syscall_name(value as u32) {
+                            Some(name) => name.to_string(),
+                            None => format!("syscall_{value}"),
+                        };
+                        let regs: Vec<String> = regs.iter().map(|r| format!("{r:#x}")).collect();
+                        write!(out, "    {name}({})", regs.join(", "))?;
+                    }
+                }
+                TAG_RESULT => {
+                    if image.is_some() {
+                        writeln!(out, " = {}", unzigzag(value))?;
+                    }
+                }
+                TAG_EXEC => {
+                    let len = value as usize;
+                    let path = chunk.get(cur..cur + len).context("corrupt exec")?;
+                    let path = String::from_utf8_lossy(path).into_owned();
+                    cur += len;
+                    if let Some(image) = &mut image {
+                        writeln!(out, "\n    execve {path}")?;
+                        *image = Image::load(&path)?;
+                    }
+                }
+                _ => bail!("unknown event tag {tag}"),
+            }
+        }
+    }
+
+    if args.summary {
+        writeln!(out, "{exe}")?;
+        writeln!(out, "  blocks    {}", counts[TAG_BLOCK as usize])?;
+        let writes: u64 = counts[TAG_WRITE_BYTE as usize..=TAG_WRITE_LONG as usize]
+            .iter()
+            .sum();
+        writeln!(out, "  writes    {writes}")?;
+        writeln!(out, "  syscalls  {}", counts[TAG_SYSCALL as usize])?;
+        writeln!(out, "  execs     {}", counts[TAG_EXEC as usize])?;
+    }
+    out.flush()?;
+    Ok(())
+}
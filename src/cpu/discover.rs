@@ -0,0 +1,220 @@
+// Static code discovery for `behistun aot` and `--predecode`. Walks guest
+// code by recursive descent from the ELF entry point and function symbols,
+// following branch and call targets and gcc-style PC-relative jump tables.
+// The walk runs on every host core: workers share one queue of addresses
+// still to visit and stop once it is empty and nobody is busy. Code it
+// cannot see (computed jumps through registers, code written at run time)
+// is still translated lazily when the guest reaches it.
+
+use std::{
+    collections::HashSet,
+    sync::{Condvar, Mutex},
+    thread,
+};
+
+use anyhow::Result;
+
+use super::{Cpu, ends_block, pgo};
+use crate::{
+    decoder::{Decoder, EffectiveAddress, Instruction, InstructionKind, ResolvedEa},
+    memory::MemoryImage,
+};
+
+/// Longest jump table followed.
+const MAX_TABLE_ENTRIES: usize = 1024;
+
+fn is_code(memory: &MemoryImage, addr: usize) -> bool {
+    addr.is_multiple_of(2) && memory.fetch_instruction(addr, 2).is_ok()
+}
+
+/// Addresses still to visit, shared by the walk's workers.
+struct Work {
+    pending: Vec<usize>,
+    seen: HashSet<usize>,
+    /// Workers visiting an address, which may queue more.
+    busy: usize,
+}
+
+/// Visit every address reachable from `roots`, once each, on every host
+/// core. `visit` handles the block at one address and returns what it made
+/// of it and where control can go from there.
+pub(super) fn walk<T: Send>(
+    memory: &MemoryImage,
+    roots: &[usize],
+    visit: impl Fn(usize) -> Option<(T, Vec<usize>)> + Sync,
+) -> Vec<(usize, T)> {
+    let seen: HashSet<usize> = roots.iter().copied().collect();
+    let work = Mutex::new(Work {
+        pending: seen.iter().copied().collect(),
+        seen,
+        busy: 0,
+    });
+    let ready = Condvar::new();
+    let worker = || {
+        let mut found = Vec::new();
+        loop {
+            let Ok(mut queue) = work.lock() else {
+                return found;
+            };
+            let pc = loop {
+                if let Some(pc) = queue.pending.pop() {
+                    queue.busy += 1;
+                    break pc;
+                }
+                if queue.busy == 0 {
+                    ready.notify_all();
+                    return found;
+                }
+                queue = match ready.wait(queue) {
+                    Ok(queue) => queue,
+                    Err(_) => return found,
+                };
+            };
+            drop(queue);
+
+            let next = match is_code(memory, pc).then(|| visit(pc)).flatten() {
+                Some((item, next)) => {
+                    found.push((pc, item));
+                    next
+                }
+                None => Vec::new(),
+            };
+
+            let Ok(mut queue) = work.lock() else {
+                return found;
+            };
+            for pc in next {
+                if queue.seen.insert(pc) {
+                    queue.pending.push(pc);
+                }
+            }
+            queue.busy -= 1;
+            ready.notify_all();
+        }
+    };
+    let threads = thread::available_parallelism().map_or(1, |n| n.get());
+    thread::scope(|scope| {
+        let handles: Vec<_> = (0..threads).map(|_| scope.spawn(worker)).collect();
+        handles
+            .into_iter()
+            .flat_map(|handle| handle.join().unwrap_or_default())
+            .collect()
+    })
+}
+
+/// Block entry addresses reachable from `roots`, in address order.
+pub(super) fn discover_blocks(memory: &MemoryImage, roots: &[usize]) -> Vec<usize> {
+    let decoder = Decoder::new(memory.code_view());
+    let mut blocks: Vec<usize> = walk(memory, roots, |start| {
+        let mut pc = start;
+        // Follow the block to its last instruction; a decode failure ends
+        // it with nothing to follow.
+        while let Ok(inst) = decoder.decode_instruction(pc) {
+            pc = inst.address + inst.len();
+            if ends_block(&inst.kind) {
+                return Some(((), exits(memory, &inst)));
+            }
+        }
+        Some(((), Vec::new()))
+    })
+    .into_iter()
+    .map(|(pc, ())| pc)
+    .collect();
+    blocks.sort_unstable();
+    blocks
+}
+
+/// Where control can go after a block-ending instruction.
+pub(super) fn exits(memory: &MemoryImage, last: &Instruction) -> Vec<usize> {
+    let next = last.address + last.len();
+    let branch = |displacement: i32| (last.address as i64 + 2 + displacement as i64) as usize;
+    match last.kind {
+        InstructionKind::Bra { displacement } => vec![branch(displacement)],
+        InstructionKind::Bcc { displacement, .. } | InstructionKind::Bsr { displacement } => {
+            vec![branch(displacement), next]
+        }
+        InstructionKind::DBcc { displacement, .. } => vec![branch(displacement as i32), next],
+        InstructionKind::Jsr { mode } => match mode.resolved {
+            ResolvedEa::Abs(target) => vec![target as usize, next],
+            _ => vec![next],
+        },
+        InstructionKind::Jmp { mode } => match mode.resolved {
+            ResolvedEa::Abs(target) => vec![target as usize],
+            _ if matches!(mode.ea, EffectiveAddress::PCIndex) => jump_table(memory, last),
+            _ => Vec::new(),
+        },
+        InstructionKind::Rts
+        | InstructionKind::Rtd { .. }
+        | InstructionKind::Rtr
+        | InstructionKind::Rte
+        | InstructionKind::Illegal
+        | InstructionKind::Reset => Vec::new(),
+        // Traps (syscalls) and bounds checks return to the next instruction.
+        _ => vec![next],
+    }
+}
+
+/// Targets of a gcc switch: `jmp (2,pc,dN.w)` directly followed by a table
+/// of word offsets from the table start. The table ends where the first
+/// case label after it begins, or at the first entry that does not point at
+/// code.
+fn jump_table(memory: &MemoryImage, jmp: &Instruction) -> Vec<usize> {
+    let InstructionKind::Jmp { mode } = jmp.kind else {
+        return Vec::new();
+    };
+    let ResolvedEa::Index { disp, .. } = mode.resolved else {
+        return Vec::new();
+    };
+    let table = disp as usize;
+    let end = jmp.address + jmp.len();
+    // Allow for the alignment padding gcc may put before the table.
+    if !(end..=end + 2).contains(&table) {
+        return Vec::new();
+    }
+    let mut targets = Vec::new();
+    let mut limit = usize::MAX;
+    let mut at = table;
+    while targets.len() < MAX_TABLE_ENTRIES && at + 2 <= limit {
+        let Ok(word) = memory.read_word(at) else {
+            break;
+        };
+        let target = (table as i64 + word as i16 as i64) as usize;
+        if !is_code(memory, target) || (table..at + 2).contains(&target) {
+            break;
+        }
+        if target > at {
+            limit = limit.min(target);
+        }
+        targets.push(target);
+        at += 2;
+    }
+    targets
+}
+
+/// Discover the code of the binary at `binary` (loaded as `memory`) from
+/// `roots` and write the block list to `out` in the `--profile-in` format,
+/// keyed by the binary's hash. Returns the number of blocks.
+pub fn save_code_map(
+    binary: &str,
+    memory: &MemoryImage,
+    roots: &[usize],
+    out: &str,
+) -> Result<usize> {
+    let blocks = discover_blocks(memory, roots);
+    let entries: Vec<(usize, u64)> = blocks.iter().map(|&pc| (pc, 0)).collect();
+    pgo::write_profile(out, pgo::binary_hash(binary)?, &entries, &[])?;
+    Ok(blocks.len())
+}
+
+impl Cpu {
+    /// With `--predecode`, have the run loop translate everything reachable
+    /// from the entry point and function symbols before the guest starts.
+    pub(super) fn start_predecode(&mut self) {
+        if self.options.predecode {
+            let roots = std::iter::once(self.pc)
+                .chain(self.symbols.starts())
+                .collect();
+            self.profile_hints.get_or_insert_default().predecode = roots;
+        }
+    }
+}
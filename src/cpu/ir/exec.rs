@@ -0,0 +1,190 @@
+use anyhow::Result;
+
+use super::{
+    ExitTest, FlagKind, IrBlock, Op, Val,
+    opt::{fold_alu, fold_unary},
+};
+use crate::{
+    cpu::{
+        m68020::{Cpu, FLAG_C, FLAG_N, FLAG_V, FLAG_X, FLAG_Z, SizeInfo, write_sized_data_reg},
+        translate::CodeCache,
+    },
+    decoder::Size,
+};
+
+impl Cpu {
+    /// Run with guest code lowered to optimized micro-op blocks.
+    pub(crate) fn run_ir(&mut self) -> Result<()> {
+        let mut blocks: CodeCache<IrBlock> = self.code_cache();
+        let mut temps: Vec<u32> = Vec::new();
+
+        while !self.halted {
+            let pc = self.pc;
+            let block = blocks.get(pc)?;
+            if temps.len() < block.temps {
+                temps.resize(block.temps, 0);
+            }
+
+            let mut current = 0;
+            let result =
+                self.enter_block(pc, |cpu| cpu.exec_ir_block(block, &mut temps, &mut current));
+            if let Err(e) = result {
+                let inst = &block.insts[current];
+                self.pc = inst.address;
+                eprintln!("FAILED at PC={:#010x}: {:?}", inst.address, inst.kind);
+                eprintln!("Error: {:?}", e);
+                self.dump_registers();
+                return Err(e);
+            }
+            self.executed += current as u64 + 1;
+            self.profile_edges(&block.insts[..=current]);
+            if self.executed >= self.sample_at {
+                self.profile_tick();
+            }
+            #[cfg(feature = "stats")]
+            self.record_insts(&block.insts[..=current]);
+            if !self.stale_code.is_empty() {
+                blocks.invalidate(&mut self.stale_code, &self.memory);
+            }
+            if self.pc == self.snapshot_at || self.snapshot_requested {
+                self.save_snapshot(blocks.entries());
+            }
+        }
+
+        Ok(())
+    }
+
+    fn exec_ir_block(
+        &mut self,
+        block: &IrBlock,
+        temps: &mut [u32],
+        current: &mut usize,
+    ) -> Result<()> {
+        let val = |temps: &[u32], v: Val| match v {
+            Val::Temp(t) => temps[t.0 as usize],
+            Val::Const(c) => c,
+        };
+
+        for op in &block.ops {
+            match *op {
+                Op::Mark(index) => *current = index as usize,
+                Op::Get { dst, reg } => {
+                    let n = reg.0 as usize;
+                    temps[dst.0 as usize] = if n < 8 {
+                        self.data_regs[n]
+                    } else {
+                        self.addr_regs[n - 8]
+                    };
+                }
+                Op::Set { reg, size, src } => {
+                    let value = val(temps, src);
+                    let n = reg.0 as usize;
+                    if n < 8 {
+                        self.data_regs[n] = write_sized_data_reg(self.data_regs[n], value, size);
+                    } else {
+                        self.addr_regs[n - 8] = value;
+                    }
+                }
+                Op::Alu { dst, op, a, b } => {
+                    temps[dst.0 as usize] = fold_alu(op, val(temps, a), val(temps, b));
+                }
+                Op::Unary { dst, op, src } => {
+                    temps[dst.0 as usize] = fold_unary(op, val(temps, src));
+                }
+                Op::Load {
+                    dst,
+                    size,
+                    addr,
+                    offset,
+                } => {
+                    let addr = val(temps, addr).wrapping_add(offset as u32);
+                    temps[dst.0 as usize] = self.read_mem(addr as usize, size)?;
+                }
+                Op::Store {
+                    size,
+                    addr,
+                    offset,
+                    src,
+                } => {
+                    let addr = val(temps, addr).wrapping_add(offset as u32);
+                    self.write_mem(addr as usize, size, val(temps, src))?;
+                }
+                Op::Flags {
+                    kind,
+                    size,
+                    mask,
+                    a,
+                    b,
+                    res,
+                } => {
+                    let flags =
+                        compute_flags(kind, size, val(temps, a), val(temps, b), val(temps, res));
+                    self.sr = (self.sr & !mask) | (flags & mask);
+                }
+                Op::Cond { dst, cond } => {
+                    temps[dst.0 as usize] = if self.test_condition(cond) { 0xff } else { 0 };
+                }
+                Op::Exit { test, target } => {
+                    let taken = match test {
+                        ExitTest::Always => true,
+                        ExitTest::Cond(cond) => self.test_condition(cond),
+                        ExitTest::NotEqual { val: v, mask, imm } => val(temps, v) & mask != imm,
+                    };
+                    if taken {
+                        self.pc = val(temps, target) as usize;
+                        return Ok(());
+                    }
+                }
+                Op::Fallback(index) => {
+                    let inst = &block.insts[index as usize];
+                    self.pc = inst.address;
+                    self.execute(inst)?;
+                    if self.halted || self.pc != inst.address + inst.len() {
+                        return Ok(());
+                    }
+                }
+            }
+        }
+        Ok(())
+    }
+}
+
+/// Condition codes for a sized operation, mirroring `add_with_flags`,
+/// `sub_with_flags` and the shift helpers of the interpreter.
+fn compute_flags(kind: FlagKind, size: Size, a: u32, b: u32, res: u32) -> u16 {
+    let si = SizeInfo::new(size);
+    let (a, b, res) = (si.apply(a), si.apply(b), si.apply(res));
+    let mut flags = 0;
+    if si.is_negative(res) {
+        flags |= FLAG_N;
+    }
+    if res == 0 {
+        flags |= FLAG_Z;
+    }
+    let (carry, overflow) = match kind {
+        FlagKind::Add => (
+            a as u64 + b as u64 > si.mask as u64,
+            si.is_negative(a) == si.is_negative(b) && si.is_negative(res) != si.is_negative(a),
+        ),
+        FlagKind::Sub => (
+            b > a,
+            si.is_negative(a) != si.is_negative(b) && si.is_negative(res) != si.is_negative(a),
+        ),
+        FlagKind::Logic => (false, false),
+        FlagKind::ShiftLeft => {
+            let count = b.min(si.bits);
+            (count > 0 && (a >> (si.bits - count)) & 1 != 0, false)
+        }
+        FlagKind::ShiftRight => {
+            let count = b.min(si.bits);
+            (count > 0 && (a >> (count - 1)) & 1 != 0, false)
+        }
+    };
+    if carry {
+        flags |= FLAG_C | FLAG_X;
+    }
+    if overflow {
+        flags |= FLAG_V;
+    }
+    flags
+}
@@ -0,0 +1,724 @@
+use super::{AluOp, ExitTest, FlagKind, Op, Reg, Temp, UnaryOp, Val};
+use crate::{
+    cpu::{
+        ends_block,
+        m68020::{Cpu, FLAG_C, FLAG_N, FLAG_V, FLAG_X, FLAG_Z, imm_to_u32},
+    },
+    decoder::{
+        Add, AddressingMode, And, DataDir, DnToEa, EaToDn, EffectiveAddress, Exg, ExtMode, ImmOp,
+        IndexReg, Instruction, InstructionKind, Movem, Or, QuickOp, ResolvedEa, RightOrLeft, Shift,
+        ShiftCount, Size, Sub, UnaryOp as GuestUnary,
+    },
+};
+
+const FLAGS_ARITH: u16 = FLAG_N | FLAG_Z | FLAG_V | FLAG_C | FLAG_X;
+const FLAGS_CMP: u16 = FLAG_N | FLAG_Z | FLAG_V | FLAG_C;
+const FLAGS_LOGIC: u16 = FLAG_N | FLAG_Z | FLAG_V | FLAG_C;
+
+/// Where an operand lives once its effective address has been resolved.
+/// Resolving applies any (An)+ / -(An) update exactly once, so
+/// read-modify-write instructions reuse the same `Loc` for both accesses.
+#[derive(Clone, Copy)]
+enum Loc {
+    D(usize),
+    A(usize),
+    Imm(u32),
+    Mem { addr: Val, offset: i32 },
+}
+
+#[derive(Default)]
+pub(super) struct Builder {
+    pub(super) ops: Vec<Op>,
+    pub(super) temps: u16,
+}
+
+impl Builder {
+    /// Lower `inst`, the `index`th instruction of the block, falling back to
+    /// the interpreter for anything without a micro-op form. Returns true if
+    /// the instruction ends the block.
+    pub(super) fn lower(&mut self, inst: &Instruction, index: u16) -> bool {
+        self.ops.push(Op::Mark(index));
+        let (ops_len, temps) = (self.ops.len(), self.temps);
+        match self.lower_native(inst) {
+            Some(ends_block) => ends_block,
+            None => {
+                self.ops.truncate(ops_len);
+                self.temps = temps;
+                self.ops.push(Op::Fallback(index));
+                ends_block(&inst.kind)
+            }
+        }
+    }
+
+    /// Lower a conditional branch the block continues past on its taken
+    /// side: leave for `next` when the condition fails.
+    pub(super) fn branch_taken(&mut self, inst: &Instruction, index: u16, next: usize) {
+        let InstructionKind::Bcc { condition, .. } = inst.kind else {
+            unreachable!("only Bcc is laid out by bias");
+        };
+        self.ops.push(Op::Mark(index));
+        self.exit(ExitTest::Cond(condition.negate()), Val::Const(next as u32));
+    }
+
+    pub(super) fn exit(&mut self, test: ExitTest, target: Val) {
+        self.ops.push(Op::Exit { test, target });
+    }
+
+    fn lower_native(&mut self, inst: &Instruction) -> Option<bool> {
+        let pc = inst.address;
+        let next = Val::Const((pc + inst.len()) as u32);
+        let branch_target =
+            |displacement: i32| Val::Const((pc as i64 + 2 + displacement as i64) as u32);
+
+        match inst.kind {
+            InstructionKind::Nop => {}
+            InstructionKind::Moveq { data, dst } => {
+                let value = Val::Const(data as i32 as u32);
+                self.set(Reg::d(dst as usize), Size::Long, value);
+                self.logic_flags(Size::Long, value);
+            }
+            InstructionKind::Move { size, src, dst } => {
+                let src = self.resolve(&src, size)?;
+                let value = self.read(src, size);
+                let dst = self.resolve_dst(&dst, size)?;
+                self.write(dst, size, value)?;
+                self.logic_flags(size, value);
+            }
+            // MOVEA.B is not a valid encoding; let the interpreter decide.
+            InstructionKind::Movea { size, src, dst } if size != Size::Byte => {
+                let src = self.resolve(&src, size)?;
+                let value = self.read(src, size);
+                let value = self.extend_word(size, value);
+                self.set(Reg::a(dst as usize), Size::Long, value);
+            }
+            InstructionKind::Lea { src, dst } => {
+                let (addr, offset) = self.ea_address(&src)?;
+                let addr = self.offset_addr(addr, offset);
+                self.set(Reg::a(dst as usize), Size::Long, addr);
+            }
+            InstructionKind::Pea { mode } => {
+                let (addr, offset) = self.ea_address(&mode)?;
+                let addr = self.offset_addr(addr, offset);
+                self.push(addr);
+            }
+            InstructionKind::Clr(GuestUnary { size, mode }) => {
+                let dst = self.resolve_dst(&mode, size)?;
+                self.write(dst, size, Val::Const(0))?;
+                self.logic_flags(size, Val::Const(0));
+            }
+            InstructionKind::Tst { size, mode } => {
+                let src = self.resolve(&mode, size)?;
+                let value = self.read(src, size);
+                self.logic_flags(size, value);
+            }
+            InstructionKind::Neg(GuestUnary { size, mode }) => {
+                let loc = self.resolve_dst(&mode, size)?;
+                let value = self.read(loc, size);
+                let result = self.unary(UnaryOp::Neg, value);
+                self.write(loc, size, result)?;
+                self.flags(
+                    FlagKind::Sub,
+                    size,
+                    FLAGS_ARITH,
+                    Val::Const(0),
+                    value,
+                    result,
+                );
+            }
+            InstructionKind::Not(GuestUnary { size, mode }) => {
+                let loc = self.resolve_dst(&mode, size)?;
+                let value = self.read(loc, size);
+                let result = self.unary(UnaryOp::Not, value);
+                self.write(loc, size, result)?;
+                self.logic_flags(size, result);
+            }
+            InstructionKind::Ext { data_reg, mode } => {
+                let reg = Reg::d(data_reg as usize);
+                let value = self.get(reg);
+                let (op, size) = match mode {
+                    ExtMode::ByteToWord => (UnaryOp::Sext8, Size::Word),
+                    ExtMode::WordToLong => (UnaryOp::Sext16, Size::Long),
+                    ExtMode::ByteToLong => (UnaryOp::Sext8, Size::Long),
+                };
+                let result = self.unary(op, value);
+                self.set(reg, size, result);
+                self.logic_flags(size, result);
+            }
+            InstructionKind::Swap { data_reg } => {
+                let reg = Reg::d(data_reg as usize);
+                let value = self.get(reg);
+                let result = self.alu(AluOp::Rotl, value, Val::Const(16));
+                self.set(reg, Size::Long, result);
+                self.logic_flags(Size::Long, result);
+            }
+            InstructionKind::Add(Add::EaToDn(EaToDn { size, dst, src }))
+            | InstructionKind::Sub(Sub::EaToDn(EaToDn { size, dst, src })) => {
+                let is_add = matches!(inst.kind, InstructionKind::Add(_));
+                let src = self.resolve(&src, size)?;
+                let src = self.read(src, size);
+                let reg = Reg::d(dst as usize);
+                let dst = self.get(reg);
+                let result = self.add_or_sub(is_add, size, src, dst, FLAGS_ARITH);
+                self.set(reg, size, result);
+            }
+            InstructionKind::Add(Add::DnToEa(DnToEa { size, src, dst }))
+            | InstructionKind::Sub(Sub::DnToEa(DnToEa { size, src, dst })) => {
+                let is_add = matches!(inst.kind, InstructionKind::Add(_));
+                let src = self.get(Reg::d(src as usize));
+                let loc = self.resolve_dst(&dst, size)?;
+                let dst = self.read(loc, size);
+                let result = self.add_or_sub(is_add, size, src, dst, FLAGS_ARITH);
+                self.write(loc, size, result)?;
+            }
+            InstructionKind::Addi(ImmOp { imm, size, mode })
+            | InstructionKind::Subi(ImmOp { imm, size, mode }) => {
+                let is_add = matches!(inst.kind, InstructionKind::Addi(_));
+                let loc = self.resolve_dst(&mode, size)?;
+                let dst = self.read(loc, size);
+                let result =
+                    self.add_or_sub(is_add, size, Val::Const(imm_to_u32(imm)), dst, FLAGS_ARITH);
+                self.write(loc, size, result)?;
+            }
+            InstructionKind::Addq(QuickOp { data, size, mode })
+            | InstructionKind::Subq(QuickOp { data, size, mode }) => {
+                let is_add = matches!(inst.kind, InstructionKind::Addq(_));
+                let amount = Val::Const(if data == 0 { 8 } else { data as u32 });
+                if let EffectiveAddress::Ar(reg) = mode.ea {
+                    // Address register destinations use all 32 bits and leave
+                    // the flags alone.
+                    let reg = Reg::a(reg as usize);
+                    let value = self.get(reg);
+                    let op = if is_add { AluOp::Add } else { AluOp::Sub };
+                    let result = self.alu(op, value, amount);
+                    self.set(reg, Size::Long, result);
+                } else {
+                    let loc = self.resolve_dst(&mode, size)?;
+                    let dst = self.read(loc, size);
+                    let result = self.add_or_sub(is_add, size, amount, dst, FLAGS_ARITH);
+                    self.write(loc, size, result)?;
+                }
+            }
+            InstructionKind::Adda {
+                addr_reg,
+                size,
+                mode,
+            }
+            | InstructionKind::Suba {
+                addr_reg,
+                size,
+                mode,
+            } => {
+                let src = self.resolve(&mode, size)?;
+                let src = self.read(src, size);
+                let src = self.extend_word(size, src);
+                let reg = Reg::a(addr_reg as usize);
+                let dst = self.get(reg);
+                let op = if matches!(inst.kind, InstructionKind::Adda { .. }) {
+                    AluOp::Add
+                } else {
+                    AluOp::Sub
+                };
+                let result = self.alu(op, dst, src);
+                self.set(reg, Size::Long, result);
+            }
+            InstructionKind::Cmp(EaToDn { size, dst, src }) => {
+                let src = self.resolve(&src, size)?;
+                let src = self.read(src, size);
+                let dst = self.get(Reg::d(dst as usize));
+                self.add_or_sub(false, size, src, dst, FLAGS_CMP);
+            }
+            InstructionKind::Cmpa {
+                addr_reg,
+                size,
+                src,
+            } => {
+                let src = self.resolve(&src, size)?;
+                let src = self.read(src, size);
+                let src = self.extend_word(size, src);
+                let dst = self.get(Reg::a(addr_reg as usize));
+                self.add_or_sub(false, Size::Long, src, dst, FLAGS_CMP);
+            }
+            InstructionKind::Cmpi(ImmOp { imm, size, mode }) => {
+                let loc = self.resolve(&mode, size)?;
+                let dst = self.read(loc, size);
+                self.add_or_sub(false, size, Val::Const(imm_to_u32(imm)), dst, FLAGS_CMP);
+            }
+            InstructionKind::And(And::EaToDn(EaToDn { size, dst, src }))
+            | InstructionKind::Or(Or::EaToDn(EaToDn { size, dst, src })) => {
+                let op = if matches!(inst.kind, InstructionKind::And(_)) {
+                    AluOp::And
+                } else {
+                    AluOp::Or
+                };
+                let src = self.resolve(&src, size)?;
+                let src = self.read(src, size);
+                let reg = Reg::d(dst as usize);
+                let dst = self.get(reg);
+                let result = self.alu(op, src, dst);
+                self.set(reg, size, result);
+                self.logic_flags(size, result);
+            }
+            InstructionKind::And(And::DnToEa(DnToEa { size, src, dst }))
+            | InstructionKind::Or(Or::DnToEa(DnToEa { size, src, dst }))
+            | InstructionKind::Eor(DnToEa { size, src, dst }) => {
+                let op = match inst.kind {
+                    InstructionKind::And(_) => AluOp::And,
+                    InstructionKind::Or(_) => AluOp::Or,
+                    _ => AluOp::Xor,
+                };
+                let src = self.get(Reg::d(src as usize));
+                let loc = self.resolve_dst(&dst, size)?;
+                let dst = self.read(loc, size);
+                let result = self.alu(op, src, dst);
+                self.write(loc, size, result)?;
+                self.logic_flags(size, result);
+            }
+            InstructionKind::Andi(ImmOp { imm, size, mode })
+            | InstructionKind::Ori(ImmOp { imm, size, mode })
+            | InstructionKind::Eori(ImmOp { imm, size, mode }) => {
+                let op = match inst.kind {
+                    InstructionKind::Andi(_) => AluOp::And,
+                    InstructionKind::Ori(_) => AluOp::Or,
+                    _ => AluOp::Xor,
+                };
+                let loc = self.resolve_dst(&mode, size)?;
+                let dst = self.read(loc, size);
+                let result = self.alu(op, Val::Const(imm_to_u32(imm)), dst);
+                self.write(loc, size, result)?;
+                self.logic_flags(size, result);
+            }
+            InstructionKind::Mulu { src, dst } | InstructionKind::Muls { src, dst } => {
+                if matches!(src.ea, EffectiveAddress::Ar(_)) {
+                    return None;
+                }
+                let extend = if matches!(inst.kind, InstructionKind::Mulu { .. }) {
+                    UnaryOp::Zext16
+                } else {
+                    UnaryOp::Sext16
+                };
+                let src = self.resolve(&src, Size::Word)?;
+                let src = self.read(src, Size::Word);
+                let src = self.unary(extend, src);
+                let reg = Reg::d(dst as usize);
+                let dst = self.get(reg);
+                let dst = self.unary(extend, dst);
+                let result = self.alu(AluOp::Mul, dst, src);
+                self.set(reg, Size::Long, result);
+                self.logic_flags(Size::Long, result);
+            }
+            InstructionKind::Lsd(Shift::Reg(shift)) | InstructionKind::Asd(Shift::Reg(shift)) => {
+                let ShiftCount::Immediate(count) = shift.count else {
+                    return None;
+                };
+                let count = if count == 0 { 8 } else { count as u32 };
+                let arithmetic = matches!(inst.kind, InstructionKind::Asd(_));
+                let reg = Reg::d(shift.dst as usize);
+                let value = self.get(reg);
+                let (result, kind) = match shift.direction {
+                    RightOrLeft::Left => (
+                        self.alu(AluOp::Shl, value, Val::Const(count)),
+                        FlagKind::ShiftLeft,
+                    ),
+                    RightOrLeft::Right => {
+                        let (extend, op) = match (arithmetic, shift.size) {
+                            (false, Size::Byte) => (Some(UnaryOp::Zext8), AluOp::Shr),
+                            (false, Size::Word) => (Some(UnaryOp::Zext16), AluOp::Shr),
+                            (false, Size::Long) => (None, AluOp::Shr),
+                            (true, Size::Byte) => (Some(UnaryOp::Sext8), AluOp::Sar),
+                            (true, Size::Word) => (Some(UnaryOp::Sext16), AluOp::Sar),
+                            (true, Size::Long) => (None, AluOp::Sar),
+                        };
+                        let value = match extend {
+                            Some(extend) => self.unary(extend, value),
+                            None => value,
+                        };
+                        (self.alu(op, value, Val::Const(count)), FlagKind::ShiftRight)
+                    }
+                };
+                self.set(reg, shift.size, result);
+                // ASL leaves V clear, matching the interpreter.
+                self.flags(
+                    kind,
+                    shift.size,
+                    FLAGS_ARITH,
+                    value,
+                    Val::Const(count),
+                    result,
+                );
+            }
+            InstructionKind::Scc { condition, mode } => {
+                let dst = self.resolve_dst(&mode, Size::Byte)?;
+                let value = self.temp();
+                self.ops.push(Op::Cond {
+                    dst: value,
+                    cond: condition,
+                });
+                self.write(dst, Size::Byte, Val::Temp(value))?;
+            }
+            InstructionKind::Exg(exg) => {
+                let (rx, ry) = match exg {
+                    Exg::DataData { rx, ry } => (Reg::d(rx as usize), Reg::d(ry as usize)),
+                    Exg::AddrAddr { rx, ry } => (Reg::a(rx as usize), Reg::a(ry as usize)),
+                    Exg::DataAddr { data, addr } => (Reg::d(data as usize), Reg::a(addr as usize)),
+                };
+                let x = self.get(rx);
+                let y = self.get(ry);
+                self.set(rx, Size::Long, y);
+                self.set(ry, Size::Long, x);
+            }
+            InstructionKind::Movem(movem) => self.movem(movem)?,
+            InstructionKind::Link {
+                addr_reg,
+                displacement,
+            } => {
+                let reg = Reg::a(addr_reg as usize);
+                let old = self.get(reg);
+                let sp = self.push(old);
+                self.set(reg, Size::Long, sp);
+                let sp = self.alu(AluOp::Add, sp, Val::Const(displacement as i32 as u32));
+                self.set(Reg::a(7), Size::Long, sp);
+            }
+            InstructionKind::Unlk { addr_reg } => {
+                let reg = Reg::a(addr_reg as usize);
+                let frame = self.get(reg);
+                self.set(Reg::a(7), Size::Long, frame);
+                let saved = self.load(Size::Long, frame, 0);
+                let sp = self.alu(AluOp::Add, frame, Val::Const(4));
+                self.set(Reg::a(7), Size::Long, sp);
+                self.set(reg, Size::Long, saved);
+            }
+            InstructionKind::Bra { displacement } => {
+                self.exit(ExitTest::Always, branch_target(displacement));
+                return Some(true);
+            }
+            InstructionKind::Bcc {
+                condition,
+                displacement,
+            } => {
+                self.exit(ExitTest::Cond(condition), branch_target(displacement));
+                return Some(true);
+            }
+            InstructionKind::DBcc {
+                condition,
+                data_reg,
+                displacement,
+            } => {
+                self.exit(ExitTest::Cond(condition), next);
+                let reg = Reg::d(data_reg as usize);
+                let value = self.get(reg);
+                let count = self.alu(AluOp::Sub, value, Val::Const(1));
+                self.set(reg, Size::Word, count);
+                self.exit(
+                    ExitTest::NotEqual {
+                        val: count,
+                        mask: 0xffff,
+                        imm: 0xffff,
+                    },
+                    branch_target(displacement as i32),
+                );
+                return Some(true);
+            }
+            InstructionKind::Bsr { displacement } => {
+                self.push(next);
+                self.exit(ExitTest::Always, branch_target(displacement));
+                return Some(true);
+            }
+            InstructionKind::Jsr { mode } => {
+                let (addr, offset) = self.ea_address(&mode)?;
+                let target = self.offset_addr(addr, offset);
+                self.push(next);
+                self.exit(ExitTest::Always, target);
+                return Some(true);
+            }
+            InstructionKind::Jmp { mode } => {
+                let (addr, offset) = self.ea_address(&mode)?;
+                let target = self.offset_addr(addr, offset);
+                self.exit(ExitTest::Always, target);
+                return Some(true);
+            }
+            InstructionKind::Rts => {
+                let sp = self.get(Reg::a(7));
+                let target = self.load(Size::Long, sp, 0);
+                let sp = self.alu(AluOp::Add, sp, Val::Const(4));
+                self.set(Reg::a(7), Size::Long, sp);
+                self.exit(ExitTest::Always, target);
+                return Some(true);
+            }
+            _ => return None,
+        }
+        Some(false)
+    }
+
+    fn movem(&mut self, movem: Movem) -> Option<()> {
+        let step = if movem.size == Size::Word { 2 } else { 4 };
+        match (movem.direction, movem.mode.ea) {
+            (DataDir::RegToMem, EffectiveAddress::AddrPreDecr(areg)) => {
+                // Predecrement masks are reversed: bit 0 is A7, bit 15 is D0.
+                let areg = Reg::a(areg as usize);
+                let base = self.get(areg);
+                let mut offset = 0;
+                for bit in 0..16 {
+                    if movem.register_mask & (1 << bit) != 0 {
+                        offset -= step;
+                        let value = self.get(Reg(15 - bit as u8));
+                        self.store(movem.size, base, offset, value);
+                    }
+                }
+                let end = self.alu(AluOp::Add, base, Val::Const(offset as u32));
+                self.set(areg, Size::Long, end);
+            }
+            (DataDir::RegToMem, EffectiveAddress::AddrPostIncr(_)) => return None,
+            (DataDir::RegToMem, _) => {
+                let (base, mut offset) = self.ea_address(&movem.mode)?;
+                for bit in 0..16 {
+                    if movem.register_mask & (1 << bit) != 0 {
+                        let value = self.get(Reg(bit as u8));
+                        self.store(movem.size, base, offset, value);
+                        offset += step;
+                    }
+                }
+            }
+            (DataDir::MemToReg, EffectiveAddress::AddrPreDecr(_)) => return None,
+            (DataDir::MemToReg, ea) => {
+                let (base, start) = self.ea_address(&movem.mode)?;
+                let mut offset = start;
+                for bit in 0..16 {
+                    if movem.register_mask & (1 << bit) != 0 {
+                        let value = self.load(movem.size, base, offset);
+                        let value = self.extend_word(movem.size, value);
+                        self.set(Reg(bit as u8), Size::Long, value);
+                        offset += step;
+                    }
+                }
+                if let EffectiveAddress::AddrPostIncr(areg) = ea {
+                    let end = self.alu(AluOp::Add, base, Val::Const((offset - start) as u32));
+                    self.set(Reg::a(areg as usize), Size::Long, end);
+                }
+            }
+        }
+        Some(())
+    }
+
+    /// Resolve a destination operand. PC-relative and immediate modes are not
+    /// writable, so those are left to the interpreter to reject.
+    fn resolve_dst(&mut self, mode: &AddressingMode, size: Size) -> Option<Loc> {
+        match mode.ea {
+            EffectiveAddress::PCDisplace
+            | EffectiveAddress::PCIndex
+            | EffectiveAddress::Immediate => None,
+            _ => self.resolve(mode, size),
+        }
+    }
+
+    /// Resolve `mode` for an access of `size`, applying (An)+ and -(An).
+    fn resolve(&mut self, mode: &AddressingMode, size: Size) -> Option<Loc> {
+        Some(match mode.resolved {
+            ResolvedEa::Dn(reg) => Loc::D(reg as usize),
+            ResolvedEa::An(reg) => Loc::A(reg as usize),
+            ResolvedEa::Imm(value) => Loc::Imm(value),
+            ResolvedEa::PostInc(reg) => {
+                let step = Val::Const(Cpu::ea_step(size, reg == 7));
+                let areg = Reg::a(reg as usize);
+                let addr = self.get(areg);
+                let next = self.alu(AluOp::Add, addr, step);
+                self.set(areg, Size::Long, next);
+                Loc::Mem { addr, offset: 0 }
+            }
+            ResolvedEa::PreDec(reg) => {
+                let step = Val::Const(Cpu::ea_step(size, reg == 7));
+                let areg = Reg::a(reg as usize);
+                let addr = self.get(areg);
+                let addr = self.alu(AluOp::Sub, addr, step);
+                self.set(areg, Size::Long, addr);
+                Loc::Mem { addr, offset: 0 }
+            }
+            _ => {
+                let (addr, offset) = self.ea_address(mode)?;
+                Loc::Mem { addr, offset }
+            }
+        })
+    }
+
+    /// Address of a memory operand as `base + offset`, without side effects
+    /// other than the pointer load of memory-indirect modes.
+    fn ea_address(&mut self, mode: &AddressingMode) -> Option<(Val, i32)> {
+        Some(match mode.resolved {
+            ResolvedEa::Ind(reg) | ResolvedEa::PostInc(reg) | ResolvedEa::PreDec(reg) => {
+                (self.get(Reg::a(reg as usize)), 0)
+            }
+            ResolvedEa::DispAn { reg, disp } => (self.get(Reg::a(reg as usize)), disp),
+            ResolvedEa::Index { base, index, disp } => (self.indexed(base, index), disp as i32),
+            ResolvedEa::MemIndirectPre {
+                base,
+                index,
+                disp,
+                outer,
+            } => {
+                let addr = self.indexed(base, index);
+                let ptr = self.load(Size::Long, addr, disp as i32);
+                (ptr, outer as i32)
+            }
+            ResolvedEa::MemIndirectPost {
+                base,
+                index,
+                disp,
+                outer,
+            } => {
+                let addr = self.indexed(base, None);
+                let ptr = self.load(Size::Long, addr, disp as i32);
+                (self.indexed_from(ptr, index), outer as i32)
+            }
+            ResolvedEa::Abs(addr) => (Val::Const(addr), 0),
+            _ => return None,
+        })
+    }
+
+    /// `base + index`, with a missing base or index contributing zero.
+    fn indexed(&mut self, base: Option<u8>, index: Option<IndexReg>) -> Val {
+        let base = match base {
+            Some(reg) => self.get(Reg::a(reg as usize)),
+            None => Val::Const(0),
+        };
+        self.indexed_from(base, index)
+    }
+
+    fn indexed_from(&mut self, base: Val, index: Option<IndexReg>) -> Val {
+        let Some(index) = index else {
+            return base;
+        };
+        let reg = if index.reg >= 8 {
+            Reg::a(index.reg as usize - 8)
+        } else {
+            Reg::d(index.reg as usize)
+        };
+        let mut value = self.get(reg);
+        if !index.long {
+            value = self.unary(UnaryOp::Sext16, value);
+        }
+        if index.shift != 0 {
+            value = self.alu(AluOp::Shl, value, Val::Const(index.shift as u32));
+        }
+        self.alu(AluOp::Add, base, value)
+    }
+
+    fn read(&mut self, loc: Loc, size: Size) -> Val {
+        match loc {
+            Loc::D(n) => self.get(Reg::d(n)),
+            Loc::A(n) => self.get(Reg::a(n)),
+            Loc::Imm(value) => Val::Const(value),
+            Loc::Mem { addr, offset } => self.load(size, addr, offset),
+        }
+    }
+
+    fn write(&mut self, loc: Loc, size: Size, value: Val) -> Option<()> {
+        match loc {
+            Loc::D(n) => self.set(Reg::d(n), size, value),
+            Loc::Mem { addr, offset } => self.store(size, addr, offset, value),
+            Loc::A(_) | Loc::Imm(_) => return None,
+        }
+        Some(())
+    }
+
+    /// Push a long onto the stack, returning the new stack pointer.
+    fn push(&mut self, value: Val) -> Val {
+        let sp = self.get(Reg::a(7));
+        let sp = self.alu(AluOp::Sub, sp, Val::Const(4));
+        self.set(Reg::a(7), Size::Long, sp);
+        self.store(Size::Long, sp, 0, value);
+        sp
+    }
+
+    /// ADD/SUB (or CMP when `mask` excludes X) with the interpreter's operand
+    /// order: `dst + src` or `dst - src`.
+    fn add_or_sub(&mut self, is_add: bool, size: Size, src: Val, dst: Val, mask: u16) -> Val {
+        if is_add {
+            let result = self.alu(AluOp::Add, src, dst);
+            self.flags(FlagKind::Add, size, mask, src, dst, result);
+            result
+        } else {
+            let result = self.alu(AluOp::Sub, dst, src);
+            self.flags(FlagKind::Sub, size, mask, dst, src, result);
+            result
+        }
+    }
+
+    fn extend_word(&mut self, size: Size, value: Val) -> Val {
+        if size == Size::Word {
+            self.unary(UnaryOp::Sext16, value)
+        } else {
+            value
+        }
+    }
+
+    fn offset_addr(&mut self, addr: Val, offset: i32) -> Val {
+        if offset == 0 {
+            addr
+        } else {
+            self.alu(AluOp::Add, addr, Val::Const(offset as u32))
+        }
+    }
+
+    fn temp(&mut self) -> Temp {
+        let temp = Temp(self.temps);
+        self.temps += 1;
+        temp
+    }
+
+    fn get(&mut self, reg: Reg) -> Val {
+        let dst = self.temp();
+        self.ops.push(Op::Get { dst, reg });
+        Val::Temp(dst)
+    }
+
+    fn set(&mut self, reg: Reg, size: Size, src: Val) {
+        self.ops.push(Op::Set { reg, size, src });
+    }
+
+    fn alu(&mut self, op: AluOp, a: Val, b: Val) -> Val {
+        let dst = self.temp();
+        self.ops.push(Op::Alu { dst, op, a, b });
+        Val::Temp(dst)
+    }
+
+    fn unary(&mut self, op: UnaryOp, src: Val) -> Val {
+        let dst = self.temp();
+        self.ops.push(Op::Unary { dst, op, src });
+        Val::Temp(dst)
+    }
+
+    fn load(&mut self, size: Size, addr: Val, offset: i32) -> Val {
+        let dst = self.temp();
+        self.ops.push(Op::Load {
+            dst,
+            size,
+            addr,
+            offset,
+        });
+        Val::Temp(dst)
+    }
+
+    fn store(&mut self, size: Size, addr: Val, offset: i32, src: Val) {
+        self.ops.push(Op::Store {
+            size,
+            addr,
+            offset,
+            src,
+        });
+    }
+
+    fn flags(&mut self, kind: FlagKind, size: Size, mask: u16, a: Val, b: Val, res: Val) {
+        self.ops.push(Op::Flags {
+            kind,
+            size,
+            mask,
+            a,
+            b,
+            res,
+        });
+    }
+
+    fn logic_flags(&mut self, size: Size, res: Val) {
+        let zero = Val::Const(0);
+        self.flags(FlagKind::Logic, size, FLAGS_LOGIC, zero, zero, res);
+    }
+}
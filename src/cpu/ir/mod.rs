@@ -0,0 +1,281 @@
+// Micro-op IR for straight-line guest code. A block of decoded m68k
+// instructions is lowered into register get/set, loads, stores, ALU ops and
+// explicit flag updates over virtual temporaries. The passes in `opt` only see
+// this form and `exec` interprets it; a native backend should consume the same
+// optimized ops so optimizations are written once.
+
+mod exec;
+mod lower;
+mod opt;
+
+use anyhow::Result;
+
+use super::translate::{BranchBias, Layout, Translate, branch_layout};
+use crate::decoder::{Condition, Decoder, Instruction, Size};
+
+/// Upper bound on guest instructions lowered into one block.
+const MAX_BLOCK_INSTS: usize = 64;
+
+/// Virtual register. Every temp is assigned exactly once per block.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) struct Temp(pub(super) u16);
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum Val {
+    Temp(Temp),
+    Const(u32),
+}
+
+/// Guest register: D0-D7 are 0-7, A0-A7 are 8-15.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) struct Reg(pub(super) u8);
+
+impl Reg {
+    pub(super) fn d(n: usize) -> Self {
+        Reg(n as u8)
+    }
+
+    pub(super) fn a(n: usize) -> Self {
+        Reg(8 + n as u8)
+    }
+
+    pub(super) fn is_addr(self) -> bool {
+        self.0 >= 8
+    }
+
+    fn bit(self) -> u16 {
+        1 << self.0
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum AluOp {
+    Add,
+    Sub,
+    And,
+    Or,
+    Xor,
+    Shl,
+    Shr,
+    Sar,
+    Mul,
+    Rotl,
+}
+
+impl AluOp {
+    fn is_commutative(self) -> bool {
+        matches!(
+            self,
+            AluOp::Add | AluOp::And | AluOp::Or | AluOp::Xor | AluOp::Mul
+        )
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum UnaryOp {
+    Not,
+    Neg,
+    Sext8,
+    Sext16,
+    Zext8,
+    Zext16,
+}
+
+/// How a `Flags` op derives the condition codes from its operands.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum FlagKind {
+    /// `a + b`; carry and overflow as for ADD.
+    Add,
+    /// `a - b`; carry and overflow as for SUB/CMP.
+    Sub,
+    /// N/Z from the result, V and C cleared.
+    Logic,
+    /// Shift of `a` left by `b`; C is the last bit shifted out.
+    ShiftLeft,
+    /// Shift of `a` right by `b`; C is the last bit shifted out.
+    ShiftRight,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(super) enum ExitTest {
+    Always,
+    Cond(Condition),
+    /// Taken when `val & mask != imm`.
+    NotEqual {
+        val: Val,
+        mask: u32,
+        imm: u32,
+    },
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(super) enum Op {
+    /// Start of guest instruction `insts[n]`, used for error reporting.
+    Mark(u16),
+    Get {
+        dst: Temp,
+        reg: Reg,
+    },
+    /// Write `src` into the low `size` bytes of a data register, or all of
+    /// an address register.
+    Set {
+        reg: Reg,
+        size: Size,
+        src: Val,
+    },
+    Alu {
+        dst: Temp,
+        op: AluOp,
+        a: Val,
+        b: Val,
+    },
+    Unary {
+        dst: Temp,
+        op: UnaryOp,
+        src: Val,
+    },
+    /// Zero-extended load from `addr + offset`.
+    Load {
+        dst: Temp,
+        size: Size,
+        addr: Val,
+        offset: i32,
+    },
+    Store {
+        size: Size,
+        addr: Val,
+        offset: i32,
+        src: Val,
+    },
+    /// Update the SR bits in `mask` from a sized operation.
+    Flags {
+        kind: FlagKind,
+        size: Size,
+        mask: u16,
+        a: Val,
+        b: Val,
+        res: Val,
+    },
+    /// 0xff if `cond` holds, else 0.
+    Cond {
+        dst: Temp,
+        cond: Condition,
+    },
+    /// Leave the block with PC set to `target` when `test` holds.
+    Exit {
+        test: ExitTest,
+        target: Val,
+    },
+    /// Run `insts[n]` through the reference interpreter.
+    Fallback(u16),
+}
+
+impl Op {
+    pub(super) fn for_each_use(&mut self, mut f: impl FnMut(&mut Val)) {
+        match self {
+            Op::Set { src, .. } | Op::Unary { src, .. } => f(src),
+            Op::Alu { a, b, .. } => {
+                f(a);
+                f(b);
+            }
+            Op::Load { addr, .. } => f(addr),
+            Op::Store { addr, src, .. } => {
+                f(addr);
+                f(src);
+            }
+            Op::Flags { a, b, res, .. } => {
+                f(a);
+                f(b);
+                f(res);
+            }
+            Op::Exit { test, target } => {
+                if let ExitTest::NotEqual { val, .. } = test {
+                    f(val);
+                }
+                f(target);
+            }
+            Op::Mark(_) | Op::Get { .. } | Op::Cond { .. } | Op::Fallback(_) => {}
+        }
+    }
+}
+
+/// A lowered and optimized run of guest instructions.
+pub(super) struct IrBlock {
+    pub(super) insts: Vec<Instruction>,
+    pub(super) ops: Vec<Op>,
+    pub(super) temps: usize,
+}
+
+impl IrBlock {
+    /// Decode from `start` until a control transfer, a decode failure or the
+    /// block size limit, then lower and optimize the result. Biased
+    /// conditional branches become side exits and the block continues along
+    /// their usual side.
+    pub(super) fn build(decoder: &Decoder, bias: &BranchBias, start: usize) -> Result<Self> {
+        let mut builder = lower::Builder::default();
+        let mut insts = Vec::new();
+        let mut pc = start;
+        loop {
+            let inst = match decoder.decode_instruction(pc) {
+                Ok(inst) => inst,
+                // Let the failure surface when execution actually reaches it.
+                Err(_) if !insts.is_empty() => break,
+                Err(e) => return Err(e),
+            };
+            pc = inst.address + inst.len();
+            let index = insts.len() as u16;
+            let ends_block = match branch_layout(bias, &inst) {
+                Some(Layout::FallThrough) => {
+                    builder.lower(&inst, index);
+                    false
+                }
+                Some(Layout::Taken(target)) => {
+                    builder.branch_taken(&inst, index, pc);
+                    pc = target;
+                    false
+                }
+                None => builder.lower(&inst, index),
+            };
+            insts.push(inst);
+            if ends_block || insts.len() >= MAX_BLOCK_INSTS {
+                break;
+            }
+        }
+        builder.exit(ExitTest::Always, Val::Const(pc as u32));
+
+        let temps = builder.temps as usize;
+        let ops = opt::optimize(builder.ops, temps);
+        Ok(Self { insts, ops, temps })
+    }
+}
+
+impl Translate for IrBlock {
+    fn translate(decoder: &Decoder, bias: &BranchBias, start: usize) -> Result<Self> {
+        Self::build(decoder, bias, start)
+    }
+
+    fn insts(&self) -> &[Instruction] {
+        &self.insts
+    }
+
+    fn footprint(&self) -> usize {
+        std::mem::size_of::<Self>()
+            + self.insts.iter().map(Translate::footprint).sum::<usize>()
+            + self.ops.capacity() * std::mem::size_of::<Op>()
+    }
+}
+
+/// SR bits read by `cond`.
+pub(super) fn condition_flags(cond: Condition) -> u16 {
+    use super::m68020::{FLAG_C, FLAG_N, FLAG_V, FLAG_Z};
+    match cond {
+        Condition::True | Condition::False => 0,
+        Condition::Higher | Condition::LowerOrSame => FLAG_C | FLAG_Z,
+        Condition::CarryClear | Condition::CarrySet => FLAG_C,
+        Condition::NotEqual | Condition::Equal => FLAG_Z,
+        Condition::OverflowClear | Condition::OverflowSet => FLAG_V,
+        Condition::Plus | Condition::Minus => FLAG_N,
+        Condition::GreaterOrEqual | Condition::LessThan => FLAG_N | FLAG_V,
+        Condition::GreaterThan | Condition::LessOrEqual => FLAG_N | FLAG_V | FLAG_Z,
+    }
+}
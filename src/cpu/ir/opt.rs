@@ -0,0 +1,273 @@
+use super::{AluOp, Op, Temp, UnaryOp, Val, condition_flags};
+use crate::{
+    cpu::m68020::{FLAG_C, FLAG_N, FLAG_V, FLAG_X, FLAG_Z},
+    decoder::Size,
+};
+
+const ALL_FLAGS: u16 = FLAG_N | FLAG_Z | FLAG_V | FLAG_C | FLAG_X;
+const ALL_REGS: u16 = 0xffff;
+
+/// Run the block passes: a forward pass for register forwarding, constant
+/// and effective-address folding and redundant-load removal, then a backward
+/// pass for dead flag, dead register write and dead temp elimination.
+/// Postincrement updates merge as a result: chained `An + step` values fold
+/// into one add, loads through them become `An + offset`, and the
+/// intermediate register writes die.
+pub(super) fn optimize(ops: Vec<Op>, temps: usize) -> Vec<Op> {
+    let ops = forward(ops, temps);
+    backward(ops, temps)
+}
+
+/// A memory value known to be available without reloading it.
+struct Available {
+    addr: Val,
+    offset: i32,
+    size: Size,
+    value: Val,
+}
+
+fn forward(ops: Vec<Op>, temps: usize) -> Vec<Op> {
+    // Replacement for temps whose defining op was removed.
+    let mut subst: Vec<Option<Val>> = vec![None; temps];
+    // `t = base + const` definitions, for reassociation and address folding.
+    let mut sums: Vec<Option<(Val, u32)>> = vec![None; temps];
+    // Current full value of each guest register, when known.
+    let mut regs: [Option<Val>; 16] = [None; 16];
+    let mut memory: Vec<Available> = Vec::new();
+    let mut out = Vec::with_capacity(ops.len());
+
+    for mut op in ops {
+        op.for_each_use(|v| {
+            if let Val::Temp(Temp(t)) = *v
+                && let Some(replacement) = subst[t as usize]
+            {
+                *v = replacement;
+            }
+        });
+
+        match &mut op {
+            Op::Get { dst, reg } => {
+                if let Some(value) = regs[reg.0 as usize] {
+                    subst[dst.0 as usize] = Some(value);
+                    continue;
+                }
+                regs[reg.0 as usize] = Some(Val::Temp(*dst));
+            }
+            Op::Set { reg, size, src } => {
+                regs[reg.0 as usize] = if reg.is_addr() || *size == Size::Long {
+                    Some(*src)
+                } else {
+                    None
+                };
+            }
+            Op::Alu { dst, op: alu, a, b } => {
+                if alu.is_commutative() && matches!(a, Val::Const(_)) {
+                    std::mem::swap(a, b);
+                }
+                if *alu == AluOp::Sub
+                    && let Val::Const(c) = *b
+                {
+                    *alu = AluOp::Add;
+                    *b = Val::Const(c.wrapping_neg());
+                }
+                if let (Val::Const(x), Val::Const(y)) = (*a, *b) {
+                    subst[dst.0 as usize] = Some(Val::Const(fold_alu(*alu, x, y)));
+                    continue;
+                }
+                if *alu == AluOp::Add
+                    && let (Val::Temp(base), Val::Const(c)) = (*a, *b)
+                {
+                    if c == 0 {
+                        subst[dst.0 as usize] = Some(*a);
+                        continue;
+                    }
+                    let (base, c) = match sums[base.0 as usize] {
+                        Some((inner, c0)) => (inner, c0.wrapping_add(c)),
+                        None => (*a, c),
+                    };
+                    *a = base;
+                    *b = Val::Const(c);
+                    sums[dst.0 as usize] = Some((base, c));
+                }
+            }
+            Op::Unary {
+                dst,
+                op: unary,
+                src,
+            } => {
+                if let Val::Const(x) = *src {
+                    subst[dst.0 as usize] = Some(Val::Const(fold_unary(*unary, x)));
+                    continue;
+                }
+            }
+            Op::Load {
+                dst,
+                size,
+                addr,
+                offset,
+            } => {
+                fold_address(&sums, addr, offset);
+                if let Some(hit) = memory
+                    .iter()
+                    .find(|m| m.addr == *addr && m.offset == *offset && m.size == *size)
+                {
+                    subst[dst.0 as usize] = Some(hit.value);
+                    continue;
+                }
+                memory.push(Available {
+                    addr: *addr,
+                    offset: *offset,
+                    size: *size,
+                    value: Val::Temp(*dst),
+                });
+            }
+            Op::Store {
+                size,
+                addr,
+                offset,
+                src,
+            } => {
+                fold_address(&sums, addr, offset);
+                let (addr, offset, size) = (*addr, *offset, *size);
+                memory.retain(|m| disjoint(m.addr, m.offset, m.size, addr, offset, size));
+                // Narrow stores would need the loaded value zero-extended, so
+                // only forward full longs.
+                if size == Size::Long {
+                    memory.push(Available {
+                        addr,
+                        offset,
+                        size,
+                        value: *src,
+                    });
+                }
+            }
+            Op::Fallback(_) => {
+                regs = [None; 16];
+                memory.clear();
+            }
+            Op::Mark(_) | Op::Flags { .. } | Op::Cond { .. } | Op::Exit { .. } => {}
+        }
+        out.push(op);
+    }
+    out
+}
+
+/// Fold `base + const` and constant bases into the access offset.
+fn fold_address(sums: &[Option<(Val, u32)>], addr: &mut Val, offset: &mut i32) {
+    if let Val::Temp(t) = *addr
+        && let Some((base, c)) = sums[t.0 as usize]
+    {
+        *addr = base;
+        *offset = offset.wrapping_add(c as i32);
+    }
+    if let Val::Const(c) = *addr {
+        *addr = Val::Const(c.wrapping_add(*offset as u32));
+        *offset = 0;
+    }
+}
+
+fn size_bytes(size: Size) -> i64 {
+    match size {
+        Size::Byte => 1,
+        Size::Word => 2,
+        Size::Long => 4,
+    }
+}
+
+/// Whether two accesses provably do not overlap.
+fn disjoint(a: Val, a_off: i32, a_size: Size, b: Val, b_off: i32, b_size: Size) -> bool {
+    let (a_start, b_start) = match (a, b) {
+        (Val::Const(x), Val::Const(y)) => (x as i64, y as i64),
+        _ if a == b => (a_off as i64, b_off as i64),
+        _ => return false,
+    };
+    a_start + size_bytes(a_size) <= b_start || b_start + size_bytes(b_size) <= a_start
+}
+
+fn backward(ops: Vec<Op>, temps: usize) -> Vec<Op> {
+    let mut used = vec![false; temps];
+    let mut live_flags = ALL_FLAGS;
+    let mut live_regs = ALL_REGS;
+    let mut out = Vec::with_capacity(ops.len());
+
+    for mut op in ops.into_iter().rev() {
+        match &mut op {
+            Op::Mark(_) | Op::Store { .. } | Op::Load { .. } => {}
+            Op::Exit { .. } | Op::Fallback(_) => {
+                // State must be fully materialized when leaving the block or
+                // handing an instruction to the interpreter.
+                live_flags = ALL_FLAGS;
+                live_regs = ALL_REGS;
+            }
+            Op::Flags { mask, .. } => {
+                let written = *mask;
+                *mask &= live_flags;
+                if *mask == 0 {
+                    continue;
+                }
+                live_flags &= !written;
+            }
+            Op::Cond { dst, cond } => {
+                if !used[dst.0 as usize] {
+                    continue;
+                }
+                live_flags |= condition_flags(*cond);
+            }
+            Op::Set { reg, size, .. } => {
+                if live_regs & reg.bit() == 0 {
+                    continue;
+                }
+                // A partial write merges with the old value, which therefore
+                // stays live.
+                if reg.is_addr() || *size == Size::Long {
+                    live_regs &= !reg.bit();
+                }
+            }
+            Op::Get { dst, reg } => {
+                if !used[dst.0 as usize] {
+                    continue;
+                }
+                live_regs |= reg.bit();
+            }
+            Op::Alu { dst, .. } | Op::Unary { dst, .. } => {
+                if !used[dst.0 as usize] {
+                    continue;
+                }
+            }
+        }
+        op.for_each_use(|v| {
+            if let Val::Temp(t) = *v {
+                used[t.0 as usize] = true;
+            }
+        });
+        out.push(op);
+    }
+    out.reverse();
+    out
+}
+
+pub(super) fn fold_alu(op: AluOp, a: u32, b: u32) -> u32 {
+    match op {
+        AluOp::Add => a.wrapping_add(b),
+        AluOp::Sub => a.wrapping_sub(b),
+        AluOp::And => a & b,
+        AluOp::Or => a | b,
+        AluOp::Xor => a ^ b,
+        AluOp::Shl => a.checked_shl(b).unwrap_or(0),
+        AluOp::Shr => a.checked_shr(b).unwrap_or(0),
+        AluOp::Sar => ((a as i32) >> b.min(31)) as u32,
+        AluOp::Mul => a.wrapping_mul(b),
+        AluOp::Rotl => a.rotate_left(b),
+    }
+}
+
+pub(super) fn fold_unary(op: UnaryOp, a: u32) -> u32 {
+    match op {
+        UnaryOp::Not => !a,
+        UnaryOp::Neg => a.wrapping_neg(),
+        UnaryOp::Sext8 => a as i8 as i32 as u32,
+        UnaryOp::Sext16 => a as i16 as i32 as u32,
+        UnaryOp::Zext8 => a & 0xff,
+        UnaryOp::Zext16 => a & 0xffff,
+    }
+}
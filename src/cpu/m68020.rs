@@ -1,16 +1,42 @@
-use std::collections::BTreeMap;
+use std::{
+    collections::{BTreeMap, HashMap},
+    ffi::{CString, OsStr},
+    ops::Range,
+    os::unix::ffi::OsStrExt,
+    path::Path,
+    sync::Arc,
+};
 
-use super::{M68K_TLS_TCB_SIZE, align_up};
-use anyhow::{Result, anyhow, bail};
+use super::{
+    ExecTier, M68K_TLS_TCB_SIZE, align_up,
+    metrics::Metrics,
+    output::OutputBuffer,
+    perfmap::PerfMap,
+    pgo::{BlockProfile, ProfileHints},
+    profile::Profiler,
+    replay::SyscallLog,
+    syscall::MsgArena,
+    syscall_stats::SyscallStats,
+    translate::{CacheStats, CodeCache, StaleCode},
+};
+use anyhow::{Context, Result, anyhow, bail};
+use goblin::{
+    Object,
+    elf::{Elf, program_header},
+};
 
 use crate::{
     decoder::{
         Abcd, Add, AddrReg, AddressingMode, Addx, And, BitFieldParam, BitOp, Condition, DataDir,
-        DataReg, Decoder, DnToEa, EaToDn, EffectiveAddress, Exg, ExtMode, ImmOp, Immediate,
-        Instruction, InstructionKind, Movem, Or, QuickOp, RightOrLeft, Sbcd, Shift, ShiftCount,
-        Size, Sub, Subx, UnaryOp,
+        DataReg, DnToEa, EaToDn, EffectiveAddress, Exg, ExtMode, ImmOp, Immediate, IndexReg,
+        Instruction, InstructionKind, Movem, Or, QuickOp, ResolvedEa, RightOrLeft, Sbcd, Shift,
+        ShiftCount, Size, Sub, Subx, UnaryOp,
     },
-    memory::MemoryImage,
+    loader::{ElfFile, load_interpreter},
+    memory::{HostWindow, MemoryImage},
+    options::Options,
+    symbols::Symbols,
+    trace::TraceWriter,
 };
 
 /// ELF information needed for auxiliary vector setup
@@ -22,6 +48,41 @@ pub struct ElfInfo {
     pub phnum: u32,      // Number of program headers
     pub tls_vaddr: Option<u32>,
     pub tls_memsz: u32,
+    /// PT_INTERP of a dynamically linked program, as a guest path.
+    pub interp: Option<String>,
+    pub symbols: Arc<Symbols>,
+}
+
+impl ElfInfo {
+    /// Auxiliary vector inputs of `elf`, from one pass over its program
+    /// headers.
+    pub fn from_elf(elf: &Elf) -> Self {
+        let mut first_load = None;
+        let mut tls = None;
+        let mut phdr = None;
+        for ph in &elf.program_headers {
+            match ph.p_type {
+                program_header::PT_LOAD if first_load.is_none() => first_load = Some(ph),
+                program_header::PT_TLS if tls.is_none() => tls = Some(ph),
+                program_header::PT_PHDR => phdr = Some(ph.p_vaddr),
+                _ => {}
+            }
+        }
+        // Program headers are at file offset e_phoff, which maps to
+        // vaddr + e_phoff when the first PT_LOAD starts at offset 0.
+        // Dynamically linked programs say where with PT_PHDR.
+        let first_load_vaddr = first_load.map_or(0x80000000, |ph| ph.p_vaddr);
+        Self {
+            entry_point: elf.entry as u32,
+            phdr_addr: phdr.unwrap_or(first_load_vaddr + elf.header.e_phoff) as u32,
+            phent_size: elf.header.e_phentsize as u32,
+            phnum: elf.header.e_phnum as u32,
+            tls_vaddr: tls.map(|ph| ph.p_vaddr as u32),
+            tls_memsz: tls.map_or(0, |ph| ph.p_memsz as u32),
+            interp: elf.interpreter.map(str::to_string),
+            symbols: Arc::new(Symbols::from_elf(elf)),
+        }
+    }
 }
 
 pub struct Cpu {
@@ -39,10 +100,65 @@ pub struct Cpu {
     pub(super) heap_segment_base: usize,
     pub(super) stack_base: usize,
     pub(super) exe_path: String, // Path to the m68k executable being run
+    pub(super) options: Options,
+    /// Code ranges changed by syscalls, applied to the code cache by the run
+    /// loop before the next block.
+    pub(super) stale_code: Vec<StaleCode>,
+    pub(super) code_cache_stats: Option<Arc<CacheStats>>,
+    /// Host view of the segment A7 points into, so stack traffic skips the
+    /// segment lookup in `MemoryImage`.
+    pub(super) stack: HostWindow,
+    /// Guest instructions and syscalls executed, for `--exec-stats`.
+    pub(super) executed: u64,
+    pub(super) syscalls: u64,
+    /// Cheap counters read by `--metrics`: blocks run, guest accesses that
+    /// missed the stack window, window re-fetches and anonymous mmap bytes.
+    pub(super) blocks_entered: u64,
+    pub(super) slow_lookups: u64,
+    pub(super) window_refills: u64,
+    pub(super) mmap_bytes: u64,
+    pub(super) metrics: Option<Box<Metrics>>,
+    /// `--profile-out` collection, and `--profile-in` hints waiting for the
+    /// run loop to build its code cache.
+    pub(super) block_profile: Option<Box<BlockProfile>>,
+    pub(super) profile_hints: Option<Box<ProfileHints>>,
+    /// Per-syscall counts and host latency for `--syscall-summary`.
+    pub(super) syscall_stats: Option<Box<SyscallStats>>,
+    #[cfg(feature = "stats")]
+    pub(super) inst_stats: Option<Box<super::stats::InstStats>>,
+    /// Guest function names for the loaded image.
+    pub(super) symbols: Arc<Symbols>,
+    pub(super) profiler: Option<Profiler>,
+    pub(super) perf_map: Option<PerfMap>,
+    /// Binary execution trace for `--trace`, and the process it belongs to.
+    pub(super) trace: Option<Box<TraceWriter>>,
+    pub(super) trace_pid: u32,
+    /// Syscall log for `--record` / `--replay`.
+    pub(super) syscall_log: Option<Box<SyscallLog>>,
+    /// Value of `executed` at which the run loop calls `profile_tick`;
+    /// `u64::MAX` when not profiling.
+    pub(super) sample_at: u64,
+    /// Guest pc at which the run loop writes the `--snapshot` file, or
+    /// `usize::MAX`; set by the snapshot hypercall to write it after the
+    /// current block instead.
+    pub(super) snapshot_at: usize,
+    pub(super) snapshot_requested: bool,
+    /// `--sysroot` lookups by guest path and whether a final symlink is
+    /// followed: the host path, or `None` to use the guest path as is.
+    pub(super) sysroot_cache: HashMap<(CString, bool), Option<CString>>,
+    /// Coalesced guest stdout/stderr for `--buffer-output`.
+    pub(super) output: Option<Box<OutputBuffer>>,
+    /// Host copies of recvmmsg/sendmmsg arguments, reused between calls.
+    pub(super) msg_arena: MsgArena,
 }
 
 impl Cpu {
-    pub fn new(memory: MemoryImage, elf_info: &ElfInfo, args: &[String]) -> Result<Self> {
+    pub fn new(
+        memory: MemoryImage,
+        elf_info: &ElfInfo,
+        args: &[String],
+        options: Options,
+    ) -> Result<Self> {
         let mut memory = memory;
 
         // Identify stack segment (highest-address segment we added in the loader)
@@ -91,38 +207,136 @@ impl Cpu {
         }
 
         let mut cpu = Self {
-            data_regs: [0; 8],
-            addr_regs: [0; 8],
-            sr: 0,
             pc: elf_info.entry_point as usize,
-            memory,
-            halted: false,
             tls_base: tls_base as u32,
-            tls_initialized: false,
             tls_memsz: elf_info.tls_memsz as usize,
             brk: brk_base,
             brk_base,
             heap_segment_base,
             stack_base,
             exe_path: args.first().map(|s| s.to_string()).unwrap_or_default(),
+            ..Self::with_memory(memory, options, Arc::clone(&elf_info.symbols))
         };
+        let interp_base = cpu.load_interpreter(elf_info)?;
+        cpu.start_tools()?;
 
         if tls_base != 0 {
             cpu.ensure_tls_range(tls_base)?;
         }
 
         // Set up the initial stack with argc/argv/envp
-        cpu.setup_initial_stack(args, elf_info)?;
+        cpu.setup_initial_stack(args, elf_info, interp_base)?;
 
         Ok(cpu)
     }
 
+    /// A CPU over `memory` with zeroed registers and bookkeeping and no
+    /// tools running, for `new` and `restore` to fill in.
+    pub(super) fn with_memory(
+        memory: MemoryImage,
+        options: Options,
+        symbols: Arc<Symbols>,
+    ) -> Self {
+        Self {
+            data_regs: [0; 8],
+            addr_regs: [0; 8],
+            sr: 0,
+            pc: 0,
+            memory,
+            halted: false,
+            tls_base: 0,
+            tls_initialized: false,
+            tls_memsz: 0,
+            brk: 0,
+            brk_base: 0,
+            heap_segment_base: 0,
+            stack_base: 0,
+            exe_path: String::new(),
+            options,
+            stale_code: Vec::new(),
+            code_cache_stats: None,
+            stack: HostWindow::default(),
+            executed: 0,
+            syscalls: 0,
+            blocks_entered: 0,
+            slow_lookups: 0,
+            window_refills: 0,
+            mmap_bytes: 0,
+            metrics: None,
+            block_profile: None,
+            profile_hints: None,
+            syscall_stats: None,
+            #[cfg(feature = "stats")]
+            inst_stats: None,
+            symbols,
+            profiler: None,
+            sample_at: u64::MAX,
+            perf_map: None,
+            trace: None,
+            trace_pid: 0,
+            syscall_log: None,
+            snapshot_at: usize::MAX,
+            snapshot_requested: false,
+            sysroot_cache: HashMap::new(),
+            output: None,
+            msg_arena: MsgArena::default(),
+        }
+    }
+
+    /// Start the tracing, profiling and statistics requested on the command
+    /// line. Called once the pc and image bookkeeping are in place.
+    pub(super) fn start_tools(&mut self) -> Result<()> {
+        if self.options.perf_map {
+            self.perf_map = Some(PerfMap::new()?);
+        }
+        self.start_profiler();
+        self.start_trace()?;
+        self.start_syscall_log()?;
+        self.start_metrics();
+        self.start_block_profile()?;
+        self.start_predecode();
+        self.start_snapshot()?;
+        self.start_output_buffer();
+        if self.options.syscall_summary {
+            self.syscall_stats = Some(Box::new(SyscallStats::new()));
+        }
+        #[cfg(feature = "stats")]
+        if self.options.inst_stats || self.options.inst_stats_json.is_some() {
+            self.inst_stats = Some(Box::default());
+        }
+        Ok(())
+    }
+
+    /// Map the dynamic loader of a dynamically linked program from
+    /// `--sysroot` and start there rather than at the program's entry
+    /// point. Returns the loader's base address for AT_BASE, or 0 for a
+    /// static program.
+    pub(super) fn load_interpreter(&mut self, elf_info: &ElfInfo) -> Result<u32> {
+        let Some(interp) = &elf_info.interp else {
+            return Ok(0);
+        };
+        let guest_path = CString::new(interp.as_str())?;
+        let host_path = self.sysroot_path(&guest_path, true);
+        let host_path = Path::new(OsStr::from_bytes(host_path.to_bytes()));
+        let data = ElfFile::open(host_path).with_context(|| {
+            format!("loading the dynamic loader {interp}; does --sysroot point at an m68k root?")
+        })?;
+        let Object::Elf(elf) = Object::parse(&data)? else {
+            bail!("{}: not an ELF file", host_path.display());
+        };
+        let (base, entry) = load_interpreter(&elf, &data, &mut self.memory)
+            .with_context(|| format!("loading {}", host_path.display()))?;
+        self.pc = entry;
+        Ok(base as u32)
+    }
+
     /// Set up the initial stack with argc/argv/envp and auxiliary vector
     /// This can be called both during initialization and for execve
     pub(super) fn setup_initial_stack(
         &mut self,
         args: &[String],
         elf_info: &ElfInfo,
+        interp_base: u32,
     ) -> Result<()> {
         // Find stack segment
         let stack_top = self.stack_base
@@ -197,7 +411,7 @@ impl Cpu {
             (11, 1000),                // AT_UID - real user ID
             (9, elf_info.entry_point), // AT_ENTRY - entry point
             (8, 0),                    // AT_FLAGS - flags
-            (7, 0),                    // AT_BASE - base addr of interpreter (0 for static)
+            (7, interp_base),          // AT_BASE - base addr of interpreter (0 for static)
             (6, 4096),                 // AT_PAGESZ - page size
             (5, elf_info.phnum),       // AT_PHNUM - number of program headers
             (4, elf_info.phent_size),  // AT_PHENT - size of program header entry
@@ -271,72 +485,146 @@ impl Cpu {
 
     /// Run with on-the-fly instruction decoding
     pub fn run_jit(&mut self) -> Result<()> {
-        let decoder = Decoder::new(self.memory.clone());
-        let mut instruction_cache: BTreeMap<usize, Instruction> = BTreeMap::new();
+        let result = match self.options.tier {
+            ExecTier::Interpreter => self.run_interpreter(),
+            ExecTier::Threaded => self.run_threaded(),
+            ExecTier::Ir => self.run_ir(),
+        };
+        self.report_exit_stats();
+        result
+    }
+
+    fn run_interpreter(&mut self) -> Result<()> {
+        let mut instruction_cache: CodeCache<Instruction> = self.code_cache();
 
         let mut last_pc = 0usize;
         let mut last_inst_kind: Option<String> = None;
         while !self.halted {
             let pc = self.pc;
+            let inst = instruction_cache.get(pc)?;
 
-            // Check cache first, decode if not found
-            let inst = if let Some(inst) = instruction_cache.get(&pc) {
-                inst.clone()
-            } else {
-                let inst = decoder.decode_instruction(pc)?;
-                instruction_cache.insert(pc, inst.clone());
-                inst
-            };
-
-            if let Err(e) = self.execute(&inst) {
+            if let Err(e) = self.enter_block(pc, |cpu| cpu.execute(inst)) {
                 eprintln!("FAILED at PC={:#010x}: {:?}", pc, inst.kind);
                 eprintln!("  Last: PC={:#x} {:?}", last_pc, last_inst_kind);
                 eprintln!("Error: {:?}", e);
-                eprintln!(
-                    "  D: {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x}",
-                    self.data_regs[0],
-                    self.data_regs[1],
-                    self.data_regs[2],
-                    self.data_regs[3],
-                    self.data_regs[4],
-                    self.data_regs[5],
-                    self.data_regs[6],
-                    self.data_regs[7]
-                );
-                eprintln!(
-                    "  A: {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x}",
-                    self.addr_regs[0],
-                    self.addr_regs[1],
-                    self.addr_regs[2],
-                    self.addr_regs[3],
-                    self.addr_regs[4],
-                    self.addr_regs[5],
-                    self.addr_regs[6],
-                    self.addr_regs[7]
-                );
+                self.dump_registers();
                 return Err(e);
             }
+            self.executed += 1;
+            self.profile_edges(std::slice::from_ref(inst));
+            if self.executed >= self.sample_at {
+                self.profile_tick();
+            }
+            #[cfg(feature = "stats")]
+            self.record_insts(std::slice::from_ref(inst));
             last_pc = pc;
             last_inst_kind = Some(format!("{:?}", inst.kind));
+            if !self.stale_code.is_empty() {
+                instruction_cache.invalidate(&mut self.stale_code, &self.memory);
+            }
+            if self.pc == self.snapshot_at || self.snapshot_requested {
+                self.save_snapshot(instruction_cache.entries());
+            }
         }
 
         Ok(())
     }
 
-    fn execute(&mut self, instruction: &Instruction) -> Result<()> {
+    /// Drop translations of guest code in `range` before the next block
+    /// runs. `reload` also refreshes the decoder's copy of guest memory.
+    pub(super) fn invalidate_code(&mut self, range: Range<usize>, reload: bool) {
+        self.stale_code.push(StaleCode { range, reload });
+    }
+
+    /// Count a run of instructions that just executed for `--inst-stats`.
+    #[cfg(feature = "stats")]
+    #[inline]
+    pub(super) fn record_insts(&mut self, insts: &[Instruction]) {
+        if let Some(stats) = &mut self.inst_stats {
+            stats.record(insts, self.pc);
+        }
+    }
+
+    /// Print the statistics requested on the command line. Called on every
+    /// way out of the guest, including the exit syscalls.
+    pub(super) fn report_exit_stats(&mut self) {
+        self.flush_output();
+        self.finish_profiler();
+        self.finish_trace();
+        self.finish_syscall_log();
+        self.dump_metrics();
+        self.save_block_profile();
+        if let Some(map) = &self.perf_map
+            && let Err(e) = map.write()
+        {
+            eprintln!("{e:#}");
+        }
+        #[cfg(feature = "stats")]
+        if let Some(stats) = &self.inst_stats {
+            if self.options.inst_stats {
+                stats.report();
+            }
+            if let Some(path) = &self.options.inst_stats_json
+                && let Err(e) = stats.write_json(path)
+            {
+                eprintln!("{e:#}");
+            }
+        }
+        if self.options.exec_stats {
+            eprintln!(
+                "executed: {} instructions, {} syscalls",
+                self.executed, self.syscalls
+            );
+        }
+        if let Some(stats) = &self.syscall_stats {
+            stats.report();
+        }
+        if self.options.code_cache_stats
+            && let Some(stats) = &self.code_cache_stats
+        {
+            stats.report();
+        }
+    }
+
+    pub(super) fn dump_registers(&self) {
+        eprintln!(
+            "  D: {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x}",
+            self.data_regs[0],
+            self.data_regs[1],
+            self.data_regs[2],
+            self.data_regs[3],
+            self.data_regs[4],
+            self.data_regs[5],
+            self.data_regs[6],
+            self.data_regs[7]
+        );
+        eprintln!(
+            "  A: {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x} {:08x}",
+            self.addr_regs[0],
+            self.addr_regs[1],
+            self.addr_regs[2],
+            self.addr_regs[3],
+            self.addr_regs[4],
+            self.addr_regs[5],
+            self.addr_regs[6],
+            self.addr_regs[7]
+        );
+    }
+
+    pub(super) fn execute(&mut self, instruction: &Instruction) -> Result<()> {
         match instruction.kind {
             InstructionKind::Nop => {}
             InstructionKind::Addq(op) => {
-                self.exec_addq(instruction, op)?;
+                self.exec_addq(op)?;
             }
             InstructionKind::Moveq { data, dst } => {
                 self.exec_moveq(data, dst)?;
             }
             InstructionKind::Move { size, src, dst } => {
-                self.exec_move(instruction, size, src, dst)?;
+                self.exec_move(size, src, dst)?;
             }
             InstructionKind::Lea { src, dst } => {
-                self.exec_lea(instruction, src, dst)?;
+                self.exec_lea(src, dst)?;
             }
             InstructionKind::Mulu { src, dst } => {
                 self.exec_mulu(src, dst)?;
@@ -345,7 +633,11 @@ impl Cpu {
                 self.exec_muls(src, dst)?;
             }
             InstructionKind::Trap { vector } => {
+                let pc = self.pc;
                 self.exec_trap(vector)?;
+                if self.pc != pc {
+                    return Ok(()); // execve started a new image
+                }
             }
             InstructionKind::Trapcc {
                 condition,
@@ -364,22 +656,20 @@ impl Cpu {
             }
             InstructionKind::Rts => {
                 // Pop return address from stack and jump to it
-                let return_addr = self.memory.read_long(self.addr_regs[7] as usize)?;
-                self.addr_regs[7] = self.addr_regs[7].wrapping_add(4);
+                let return_addr = self.pop_long()?;
                 self.pc = return_addr as usize;
                 return Ok(()); // Don't advance PC normally
             }
             InstructionKind::Rtd { displacement } => {
                 // Pop return address from stack and jump to it
-                let return_addr = self.memory.read_long(self.addr_regs[7] as usize)?;
-                self.addr_regs[7] = self.addr_regs[7].wrapping_add(4);
+                let return_addr = self.pop_long()?;
                 // Add displacement to stack pointer
                 self.addr_regs[7] = self.addr_regs[7].wrapping_add(displacement as u32);
                 self.pc = return_addr as usize;
                 return Ok(()); // Don't advance PC normally
             }
             InstructionKind::Tst { size, mode } => {
-                self.exec_tst(instruction, size, mode)?;
+                self.exec_tst(size, mode)?;
             }
             InstructionKind::Bra { displacement } => {
                 // BRA doesn't advance PC normally - it jumps
@@ -397,48 +687,48 @@ impl Cpu {
                 // Fall through - didn't branch, advance PC normally
             }
             InstructionKind::Clr(op) => {
-                self.exec_clr(instruction, op)?;
+                self.exec_clr(op)?;
             }
             InstructionKind::Neg(op) => {
-                self.exec_neg(instruction, op)?;
+                self.exec_neg(op)?;
             }
             InstructionKind::Not(op) => {
-                self.exec_not(instruction, op)?;
+                self.exec_not(op)?;
             }
             InstructionKind::Negx(op) => {
-                self.exec_negx(instruction, op)?;
+                self.exec_negx(op)?;
             }
             InstructionKind::Add(add) => {
-                self.exec_add(instruction, add)?;
+                self.exec_add(add)?;
             }
             InstructionKind::Sub(sub) => {
-                self.exec_sub(instruction, sub)?;
+                self.exec_sub(sub)?;
             }
             InstructionKind::Cmp(ea_to_dn) => {
-                self.exec_cmp(instruction, ea_to_dn)?;
+                self.exec_cmp(ea_to_dn)?;
             }
             InstructionKind::Cmpa {
                 addr_reg,
                 size,
                 src,
             } => {
-                self.exec_cmpa(instruction, addr_reg, size, src)?;
+                self.exec_cmpa(addr_reg, size, src)?;
             }
             InstructionKind::And(and) => {
-                self.exec_and(instruction, and)?;
+                self.exec_and(and)?;
             }
             InstructionKind::Or(or) => {
-                self.exec_or(instruction, or)?;
+                self.exec_or(or)?;
             }
             InstructionKind::Eor(dn_to_ea) => {
-                self.exec_eor(instruction, dn_to_ea)?;
+                self.exec_eor(dn_to_ea)?;
             }
             InstructionKind::Jsr { mode } => {
                 self.exec_jsr(instruction, mode)?;
                 return Ok(()); // JSR sets PC directly
             }
             InstructionKind::Jmp { mode } => {
-                self.exec_jmp(instruction, mode)?;
+                self.exec_jmp(mode)?;
                 return Ok(()); // JMP sets PC directly
             }
             InstructionKind::Bsr { displacement } => {
@@ -446,24 +736,24 @@ impl Cpu {
                 return Ok(()); // BSR sets PC directly
             }
             InstructionKind::Subq(op) => {
-                self.exec_subq(instruction, op)?;
+                self.exec_subq(op)?;
             }
             InstructionKind::Adda {
                 addr_reg,
                 size,
                 mode,
             } => {
-                self.exec_adda(instruction, addr_reg, size, mode)?;
+                self.exec_adda(addr_reg, size, mode)?;
             }
             InstructionKind::Suba {
                 addr_reg,
                 size,
                 mode,
             } => {
-                self.exec_suba(instruction, addr_reg, size, mode)?;
+                self.exec_suba(addr_reg, size, mode)?;
             }
             InstructionKind::Movea { size, src, dst } => {
-                self.exec_movea(instruction, size, src, dst)?;
+                self.exec_movea(size, src, dst)?;
             }
             InstructionKind::Ext { data_reg, mode } => {
                 self.exec_ext(data_reg, mode)?;
@@ -472,7 +762,7 @@ impl Cpu {
                 self.exec_swap(data_reg)?;
             }
             InstructionKind::Pea { mode } => {
-                self.exec_pea(instruction, mode)?;
+                self.exec_pea(mode)?;
             }
             InstructionKind::Link {
                 addr_reg,
@@ -484,52 +774,52 @@ impl Cpu {
                 self.exec_unlk(addr_reg)?;
             }
             InstructionKind::Addi(imm_op) => {
-                self.exec_addi(instruction, imm_op)?;
+                self.exec_addi(imm_op)?;
             }
             InstructionKind::Subi(imm_op) => {
-                self.exec_subi(instruction, imm_op)?;
+                self.exec_subi(imm_op)?;
             }
             InstructionKind::Andi(imm_op) => {
-                self.exec_andi(instruction, imm_op)?;
+                self.exec_andi(imm_op)?;
             }
             InstructionKind::Ori(imm_op) => {
-                self.exec_ori(instruction, imm_op)?;
+                self.exec_ori(imm_op)?;
             }
             InstructionKind::Eori(imm_op) => {
-                self.exec_eori(instruction, imm_op)?;
+                self.exec_eori(imm_op)?;
             }
             InstructionKind::Cmpi(imm_op) => {
-                self.exec_cmpi(instruction, imm_op)?;
+                self.exec_cmpi(imm_op)?;
             }
             // Shift instructions
             InstructionKind::Asd(shift) => {
-                self.exec_asd(instruction, shift)?;
+                self.exec_asd(shift)?;
             }
             InstructionKind::Lsd(shift) => {
-                self.exec_lsd(instruction, shift)?;
+                self.exec_lsd(shift)?;
             }
             InstructionKind::Rod(shift) => {
-                self.exec_rod(instruction, shift)?;
+                self.exec_rod(shift)?;
             }
             InstructionKind::Roxd(shift) => {
-                self.exec_roxd(instruction, shift)?;
+                self.exec_roxd(shift)?;
             }
             // Bit operations
             InstructionKind::Btst(bit_op) => {
-                self.exec_btst(instruction, bit_op)?;
+                self.exec_btst(bit_op)?;
             }
             InstructionKind::Bchg(bit_op) => {
-                self.exec_bchg(instruction, bit_op)?;
+                self.exec_bchg(bit_op)?;
             }
             InstructionKind::Bclr(bit_op) => {
-                self.exec_bclr(instruction, bit_op)?;
+                self.exec_bclr(bit_op)?;
             }
             InstructionKind::Bset(bit_op) => {
-                self.exec_bset(instruction, bit_op)?;
+                self.exec_bset(bit_op)?;
             }
             // Conditional instructions
             InstructionKind::Scc { condition, mode } => {
-                self.exec_scc(instruction, condition, mode)?;
+                self.exec_scc(condition, mode)?;
             }
             InstructionKind::DBcc {
                 condition,
@@ -542,10 +832,10 @@ impl Cpu {
             }
             // Division
             InstructionKind::Divu { src, dst } => {
-                self.exec_divu(instruction, src, dst)?;
+                self.exec_divu(src, dst)?;
             }
             InstructionKind::Divs { src, dst } => {
-                self.exec_divs(instruction, src, dst)?;
+                self.exec_divs(src, dst)?;
             }
             InstructionKind::DivuL {
                 ref src,
@@ -553,7 +843,7 @@ impl Cpu {
                 dr,
                 is_64bit,
             } => {
-                self.exec_divul(instruction, src, dq, dr, is_64bit)?;
+                self.exec_divul(src, dq, dr, is_64bit)?;
             }
             InstructionKind::DivsL {
                 ref src,
@@ -561,13 +851,13 @@ impl Cpu {
                 dr,
                 is_64bit,
             } => {
-                self.exec_divsl(instruction, src, dq, dr, is_64bit)?;
+                self.exec_divsl(src, dq, dr, is_64bit)?;
             }
             InstructionKind::MuluL { ref src, dl, dh } => {
-                self.exec_mulul(instruction, src, dl, dh)?;
+                self.exec_mulul(src, dl, dh)?;
             }
             InstructionKind::MulsL { ref src, dl, dh } => {
-                self.exec_mulsl(instruction, src, dl, dh)?;
+                self.exec_mulsl(src, dl, dh)?;
             }
             InstructionKind::Cas {
                 size,
@@ -575,7 +865,7 @@ impl Cpu {
                 du,
                 ref mode,
             } => {
-                self.exec_cas(instruction, size, dc, du, mode)?;
+                self.exec_cas(size, dc, du, mode)?;
             }
             InstructionKind::Cas2 {
                 size,
@@ -593,14 +883,14 @@ impl Cpu {
                 ref mode,
                 reg,
             } => {
-                self.exec_cmp2(instruction, size, mode, reg)?;
+                self.exec_cmp2(size, mode, reg)?;
             }
             InstructionKind::Chk2 {
                 size,
                 ref mode,
                 reg,
             } => {
-                self.exec_chk2(instruction, size, mode, reg)?;
+                self.exec_chk2(size, mode, reg)?;
             }
             // Exchange and extended operations
             InstructionKind::Exg(exg) => {
@@ -621,7 +911,7 @@ impl Cpu {
             }
             // MOVEM
             InstructionKind::Movem(movem) => {
-                self.exec_movem(instruction, movem)?;
+                self.exec_movem(movem)?;
             }
             // Compare memory
             InstructionKind::Cmpm { size, src, dst } => {
@@ -629,7 +919,7 @@ impl Cpu {
             }
             // TAS - Test and Set
             InstructionKind::Tas { mode } => {
-                self.exec_tas(instruction, mode)?;
+                self.exec_tas(mode)?;
             }
             // CCR/SR operations
             InstructionKind::OriToCcr { imm } => {
@@ -644,28 +934,28 @@ impl Cpu {
                 offset,
                 width,
             } => {
-                self.exec_bftst(instruction, mode, offset, width)?;
+                self.exec_bftst(mode, offset, width)?;
             }
             InstructionKind::Bfchg {
                 ref mode,
                 offset,
                 width,
             } => {
-                self.exec_bfchg(instruction, mode, offset, width)?;
+                self.exec_bfchg(mode, offset, width)?;
             }
             InstructionKind::Bfclr {
                 ref mode,
                 offset,
                 width,
             } => {
-                self.exec_bfclr(instruction, mode, offset, width)?;
+                self.exec_bfclr(mode, offset, width)?;
             }
             InstructionKind::Bfset {
                 ref mode,
                 offset,
                 width,
             } => {
-                self.exec_bfset(instruction, mode, offset, width)?;
+                self.exec_bfset(mode, offset, width)?;
             }
             InstructionKind::Bfextu {
                 ref src,
@@ -673,7 +963,7 @@ impl Cpu {
                 offset,
                 width,
             } => {
-                self.exec_bfextu(instruction, src, dst, offset, width)?;
+                self.exec_bfextu(src, dst, offset, width)?;
             }
             InstructionKind::Bfexts {
                 ref src,
@@ -681,7 +971,7 @@ impl Cpu {
                 offset,
                 width,
             } => {
-                self.exec_bfexts(instruction, src, dst, offset, width)?;
+                self.exec_bfexts(src, dst, offset, width)?;
             }
             InstructionKind::Bfins {
                 src,
@@ -689,7 +979,7 @@ impl Cpu {
                 offset,
                 width,
             } => {
-                self.exec_bfins(instruction, src, dst, offset, width)?;
+                self.exec_bfins(src, dst, offset, width)?;
             }
             InstructionKind::Bfffo {
                 ref src,
@@ -697,11 +987,11 @@ impl Cpu {
                 offset,
                 width,
             } => {
-                self.exec_bfffo(instruction, src, dst, offset, width)?;
+                self.exec_bfffo(src, dst, offset, width)?;
             }
             InstructionKind::MoveToCcr { ref src } => {
                 // MOVE to CCR: source word -> CCR (low 8 bits of SR)
-                let value = self.read_operand(src, Size::Word, instruction.address)?;
+                let value = self.read_operand(src, Size::Word)?;
                 self.sr = (self.sr & 0xff00) | ((value as u16) & 0xff);
             }
             _ => bail!("execution for {:?} not yet implemented", instruction.kind),
@@ -715,7 +1005,7 @@ impl Cpu {
         self.pc = self.pc.saturating_add(bytes);
     }
 
-    fn exec_addq(&mut self, inst: &Instruction, op: QuickOp) -> Result<()> {
+    fn exec_addq(&mut self, op: QuickOp) -> Result<()> {
         let increment = if op.data == 0 { 8 } else { op.data as u32 };
         match op.mode.ea {
             EffectiveAddress::Dr(reg) => {
@@ -731,9 +1021,10 @@ impl Cpu {
             }
             _ => {
                 // Memory operands - read, add with flags, write back
-                let value = self.read_operand(&op.mode, op.size, inst.address)?;
+                let loc = self.locate_dst(&op.mode, op.size)?;
+                let value = self.read_loc(loc, op.size)?;
                 let result = add_with_flags(value, increment, op.size, self);
-                self.write_operand(&op.mode, op.size, inst.address, result)?;
+                self.write_loc(loc, op.size, result)?;
             }
         }
 
@@ -750,23 +1041,17 @@ impl Cpu {
         Ok(())
     }
 
-    fn exec_move(
-        &mut self,
-        inst: &Instruction,
-        size: Size,
-        src: AddressingMode,
-        dst: AddressingMode,
-    ) -> Result<()> {
-        let value = self.read_operand(&src, size, inst.address)?;
-        self.write_operand(&dst, size, inst.address, value)?;
+    fn exec_move(&mut self, size: Size, src: AddressingMode, dst: AddressingMode) -> Result<()> {
+        let value = self.read_operand(&src, size)?;
+        self.write_operand(&dst, size, value)?;
         self.update_nz_flags_sized(value, size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
         Ok(())
     }
 
-    fn exec_lea(&mut self, inst: &Instruction, src: AddressingMode, dst: AddrReg) -> Result<()> {
-        let addr = self.compute_effective_address(&src, inst.address)?;
+    fn exec_lea(&mut self, src: AddressingMode, dst: AddrReg) -> Result<()> {
+        let addr = self.compute_effective_address(&src)?;
         let idx = addr_reg_index(dst);
         self.addr_regs[idx] = addr as u32;
         Ok(())
@@ -796,8 +1081,8 @@ impl Cpu {
         Ok(())
     }
 
-    fn exec_tst(&mut self, inst: &Instruction, size: Size, mode: AddressingMode) -> Result<()> {
-        let value = self.read_operand(&mode, size, inst.address)?;
+    fn exec_tst(&mut self, size: Size, mode: AddressingMode) -> Result<()> {
+        let value = self.read_operand(&mode, size)?;
         // TST sets N and Z based on the operand, clears V and C
         self.update_nz_flags_sized(value, size);
         self.set_flag(FLAG_V, false);
@@ -823,7 +1108,7 @@ impl Cpu {
         }
     }
 
-    fn test_condition(&self, condition: Condition) -> bool {
+    pub(super) fn test_condition(&self, condition: Condition) -> bool {
         let n = self.get_flag(FLAG_N);
         let z = self.get_flag(FLAG_Z);
         let v = self.get_flag(FLAG_V);
@@ -853,7 +1138,7 @@ impl Cpu {
         (self.sr & mask) != 0
     }
 
-    fn update_nz_flags_sized(&mut self, value: u32, size: Size) {
+    pub(super) fn update_nz_flags_sized(&mut self, value: u32, size: Size) {
         let (is_zero, is_negative) = match size {
             Size::Byte => ((value & 0xFF) == 0, (value & 0x80) != 0),
             Size::Word => ((value & 0xFFFF) == 0, (value & 0x8000) != 0),
@@ -864,8 +1149,8 @@ impl Cpu {
     }
 
     // CLR - Clear an operand
-    fn exec_clr(&mut self, inst: &Instruction, op: UnaryOp) -> Result<()> {
-        self.write_operand(&op.mode, op.size, inst.address, 0)?;
+    fn exec_clr(&mut self, op: UnaryOp) -> Result<()> {
+        self.write_operand(&op.mode, op.size, 0)?;
         self.set_flag(FLAG_N, false);
         self.set_flag(FLAG_Z, true);
         self.set_flag(FLAG_V, false);
@@ -874,18 +1159,20 @@ impl Cpu {
     }
 
     // NEG - Negate (two's complement)
-    fn exec_neg(&mut self, inst: &Instruction, op: UnaryOp) -> Result<()> {
-        let value = self.read_operand(&op.mode, op.size, inst.address)?;
+    fn exec_neg(&mut self, op: UnaryOp) -> Result<()> {
+        let loc = self.locate_dst(&op.mode, op.size)?;
+        let value = self.read_loc(loc, op.size)?;
         let result = sub_with_flags(0, value, op.size, self);
-        self.write_operand(&op.mode, op.size, inst.address, result)?;
+        self.write_loc(loc, op.size, result)?;
         Ok(())
     }
 
     // NOT - Logical complement (one's complement)
-    fn exec_not(&mut self, inst: &Instruction, op: UnaryOp) -> Result<()> {
-        let value = self.read_operand(&op.mode, op.size, inst.address)?;
+    fn exec_not(&mut self, op: UnaryOp) -> Result<()> {
+        let loc = self.locate_dst(&op.mode, op.size)?;
+        let value = self.read_loc(loc, op.size)?;
         let result = !value;
-        self.write_operand(&op.mode, op.size, inst.address, result)?;
+        self.write_loc(loc, op.size, result)?;
         self.update_nz_flags_sized(result, op.size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
@@ -893,11 +1180,12 @@ impl Cpu {
     }
 
     // NEGX - Negate with extend
-    fn exec_negx(&mut self, inst: &Instruction, op: UnaryOp) -> Result<()> {
-        let value = self.read_operand(&op.mode, op.size, inst.address)?;
+    fn exec_negx(&mut self, op: UnaryOp) -> Result<()> {
+        let loc = self.locate_dst(&op.mode, op.size)?;
+        let value = self.read_loc(loc, op.size)?;
         let x = if self.get_flag(FLAG_X) { 1u32 } else { 0u32 };
         let result = (0u32).wrapping_sub(value).wrapping_sub(x);
-        self.write_operand(&op.mode, op.size, inst.address, result)?;
+        self.write_loc(loc, op.size, result)?;
         // NEGX sets flags like SUB but Z is only cleared, never set
         let masked = size_mask(result, op.size);
         if masked != 0 {
@@ -911,14 +1199,14 @@ impl Cpu {
     }
 
     // ADD - Add binary
-    fn exec_add(&mut self, inst: &Instruction, add: Add) -> Result<()> {
+    fn exec_add(&mut self, add: Add) -> Result<()> {
         match add {
             Add::EaToDn(EaToDn {
                 size,
                 dst: dst_1,
                 src: src_1,
             }) => {
-                let src = self.read_operand(&src_1, size, inst.address)?;
+                let src = self.read_operand(&src_1, size)?;
                 let dst_idx = data_reg_index(dst_1);
                 let dst = size_mask(self.data_regs[dst_idx], size);
                 let result = add_with_flags(src, dst, size, self);
@@ -932,23 +1220,24 @@ impl Cpu {
             }) => {
                 let src_idx = data_reg_index(src);
                 let src = size_mask(self.data_regs[src_idx], size);
-                let dst = self.read_operand(&dst_1, size, inst.address)?;
+                let loc = self.locate_dst(&dst_1, size)?;
+                let dst = self.read_loc(loc, size)?;
                 let result = add_with_flags(src, dst, size, self);
-                self.write_operand(&dst_1, size, inst.address, result)?;
+                self.write_loc(loc, size, result)?;
             }
         }
         Ok(())
     }
 
     // SUB - Subtract binary
-    fn exec_sub(&mut self, inst: &Instruction, sub: Sub) -> Result<()> {
+    fn exec_sub(&mut self, sub: Sub) -> Result<()> {
         match sub {
             Sub::EaToDn(EaToDn {
                 size,
                 dst: dst_1,
                 src: src_1,
             }) => {
-                let src = self.read_operand(&src_1, size, inst.address)?;
+                let src = self.read_operand(&src_1, size)?;
                 let dst_idx = data_reg_index(dst_1);
                 let dst = size_mask(self.data_regs[dst_idx], size);
                 let result = sub_with_flags(dst, src, size, self);
@@ -962,17 +1251,18 @@ impl Cpu {
             }) => {
                 let src_idx = data_reg_index(src_1);
                 let src = size_mask(self.data_regs[src_idx], size);
-                let dst = self.read_operand(&dst_1, size, inst.address)?;
+                let loc = self.locate_dst(&dst_1, size)?;
+                let dst = self.read_loc(loc, size)?;
                 let result = sub_with_flags(dst, src, size, self);
-                self.write_operand(&dst_1, size, inst.address, result)?;
+                self.write_loc(loc, size, result)?;
             }
         }
         Ok(())
     }
 
     // CMP - Compare
-    fn exec_cmp(&mut self, inst: &Instruction, ea_to_dn: EaToDn) -> Result<()> {
-        let src = self.read_operand(&ea_to_dn.src, ea_to_dn.size, inst.address)?;
+    fn exec_cmp(&mut self, ea_to_dn: EaToDn) -> Result<()> {
+        let src = self.read_operand(&ea_to_dn.src, ea_to_dn.size)?;
         let dst_idx = data_reg_index(ea_to_dn.dst);
         let dst = size_mask(self.data_regs[dst_idx], ea_to_dn.size);
         // CMP is dst - src, sets flags but doesn't store result
@@ -981,14 +1271,8 @@ impl Cpu {
     }
 
     // CMPA - Compare Address
-    fn exec_cmpa(
-        &mut self,
-        inst: &Instruction,
-        addr_reg: AddrReg,
-        size: Size,
-        src: AddressingMode,
-    ) -> Result<()> {
-        let src_val = self.read_operand(&src, size, inst.address)?;
+    fn exec_cmpa(&mut self, addr_reg: AddrReg, size: Size, src: AddressingMode) -> Result<()> {
+        let src_val = self.read_operand(&src, size)?;
         // Sign-extend to 32 bits if word-sized
         let src_extended = if size == Size::Word {
             (src_val as i16) as i32 as u32
@@ -1001,14 +1285,14 @@ impl Cpu {
     }
 
     // AND - Logical AND
-    fn exec_and(&mut self, inst: &Instruction, and: And) -> Result<()> {
+    fn exec_and(&mut self, and: And) -> Result<()> {
         match and {
             And::EaToDn(EaToDn {
                 size,
                 dst: dst_1,
                 src: src_1,
             }) => {
-                let src = self.read_operand(&src_1, size, inst.address)?;
+                let src = self.read_operand(&src_1, size)?;
                 let dst_idx = data_reg_index(dst_1);
                 let dst = size_mask(self.data_regs[dst_idx], size);
                 let result = src & dst;
@@ -1025,9 +1309,10 @@ impl Cpu {
             }) => {
                 let src_idx = data_reg_index(src_1);
                 let src = size_mask(self.data_regs[src_idx], size);
-                let dst = self.read_operand(&dst_1, size, inst.address)?;
+                let loc = self.locate_dst(&dst_1, size)?;
+                let dst = self.read_loc(loc, size)?;
                 let result = src & dst;
-                self.write_operand(&dst_1, size, inst.address, result)?;
+                self.write_loc(loc, size, result)?;
                 self.update_nz_flags_sized(result, size);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, false);
@@ -1037,14 +1322,14 @@ impl Cpu {
     }
 
     // OR - Logical OR
-    fn exec_or(&mut self, inst: &Instruction, or: Or) -> Result<()> {
+    fn exec_or(&mut self, or: Or) -> Result<()> {
         match or {
             Or::EaToDn(EaToDn {
                 size,
                 dst: dst_1,
                 src: src_1,
             }) => {
-                let src = self.read_operand(&src_1, size, inst.address)?;
+                let src = self.read_operand(&src_1, size)?;
                 let dst_idx = data_reg_index(dst_1);
                 let dst = size_mask(self.data_regs[dst_idx], size);
                 let result = src | dst;
@@ -1061,9 +1346,10 @@ impl Cpu {
             }) => {
                 let src_idx = data_reg_index(src_1);
                 let src = size_mask(self.data_regs[src_idx], size);
-                let dst = self.read_operand(&dst_1, size, inst.address)?;
+                let loc = self.locate_dst(&dst_1, size)?;
+                let dst = self.read_loc(loc, size)?;
                 let result = src | dst;
-                self.write_operand(&dst_1, size, inst.address, result)?;
+                self.write_loc(loc, size, result)?;
                 self.update_nz_flags_sized(result, size);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, false);
@@ -1073,12 +1359,13 @@ impl Cpu {
     }
 
     // EOR - Exclusive OR
-    fn exec_eor(&mut self, inst: &Instruction, dn_to_ea: DnToEa) -> Result<()> {
+    fn exec_eor(&mut self, dn_to_ea: DnToEa) -> Result<()> {
         let src_idx = data_reg_index(dn_to_ea.src);
         let src = size_mask(self.data_regs[src_idx], dn_to_ea.size);
-        let dst = self.read_operand(&dn_to_ea.dst, dn_to_ea.size, inst.address)?;
+        let loc = self.locate_dst(&dn_to_ea.dst, dn_to_ea.size)?;
+        let dst = self.read_loc(loc, dn_to_ea.size)?;
         let result = src ^ dst;
-        self.write_operand(&dn_to_ea.dst, dn_to_ea.size, inst.address, result)?;
+        self.write_loc(loc, dn_to_ea.size, result)?;
         self.update_nz_flags_sized(result, dn_to_ea.size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
@@ -1087,7 +1374,7 @@ impl Cpu {
 
     // JSR - Jump to Subroutine
     fn exec_jsr(&mut self, inst: &Instruction, mode: AddressingMode) -> Result<()> {
-        let target = self.compute_effective_address(&mode, inst.address)?;
+        let target = self.compute_effective_address(&mode)?;
         // Push return address (PC after instruction) onto stack
         let return_addr = inst.address + inst.len();
         self.push_long(return_addr as u32)?;
@@ -1096,8 +1383,8 @@ impl Cpu {
     }
 
     // JMP - Jump
-    fn exec_jmp(&mut self, inst: &Instruction, mode: AddressingMode) -> Result<()> {
-        let target = self.compute_effective_address(&mode, inst.address)?;
+    fn exec_jmp(&mut self, mode: AddressingMode) -> Result<()> {
+        let target = self.compute_effective_address(&mode)?;
         self.pc = target;
         Ok(())
     }
@@ -1112,7 +1399,7 @@ impl Cpu {
     }
 
     // SUBQ - Subtract Quick
-    fn exec_subq(&mut self, inst: &Instruction, op: QuickOp) -> Result<()> {
+    fn exec_subq(&mut self, op: QuickOp) -> Result<()> {
         let decrement = if op.data == 0 { 8 } else { op.data as u32 };
         match op.mode.ea {
             EffectiveAddress::Dr(reg) => {
@@ -1128,23 +1415,18 @@ impl Cpu {
             }
             _ => {
                 // Memory operands - read, subtract with flags, write back
-                let value = self.read_operand(&op.mode, op.size, inst.address)?;
+                let loc = self.locate_dst(&op.mode, op.size)?;
+                let value = self.read_loc(loc, op.size)?;
                 let result = sub_with_flags(value, decrement, op.size, self);
-                self.write_operand(&op.mode, op.size, inst.address, result)?;
+                self.write_loc(loc, op.size, result)?;
             }
         }
         Ok(())
     }
 
     // ADDA - Add Address
-    fn exec_adda(
-        &mut self,
-        inst: &Instruction,
-        addr_reg: AddrReg,
-        size: Size,
-        mode: AddressingMode,
-    ) -> Result<()> {
-        let src = self.read_operand(&mode, size, inst.address)?;
+    fn exec_adda(&mut self, addr_reg: AddrReg, size: Size, mode: AddressingMode) -> Result<()> {
+        let src = self.read_operand(&mode, size)?;
         // Sign-extend to 32 bits if word-sized
         let src_extended = if size == Size::Word {
             (src as i16) as i32 as u32
@@ -1158,14 +1440,8 @@ impl Cpu {
     }
 
     // SUBA - Subtract Address
-    fn exec_suba(
-        &mut self,
-        inst: &Instruction,
-        addr_reg: AddrReg,
-        size: Size,
-        mode: AddressingMode,
-    ) -> Result<()> {
-        let src = self.read_operand(&mode, size, inst.address)?;
+    fn exec_suba(&mut self, addr_reg: AddrReg, size: Size, mode: AddressingMode) -> Result<()> {
+        let src = self.read_operand(&mode, size)?;
         // Sign-extend to 32 bits if word-sized
         let src_extended = if size == Size::Word {
             (src as i16) as i32 as u32
@@ -1179,14 +1455,8 @@ impl Cpu {
     }
 
     // MOVEA - Move Address
-    fn exec_movea(
-        &mut self,
-        inst: &Instruction,
-        size: Size,
-        src: AddressingMode,
-        dst: AddrReg,
-    ) -> Result<()> {
-        let value = self.read_operand(&src, size, inst.address)?;
+    fn exec_movea(&mut self, size: Size, src: AddressingMode, dst: AddrReg) -> Result<()> {
+        let value = self.read_operand(&src, size)?;
         // Sign-extend to 32 bits if word-sized
         let extended = if size == Size::Word {
             (value as i16) as i32 as u32
@@ -1242,8 +1512,8 @@ impl Cpu {
     }
 
     // PEA - Push Effective Address
-    fn exec_pea(&mut self, inst: &Instruction, mode: AddressingMode) -> Result<()> {
-        let addr = self.compute_effective_address(&mode, inst.address)?;
+    fn exec_pea(&mut self, mode: AddressingMode) -> Result<()> {
+        let addr = self.compute_effective_address(&mode)?;
         self.push_long(addr as u32)?;
         Ok(())
     }
@@ -1271,29 +1541,32 @@ impl Cpu {
     }
 
     // ADDI - Add Immediate
-    fn exec_addi(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_addi(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let loc = self.locate_dst(&imm_op.mode, imm_op.size)?;
+        let dst = self.read_loc(loc, imm_op.size)?;
         let result = add_with_flags(imm, dst, imm_op.size, self);
-        self.write_operand(&imm_op.mode, imm_op.size, inst.address, result)?;
+        self.write_loc(loc, imm_op.size, result)?;
         Ok(())
     }
 
     // SUBI - Subtract Immediate
-    fn exec_subi(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_subi(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let loc = self.locate_dst(&imm_op.mode, imm_op.size)?;
+        let dst = self.read_loc(loc, imm_op.size)?;
         let result = sub_with_flags(dst, imm, imm_op.size, self);
-        self.write_operand(&imm_op.mode, imm_op.size, inst.address, result)?;
+        self.write_loc(loc, imm_op.size, result)?;
         Ok(())
     }
 
     // ANDI - AND Immediate
-    fn exec_andi(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_andi(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let loc = self.locate_dst(&imm_op.mode, imm_op.size)?;
+        let dst = self.read_loc(loc, imm_op.size)?;
         let result = imm & dst;
-        self.write_operand(&imm_op.mode, imm_op.size, inst.address, result)?;
+        self.write_loc(loc, imm_op.size, result)?;
         self.update_nz_flags_sized(result, imm_op.size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
@@ -1301,11 +1574,12 @@ impl Cpu {
     }
 
     // ORI - OR Immediate
-    fn exec_ori(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_ori(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let loc = self.locate_dst(&imm_op.mode, imm_op.size)?;
+        let dst = self.read_loc(loc, imm_op.size)?;
         let result = imm | dst;
-        self.write_operand(&imm_op.mode, imm_op.size, inst.address, result)?;
+        self.write_loc(loc, imm_op.size, result)?;
         self.update_nz_flags_sized(result, imm_op.size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
@@ -1313,11 +1587,12 @@ impl Cpu {
     }
 
     // EORI - Exclusive OR Immediate
-    fn exec_eori(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_eori(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let loc = self.locate_dst(&imm_op.mode, imm_op.size)?;
+        let dst = self.read_loc(loc, imm_op.size)?;
         let result = imm ^ dst;
-        self.write_operand(&imm_op.mode, imm_op.size, inst.address, result)?;
+        self.write_loc(loc, imm_op.size, result)?;
         self.update_nz_flags_sized(result, imm_op.size);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
@@ -1325,15 +1600,15 @@ impl Cpu {
     }
 
     // CMPI - Compare Immediate
-    fn exec_cmpi(&mut self, inst: &Instruction, imm_op: ImmOp) -> Result<()> {
+    fn exec_cmpi(&mut self, imm_op: ImmOp) -> Result<()> {
         let imm = imm_to_u32(imm_op.imm);
-        let dst = self.read_operand(&imm_op.mode, imm_op.size, inst.address)?;
+        let dst = self.read_operand(&imm_op.mode, imm_op.size)?;
         cmp_with_flags(dst, imm, imm_op.size, self);
         Ok(())
     }
 
     // ASd - Arithmetic Shift
-    fn exec_asd(&mut self, inst: &Instruction, shift: Shift) -> Result<()> {
+    fn exec_asd(&mut self, shift: Shift) -> Result<()> {
         match shift {
             Shift::Reg(reg) => {
                 let count = match reg.count {
@@ -1358,11 +1633,10 @@ impl Cpu {
                 }
             }
             Shift::Ea(ea) => {
-                let addr = self.compute_effective_address(&ea.mode, inst.address)?;
-                let value = self.memory.read_word(addr)? as u32;
+                let loc = self.locate_dst(&ea.mode, Size::Word)?;
+                let value = self.read_loc(loc, Size::Word)?;
                 let (result, carry) = arithmetic_shift(value, 1, ea.direction, Size::Word);
-                self.memory
-                    .write_data(addr, &(result as u16).to_be_bytes())?;
+                self.write_loc(loc, Size::Word, result)?;
                 self.update_nz_flags_sized(result, Size::Word);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, carry);
@@ -1373,7 +1647,7 @@ impl Cpu {
     }
 
     // LSd - Logical Shift
-    fn exec_lsd(&mut self, inst: &Instruction, shift: Shift) -> Result<()> {
+    fn exec_lsd(&mut self, shift: Shift) -> Result<()> {
         match shift {
             Shift::Reg(reg) => {
                 let count = match reg.count {
@@ -1398,11 +1672,10 @@ impl Cpu {
                 }
             }
             Shift::Ea(ea) => {
-                let addr = self.compute_effective_address(&ea.mode, inst.address)?;
-                let value = self.memory.read_word(addr)? as u32;
+                let loc = self.locate_dst(&ea.mode, Size::Word)?;
+                let value = self.read_loc(loc, Size::Word)?;
                 let (result, carry) = logical_shift(value, 1, ea.direction, Size::Word);
-                self.memory
-                    .write_data(addr, &(result as u16).to_be_bytes())?;
+                self.write_loc(loc, Size::Word, result)?;
                 self.update_nz_flags_sized(result, Size::Word);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, carry);
@@ -1413,7 +1686,7 @@ impl Cpu {
     }
 
     // ROd - Rotate
-    fn exec_rod(&mut self, inst: &Instruction, shift: Shift) -> Result<()> {
+    fn exec_rod(&mut self, shift: Shift) -> Result<()> {
         match shift {
             Shift::Reg(reg) => {
                 let count = match reg.count {
@@ -1435,11 +1708,10 @@ impl Cpu {
                 self.set_flag(FLAG_C, carry);
             }
             Shift::Ea(ea) => {
-                let addr = self.compute_effective_address(&ea.mode, inst.address)?;
-                let value = self.memory.read_word(addr)? as u32;
+                let loc = self.locate_dst(&ea.mode, Size::Word)?;
+                let value = self.read_loc(loc, Size::Word)?;
                 let (result, carry) = rotate(value, 1, ea.direction, Size::Word);
-                self.memory
-                    .write_data(addr, &(result as u16).to_be_bytes())?;
+                self.write_loc(loc, Size::Word, result)?;
                 self.update_nz_flags_sized(result, Size::Word);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, carry);
@@ -1449,7 +1721,7 @@ impl Cpu {
     }
 
     // ROXd - Rotate with Extend
-    fn exec_roxd(&mut self, inst: &Instruction, shift: Shift) -> Result<()> {
+    fn exec_roxd(&mut self, shift: Shift) -> Result<()> {
         match shift {
             Shift::Reg(reg) => {
                 let count = match reg.count {
@@ -1473,12 +1745,11 @@ impl Cpu {
                 self.set_flag(FLAG_X, carry);
             }
             Shift::Ea(ea) => {
-                let addr = self.compute_effective_address(&ea.mode, inst.address)?;
-                let value = self.memory.read_word(addr)? as u32;
+                let loc = self.locate_dst(&ea.mode, Size::Word)?;
+                let value = self.read_loc(loc, Size::Word)?;
                 let x = self.get_flag(FLAG_X);
                 let (result, carry) = rotate_extended(value, 1, ea.direction, Size::Word, x);
-                self.memory
-                    .write_data(addr, &(result as u16).to_be_bytes())?;
+                self.write_loc(loc, Size::Word, result)?;
                 self.update_nz_flags_sized(result, Size::Word);
                 self.set_flag(FLAG_V, false);
                 self.set_flag(FLAG_C, carry);
@@ -1489,7 +1760,7 @@ impl Cpu {
     }
 
     // BTST - Bit Test
-    fn exec_btst(&mut self, inst: &Instruction, bit_op: BitOp) -> Result<()> {
+    fn exec_btst(&mut self, bit_op: BitOp) -> Result<()> {
         let (bit_num, mode) = match bit_op {
             BitOp::Imm(imm) => (imm.bit_num as u32, imm.mode),
             BitOp::Reg(reg) => (self.data_regs[data_reg_index(reg.bit_reg)], reg.mode),
@@ -1501,7 +1772,7 @@ impl Cpu {
             };
             (self.data_regs[idx], 32)
         } else {
-            (self.read_operand(&mode, Size::Byte, inst.address)?, 8)
+            (self.read_operand(&mode, Size::Byte)?, 8)
         };
         let bit = bit_num % modulo;
         let z = (value & (1 << bit)) == 0;
@@ -1510,7 +1781,7 @@ impl Cpu {
     }
 
     // BCHG - Bit Test and Change
-    fn exec_bchg(&mut self, inst: &Instruction, bit_op: BitOp) -> Result<()> {
+    fn exec_bchg(&mut self, bit_op: BitOp) -> Result<()> {
         let (bit_num, mode) = match bit_op {
             BitOp::Imm(imm) => (imm.bit_num as u32, imm.mode),
             BitOp::Reg(reg) => (self.data_regs[data_reg_index(reg.bit_reg)], reg.mode),
@@ -1522,17 +1793,18 @@ impl Cpu {
             self.set_flag(FLAG_Z, z);
             self.data_regs[idx] ^= 1 << bit;
         } else {
-            let value = self.read_operand(&mode, Size::Byte, inst.address)?;
+            let loc = self.locate_dst(&mode, Size::Byte)?;
+            let value = self.read_loc(loc, Size::Byte)?;
             let bit = bit_num % 8;
             let z = (value & (1 << bit)) == 0;
             self.set_flag(FLAG_Z, z);
-            self.write_operand(&mode, Size::Byte, inst.address, value ^ (1 << bit))?;
+            self.write_loc(loc, Size::Byte, value ^ (1 << bit))?;
         }
         Ok(())
     }
 
     // BCLR - Bit Test and Clear
-    fn exec_bclr(&mut self, inst: &Instruction, bit_op: BitOp) -> Result<()> {
+    fn exec_bclr(&mut self, bit_op: BitOp) -> Result<()> {
         let (bit_num, mode) = match bit_op {
             BitOp::Imm(imm) => (imm.bit_num as u32, imm.mode),
             BitOp::Reg(reg) => (self.data_regs[data_reg_index(reg.bit_reg)], reg.mode),
@@ -1544,17 +1816,18 @@ impl Cpu {
             self.set_flag(FLAG_Z, z);
             self.data_regs[idx] &= !(1 << bit);
         } else {
-            let value = self.read_operand(&mode, Size::Byte, inst.address)?;
+            let loc = self.locate_dst(&mode, Size::Byte)?;
+            let value = self.read_loc(loc, Size::Byte)?;
             let bit = bit_num % 8;
             let z = (value & (1 << bit)) == 0;
             self.set_flag(FLAG_Z, z);
-            self.write_operand(&mode, Size::Byte, inst.address, value & !(1 << bit))?;
+            self.write_loc(loc, Size::Byte, value & !(1 << bit))?;
         }
         Ok(())
     }
 
     // BSET - Bit Test and Set
-    fn exec_bset(&mut self, inst: &Instruction, bit_op: BitOp) -> Result<()> {
+    fn exec_bset(&mut self, bit_op: BitOp) -> Result<()> {
         let (bit_num, mode) = match bit_op {
             BitOp::Imm(imm) => (imm.bit_num as u32, imm.mode),
             BitOp::Reg(reg) => (self.data_regs[data_reg_index(reg.bit_reg)], reg.mode),
@@ -1566,28 +1839,24 @@ impl Cpu {
             self.set_flag(FLAG_Z, z);
             self.data_regs[idx] |= 1 << bit;
         } else {
-            let value = self.read_operand(&mode, Size::Byte, inst.address)?;
+            let loc = self.locate_dst(&mode, Size::Byte)?;
+            let value = self.read_loc(loc, Size::Byte)?;
             let bit = bit_num % 8;
             let z = (value & (1 << bit)) == 0;
             self.set_flag(FLAG_Z, z);
-            self.write_operand(&mode, Size::Byte, inst.address, value | (1 << bit))?;
+            self.write_loc(loc, Size::Byte, value | (1 << bit))?;
         }
         Ok(())
     }
 
     // Scc - Set on Condition
-    fn exec_scc(
-        &mut self,
-        inst: &Instruction,
-        condition: Condition,
-        mode: AddressingMode,
-    ) -> Result<()> {
+    fn exec_scc(&mut self, condition: Condition, mode: AddressingMode) -> Result<()> {
         let value = if self.test_condition(condition) {
             0xFF
         } else {
             0x00
         };
-        self.write_operand(&mode, Size::Byte, inst.address, value)?;
+        self.write_operand(&mode, Size::Byte, value)?;
         Ok(())
     }
 
@@ -1618,8 +1887,8 @@ impl Cpu {
     }
 
     // DIVU - Unsigned Divide
-    fn exec_divu(&mut self, inst: &Instruction, src: AddressingMode, dst: DataReg) -> Result<()> {
-        let divisor = self.read_operand(&src, Size::Word, inst.address)? as u16;
+    fn exec_divu(&mut self, src: AddressingMode, dst: DataReg) -> Result<()> {
+        let divisor = self.read_operand(&src, Size::Word)? as u16;
         if divisor == 0 {
             bail!("division by zero");
         }
@@ -1642,8 +1911,8 @@ impl Cpu {
     }
 
     // DIVS - Signed Divide
-    fn exec_divs(&mut self, inst: &Instruction, src: AddressingMode, dst: DataReg) -> Result<()> {
-        let divisor = self.read_operand(&src, Size::Word, inst.address)? as i16;
+    fn exec_divs(&mut self, src: AddressingMode, dst: DataReg) -> Result<()> {
+        let divisor = self.read_operand(&src, Size::Word)? as i16;
         if divisor == 0 {
             bail!("division by zero");
         }
@@ -1668,13 +1937,12 @@ impl Cpu {
     // DIVU.L - 32-bit unsigned divide (68020+)
     fn exec_divul(
         &mut self,
-        inst: &Instruction,
         src: &AddressingMode,
         dq: DataReg,
         dr: DataReg,
         is_64bit: bool,
     ) -> Result<()> {
-        let divisor = self.read_operand(src, Size::Long, inst.address)?;
+        let divisor = self.read_operand(src, Size::Long)?;
         if divisor == 0 {
             bail!("division by zero");
         }
@@ -1719,13 +1987,12 @@ impl Cpu {
     // DIVS.L - 32-bit signed divide (68020+)
     fn exec_divsl(
         &mut self,
-        inst: &Instruction,
         src: &AddressingMode,
         dq: DataReg,
         dr: DataReg,
         is_64bit: bool,
     ) -> Result<()> {
-        let divisor = self.read_operand(src, Size::Long, inst.address)? as i32;
+        let divisor = self.read_operand(src, Size::Long)? as i32;
         if divisor == 0 {
             bail!("division by zero");
         }
@@ -1769,14 +2036,8 @@ impl Cpu {
     }
 
     // MULU.L - 32-bit unsigned multiply (68020+)
-    fn exec_mulul(
-        &mut self,
-        inst: &Instruction,
-        src: &AddressingMode,
-        dl: DataReg,
-        dh: Option<DataReg>,
-    ) -> Result<()> {
-        let multiplicand = self.read_operand(src, Size::Long, inst.address)? as u64;
+    fn exec_mulul(&mut self, src: &AddressingMode, dl: DataReg, dh: Option<DataReg>) -> Result<()> {
+        let multiplicand = self.read_operand(src, Size::Long)? as u64;
         let dl_idx = data_reg_index(dl);
         let multiplier = self.data_regs[dl_idx] as u64;
         let result = multiplicand * multiplier;
@@ -1798,14 +2059,8 @@ impl Cpu {
     }
 
     // MULS.L - 32-bit signed multiply (68020+)
-    fn exec_mulsl(
-        &mut self,
-        inst: &Instruction,
-        src: &AddressingMode,
-        dl: DataReg,
-        dh: Option<DataReg>,
-    ) -> Result<()> {
-        let multiplicand = self.read_operand(src, Size::Long, inst.address)? as i32 as i64;
+    fn exec_mulsl(&mut self, src: &AddressingMode, dl: DataReg, dh: Option<DataReg>) -> Result<()> {
+        let multiplicand = self.read_operand(src, Size::Long)? as i32 as i64;
         let dl_idx = data_reg_index(dl);
         let multiplier = self.data_regs[dl_idx] as i32 as i64;
         let result = multiplicand * multiplier;
@@ -1830,13 +2085,12 @@ impl Cpu {
     // CAS - Compare and Swap (68020+)
     fn exec_cas(
         &mut self,
-        inst: &Instruction,
         size: Size,
         dc: DataReg,
         du: DataReg,
         mode: &AddressingMode,
     ) -> Result<()> {
-        let addr = self.compute_effective_address(mode, inst.address)?;
+        let addr = self.compute_effective_address(mode)?;
         let operand = self.read_mem(addr, size)?;
         let dc_idx = data_reg_index(dc);
 
@@ -1994,7 +2248,6 @@ impl Cpu {
     // CMP2 - Compare Register Against Bounds (68020+)
     fn exec_cmp2(
         &mut self,
-        inst: &Instruction,
         size: Size,
         mode: &AddressingMode,
         reg: crate::decoder::Register,
@@ -2022,7 +2275,7 @@ impl Cpu {
         let reg_value = reg_value & mask;
 
         // Read lower and upper bounds from memory
-        let addr = self.compute_effective_address(mode, inst.address)?;
+        let addr = self.compute_effective_address(mode)?;
         let lower_bound = self.read_mem(addr, size)?;
         let size_bytes = match size {
             Size::Byte => 1,
@@ -2047,7 +2300,6 @@ impl Cpu {
     // CHK2 - Check Register Against Bounds (68020+)
     fn exec_chk2(
         &mut self,
-        inst: &Instruction,
         size: Size,
         mode: &AddressingMode,
         reg: crate::decoder::Register,
@@ -2076,7 +2328,7 @@ impl Cpu {
         let reg_value = reg_value & mask;
 
         // Read lower and upper bounds from memory
-        let addr = self.compute_effective_address(mode, inst.address)?;
+        let addr = self.compute_effective_address(mode)?;
         let lower_bound = self.read_mem(addr, size)?;
         let size_bytes = match size {
             Size::Byte => 1,
@@ -2103,7 +2355,6 @@ impl Cpu {
     // BFTST - Test Bit Field (68020+)
     fn exec_bftst(
         &mut self,
-        inst: &Instruction,
         mode: &AddressingMode,
         offset: BitFieldParam,
         width: BitFieldParam,
@@ -2136,7 +2387,7 @@ impl Cpu {
             }
             _ => {
                 // Memory operand - offset can be negative or > 31
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2155,7 +2406,6 @@ impl Cpu {
     // BFCHG - Change Bit Field (invert) (68020+)
     fn exec_bfchg(
         &mut self,
-        inst: &Instruction,
         mode: &AddressingMode,
         offset: BitFieldParam,
         width: BitFieldParam,
@@ -2180,7 +2430,7 @@ impl Cpu {
                 extract_bitfield_from_u32(reg_val, offset_mod, width_val)
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2200,7 +2450,7 @@ impl Cpu {
                 self.data_regs[data_reg_index(reg)] = result;
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 insert_bitfield_into_memory(
                     &mut self.memory,
                     base_addr,
@@ -2223,7 +2473,6 @@ impl Cpu {
     // BFCLR - Clear Bit Field (68020+)
     fn exec_bfclr(
         &mut self,
-        inst: &Instruction,
         mode: &AddressingMode,
         offset: BitFieldParam,
         width: BitFieldParam,
@@ -2248,7 +2497,7 @@ impl Cpu {
                 extract_bitfield_from_u32(reg_val, offset_mod, width_val)
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2261,7 +2510,7 @@ impl Cpu {
                 self.data_regs[data_reg_index(reg)] = result;
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 insert_bitfield_into_memory(&mut self.memory, base_addr, offset_val, width_val, 0)?;
             }
         }
@@ -2278,7 +2527,6 @@ impl Cpu {
     // BFSET - Set Bit Field (68020+)
     fn exec_bfset(
         &mut self,
-        inst: &Instruction,
         mode: &AddressingMode,
         offset: BitFieldParam,
         width: BitFieldParam,
@@ -2303,7 +2551,7 @@ impl Cpu {
                 extract_bitfield_from_u32(reg_val, offset_mod, width_val)
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2322,7 +2570,7 @@ impl Cpu {
                 self.data_regs[data_reg_index(reg)] = result;
             }
             _ => {
-                let base_addr = self.compute_effective_address(mode, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(mode)? as u32;
                 insert_bitfield_into_memory(
                     &mut self.memory,
                     base_addr,
@@ -2345,7 +2593,6 @@ impl Cpu {
     // BFFFO - Find First One Bit Field (68020+)
     fn exec_bfffo(
         &mut self,
-        inst: &Instruction,
         src: &AddressingMode,
         dst: DataReg,
         offset: BitFieldParam,
@@ -2371,7 +2618,7 @@ impl Cpu {
                 extract_bitfield_from_u32(reg_val, offset_mod, width_val)
             }
             _ => {
-                let base_addr = self.compute_effective_address(src, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(src)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2402,7 +2649,6 @@ impl Cpu {
     // BFEXTU - Extract Bit Field Unsigned (68020+)
     fn exec_bfextu(
         &mut self,
-        inst: &Instruction,
         src: &AddressingMode,
         dst: DataReg,
         offset: BitFieldParam,
@@ -2434,7 +2680,7 @@ impl Cpu {
             }
             _ => {
                 // Memory operand - offset can be negative or > 31
-                let base_addr = self.compute_effective_address(src, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(src)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2454,7 +2700,6 @@ impl Cpu {
 
     fn exec_bfexts(
         &mut self,
-        inst: &Instruction,
         src: &AddressingMode,
         dst: DataReg,
         offset: BitFieldParam,
@@ -2486,7 +2731,7 @@ impl Cpu {
             }
             _ => {
                 // Memory operand - offset can be negative or > 31
-                let base_addr = self.compute_effective_address(src, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(src)? as u32;
                 extract_bitfield_from_memory(&self.memory, base_addr, offset_val, width_val)?
             }
         };
@@ -2516,7 +2761,6 @@ impl Cpu {
 
     fn exec_bfins(
         &mut self,
-        inst: &Instruction,
         src: DataReg,
         dst: &AddressingMode,
         offset: BitFieldParam,
@@ -2552,7 +2796,7 @@ impl Cpu {
             }
             _ => {
                 // Memory operand - offset can be negative or > 31
-                let base_addr = self.compute_effective_address(dst, inst.address)? as u32;
+                let base_addr = self.compute_effective_address(dst)? as u32;
                 insert_bitfield_into_memory(
                     &mut self.memory,
                     base_addr,
@@ -2734,7 +2978,7 @@ impl Cpu {
     }
 
     // MOVEM - Move Multiple Registers
-    fn exec_movem(&mut self, inst: &Instruction, movem: Movem) -> Result<()> {
+    fn exec_movem(&mut self, movem: Movem) -> Result<()> {
         let size_bytes = if movem.size == Size::Word { 2 } else { 4 };
         let is_predec = matches!(movem.mode.ea, EffectiveAddress::AddrPreDecr(_));
 
@@ -2755,7 +2999,7 @@ impl Cpu {
 
         match movem.direction {
             DataDir::RegToMem => {
-                let mut addr = self.compute_effective_address(&movem.mode, inst.address)?;
+                let mut addr = self.compute_effective_address(&movem.mode)?;
                 if is_predec {
                     // For predecrement, store from A7 down to D0 (descending address)
                     // Iterate through bits 0-15, which map to A7, A6, ..., D1, D0
@@ -2768,11 +3012,7 @@ impl Cpu {
                             } else {
                                 self.addr_regs[reg_idx]
                             };
-                            if movem.size == Size::Word {
-                                self.memory.write_data(addr, &(val as u16).to_be_bytes())?;
-                            } else {
-                                self.memory.write_data(addr, &val.to_be_bytes())?;
-                            }
+                            self.write_mem(addr, movem.size, val)?;
                         }
                     }
                     // Update address register
@@ -2789,18 +3029,14 @@ impl Cpu {
                             } else {
                                 self.addr_regs[reg_idx]
                             };
-                            if movem.size == Size::Word {
-                                self.memory.write_data(addr, &(val as u16).to_be_bytes())?;
-                            } else {
-                                self.memory.write_data(addr, &val.to_be_bytes())?;
-                            }
+                            self.write_mem(addr, movem.size, val)?;
                             addr = addr.wrapping_add(size_bytes);
                         }
                     }
                 }
             }
             DataDir::MemToReg => {
-                let mut addr = self.compute_effective_address(&movem.mode, inst.address)?;
+                let mut addr = self.compute_effective_address(&movem.mode)?;
                 // For MemToReg, the mask is always in normal format (D0=bit0, A7=bit15)
                 // even when used with postincrement
                 for bit in 0..16 {
@@ -2841,80 +3077,98 @@ impl Cpu {
     }
 
     // TAS - Test and Set
-    fn exec_tas(&mut self, inst: &Instruction, mode: AddressingMode) -> Result<()> {
-        let value = self.read_operand(&mode, Size::Byte, inst.address)?;
+    fn exec_tas(&mut self, mode: AddressingMode) -> Result<()> {
+        let loc = self.locate_dst(&mode, Size::Byte)?;
+        let value = self.read_loc(loc, Size::Byte)?;
         self.update_nz_flags_sized(value, Size::Byte);
         self.set_flag(FLAG_V, false);
         self.set_flag(FLAG_C, false);
         // Set high bit
-        self.write_operand(&mode, Size::Byte, inst.address, value | 0x80)?;
+        self.write_loc(loc, Size::Byte, value | 0x80)?;
         Ok(())
     }
 
     // Helper: write to operand
-    fn write_operand(
-        &mut self,
-        mode: &AddressingMode,
-        size: Size,
-        inst_addr: usize,
-        value: u32,
-    ) -> Result<()> {
+    fn write_operand(&mut self, mode: &AddressingMode, size: Size, value: u32) -> Result<()> {
+        let loc = self.locate_dst(mode, size)?;
+        self.write_loc(loc, size, value)
+    }
+
+    /// Resolve `mode` for an access of `size`, applying any (An)+ / -(An)
+    /// update. Read-modify-write instructions resolve once and use the
+    /// returned location for both accesses.
+    pub(super) fn locate(&mut self, mode: &AddressingMode, size: Size) -> Result<Loc> {
+        Ok(match mode.resolved {
+            ResolvedEa::Dn(reg) => Loc::Data(reg as usize),
+            ResolvedEa::An(reg) => Loc::Addr(reg as usize),
+            ResolvedEa::Imm(value) => Loc::Imm(value),
+            ResolvedEa::PostInc(reg) => {
+                let idx = reg as usize;
+                let addr = self.addr_regs[idx];
+                self.addr_regs[idx] = addr.wrapping_add(Self::ea_step(size, idx == 7));
+                Loc::Mem(addr as usize)
+            }
+            ResolvedEa::PreDec(reg) => {
+                let idx = reg as usize;
+                let addr = self.addr_regs[idx].wrapping_sub(Self::ea_step(size, idx == 7));
+                self.addr_regs[idx] = addr;
+                Loc::Mem(addr as usize)
+            }
+            _ => Loc::Mem(self.compute_effective_address(mode)?),
+        })
+    }
+
+    /// Like `locate`, for an operand that is written.
+    pub(super) fn locate_dst(&mut self, mode: &AddressingMode, size: Size) -> Result<Loc> {
         match mode.ea {
-            EffectiveAddress::Dr(reg) => {
-                let idx = data_reg_index(reg);
-                self.data_regs[idx] = write_sized_data_reg(self.data_regs[idx], value, size);
-            }
-            EffectiveAddress::Ar(reg) => {
-                let idx = addr_reg_index(reg);
-                self.addr_regs[idx] = value;
-            }
-            EffectiveAddress::Addr(reg) => {
-                let addr = self.addr_regs[addr_reg_index(reg)] as usize;
-                self.write_mem(addr, size, value)?;
-            }
-            EffectiveAddress::AddrDisplace(_) => {
-                let addr = self.compute_effective_address(mode, inst_addr)?;
-                self.write_mem(addr, size, value)?;
-            }
-            EffectiveAddress::AbsShort => {
-                let addr = mode
-                    .short_data()
-                    .ok_or_else(|| anyhow!("missing AbsShort data"))?
-                    as usize;
-                self.write_mem(addr, size, value)?;
-            }
-            EffectiveAddress::AbsLong => {
-                let addr = mode
-                    .long_data()
-                    .ok_or_else(|| anyhow!("missing AbsLong data"))?
-                    as usize;
-                self.write_mem(addr, size, value)?;
-            }
-            EffectiveAddress::AddrPostIncr(reg) => {
-                let idx = addr_reg_index(reg);
-                let addr = self.addr_regs[idx] as usize;
-                self.write_mem(addr, size, value)?;
-                let step = Self::ea_step(size, reg == AddrReg::A7);
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_add(step);
-            }
-            EffectiveAddress::AddrPreDecr(reg) => {
-                let idx = addr_reg_index(reg);
-                let step = Self::ea_step(size, reg == AddrReg::A7);
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_sub(step);
-                let addr = self.addr_regs[idx] as usize;
-                self.write_mem(addr, size, value)?;
+            EffectiveAddress::PCDisplace
+            | EffectiveAddress::PCIndex
+            | EffectiveAddress::Immediate => {
+                bail!("unsupported addressing mode {:?} for write", mode.ea)
             }
-            EffectiveAddress::AddrIndex(_) => {
-                let addr = self.compute_effective_address(mode, inst_addr)?;
-                self.write_mem(addr, size, value)?;
+            _ => self.locate(mode, size),
+        }
+    }
+
+    pub(super) fn read_loc(&mut self, loc: Loc, size: Size) -> Result<u32> {
+        match loc {
+            Loc::Data(idx) => Ok(size_mask(self.data_regs[idx], size)),
+            Loc::Addr(idx) => Ok(self.addr_regs[idx]),
+            Loc::Imm(value) => Ok(value),
+            Loc::Mem(addr) => self.read_mem(addr, size),
+        }
+    }
+
+    pub(super) fn write_loc(&mut self, loc: Loc, size: Size, value: u32) -> Result<()> {
+        match loc {
+            Loc::Data(idx) => {
+                self.data_regs[idx] = write_sized_data_reg(self.data_regs[idx], value, size);
             }
-            _ => bail!("unsupported addressing mode {:?} for write", mode.ea),
+            Loc::Addr(idx) => self.addr_regs[idx] = value,
+            Loc::Mem(addr) => self.write_mem(addr, size, value)?,
+            Loc::Imm(_) => bail!("cannot write to an immediate operand"),
         }
         Ok(())
     }
 
     // Helper: write to memory
-    fn write_mem(&mut self, addr: usize, size: Size, value: u32) -> Result<()> {
+    pub(super) fn write_mem(&mut self, addr: usize, size: Size, value: u32) -> Result<()> {
+        if self.options.trace_writes
+            && let Some(trace) = &mut self.trace
+        {
+            trace.write(addr as u32, size_to_bytes(size));
+        }
+        if let Some(ptr) = self.stack_slot(addr, size) {
+            // SAFETY: `stack_slot` checked the access against a live window.
+            unsafe {
+                match size {
+                    Size::Byte => *ptr = value as u8,
+                    Size::Word => ptr.cast::<[u8; 2]>().write((value as u16).to_be_bytes()),
+                    Size::Long => ptr.cast::<[u8; 4]>().write(value.to_be_bytes()),
+                }
+            }
+            return Ok(());
+        }
         match size {
             Size::Byte => self.memory.write_data(addr, &[value as u8])?,
             Size::Word => self
@@ -2926,307 +3180,139 @@ impl Cpu {
     }
 
     // Helper: push long onto stack
-    fn push_long(&mut self, value: u32) -> Result<()> {
+    pub(super) fn push_long(&mut self, value: u32) -> Result<()> {
         self.addr_regs[7] = self.addr_regs[7].wrapping_sub(4);
         let sp = self.addr_regs[7] as usize;
-        self.memory.write_data(sp, &value.to_be_bytes())?;
-        Ok(())
+        self.write_mem(sp, Size::Long, value)
     }
 
     // Helper: pop long from stack
-    fn pop_long(&mut self) -> Result<u32> {
+    pub(super) fn pop_long(&mut self) -> Result<u32> {
         let sp = self.addr_regs[7] as usize;
-        let value = self.memory.read_long(sp)?;
+        let value = self.read_mem(sp, Size::Long)?;
         self.addr_regs[7] = self.addr_regs[7].wrapping_add(4);
         Ok(value)
     }
 
-    fn read_word_unsigned(&mut self, mode: AddressingMode) -> Result<u16> {
-        match mode.ea {
-            EffectiveAddress::Dr(reg) => Ok(self.data_regs[data_reg_index(reg)] as u16),
-            EffectiveAddress::Addr(addr_reg) => {
-                let addr = self.addr_regs[addr_reg_index(addr_reg)] as usize;
-                Ok(self.memory.read_word(addr)?)
-            }
-            EffectiveAddress::AddrDisplace(addr_reg) => {
-                let displacement = mode
-                    .short_data()
-                    .ok_or_else(|| anyhow!("missing displacement for AddrDisplace"))?
-                    as i16;
-                let base = self.addr_regs[addr_reg_index(addr_reg)] as i64;
-                let effective = base
-                    .checked_add(displacement as i64)
-                    .ok_or_else(|| anyhow!("address overflow computing displacement"))?
-                    as usize;
-                Ok(self.memory.read_word(effective)?)
-            }
-            EffectiveAddress::AbsShort => {
-                let addr = mode
-                    .short_data()
-                    .ok_or_else(|| anyhow!("missing address for AbsShort"))?
-                    as usize;
-                Ok(self.memory.read_word(addr)?)
-            }
-            EffectiveAddress::AbsLong => {
-                let addr = mode
-                    .long_data()
-                    .ok_or_else(|| anyhow!("missing address for AbsLong"))?
-                    as usize;
-                Ok(self.memory.read_word(addr)?)
-            }
-            EffectiveAddress::Immediate => {
-                let imm = mode
-                    .immediate()
-                    .ok_or_else(|| anyhow!("missing immediate for word operand"))?;
-                match imm {
-                    Immediate::Byte(v) => Ok(v as u16),
-                    Immediate::Word(v) => Ok(v),
-                    Immediate::Long(v) => Ok(v as u16),
-                }
-            }
-            EffectiveAddress::AddrPostIncr(reg) => {
-                let idx = addr_reg_index(reg);
-                let addr = self.addr_regs[idx] as usize;
-                let value = self.memory.read_word(addr)?;
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_add(2);
-                Ok(value)
-            }
-            EffectiveAddress::AddrPreDecr(reg) => {
-                let idx = addr_reg_index(reg);
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_sub(2);
-                let addr = self.addr_regs[idx] as usize;
-                Ok(self.memory.read_word(addr)?)
-            }
-            _ => bail!("unsupported addressing mode {:?} for word read", mode.ea),
+    // Helper: host pointer for an access inside the stack window. The window
+    // is only re-fetched once A7 has left it (or the memory layout changed),
+    // so accesses elsewhere cost one range check before the normal path.
+    #[inline]
+    fn stack_slot(&mut self, addr: usize, size: Size) -> Option<*mut u8> {
+        let bytes = SizeInfo::new(size).bytes as usize;
+        let layout = self.memory.layout();
+        if let Some(ptr) = self.stack.get(addr, bytes, layout) {
+            return Some(ptr);
+        }
+        let sp = self.addr_regs[7] as usize;
+        if self.stack.get(sp, 1, layout).is_some() {
+            self.slow_lookups += 1;
+            return None;
+        }
+        self.window_refills += 1;
+        self.stack = self.memory.window(sp)?;
+        let ptr = self.stack.get(addr, bytes, layout);
+        if ptr.is_none() {
+            self.slow_lookups += 1;
         }
+        ptr
+    }
+
+    fn read_word_unsigned(&mut self, mode: AddressingMode) -> Result<u16> {
+        Ok(self.read_operand(&mode, Size::Word)? as u16)
     }
 
     fn read_word_signed(&mut self, mode: AddressingMode) -> Result<i16> {
         Ok(self.read_word_unsigned(mode)? as i16)
     }
 
-    fn read_operand(&mut self, mode: &AddressingMode, size: Size, inst_addr: usize) -> Result<u32> {
-        match mode.ea {
-            EffectiveAddress::Dr(reg) => Ok(size_mask(self.data_regs[data_reg_index(reg)], size)),
-            EffectiveAddress::Ar(reg) => Ok(self.addr_regs[addr_reg_index(reg)]),
-            EffectiveAddress::Addr(reg) => {
-                let addr = self.addr_regs[addr_reg_index(reg)] as usize;
-                self.read_mem(addr, size)
-            }
-            EffectiveAddress::AddrDisplace(_) => {
-                let addr = self.compute_effective_address(mode, inst_addr)?;
-                self.read_mem(addr, size)
-            }
-            EffectiveAddress::AbsShort => {
-                let addr = mode
-                    .short_data()
-                    .ok_or_else(|| anyhow!("missing AbsShort data"))?
-                    as usize;
-                self.read_mem(addr, size)
-            }
-            EffectiveAddress::AbsLong => {
-                let addr = mode
-                    .long_data()
-                    .ok_or_else(|| anyhow!("missing AbsLong data"))?
-                    as usize;
-                self.read_mem(addr, size)
-            }
-            EffectiveAddress::PCDisplace => {
-                let addr = self.compute_effective_address(mode, inst_addr)?;
-                self.read_mem(addr, size)
-            }
-            EffectiveAddress::Immediate => match mode
-                .immediate()
-                .ok_or_else(|| anyhow!("missing immediate data"))?
-            {
-                Immediate::Byte(v) => Ok(v as u32),
-                Immediate::Word(v) => Ok(v as u32),
-                Immediate::Long(v) => Ok(v),
-            },
-            EffectiveAddress::AddrPostIncr(reg) => {
-                let idx = addr_reg_index(reg);
-                let addr = self.addr_regs[idx] as usize;
-                let value = self.read_mem(addr, size)?;
-                let step = Self::ea_step(size, reg == AddrReg::A7);
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_add(step);
-                Ok(value)
+    fn read_operand(&mut self, mode: &AddressingMode, size: Size) -> Result<u32> {
+        let loc = self.locate(mode, size)?;
+        self.read_loc(loc, size)
+    }
+
+    /// Address of a memory operand, without applying (An)+ / -(An).
+    pub(super) fn compute_effective_address(&self, mode: &AddressingMode) -> Result<usize> {
+        let addr = match mode.resolved {
+            ResolvedEa::Ind(reg) | ResolvedEa::PostInc(reg) | ResolvedEa::PreDec(reg) => {
+                self.addr_regs[reg as usize]
             }
-            EffectiveAddress::AddrPreDecr(reg) => {
-                let idx = addr_reg_index(reg);
-                let step = Self::ea_step(size, reg == AddrReg::A7);
-                self.addr_regs[idx] = self.addr_regs[idx].wrapping_sub(step);
-                let addr = self.addr_regs[idx] as usize;
-                self.read_mem(addr, size)
+            ResolvedEa::DispAn { reg, disp } => {
+                self.addr_regs[reg as usize].wrapping_add(disp as u32)
             }
-            EffectiveAddress::AddrIndex(_) | EffectiveAddress::PCIndex => {
-                let addr = self.compute_effective_address(mode, inst_addr)?;
-                self.read_mem(addr, size)
+            ResolvedEa::Abs(addr) => addr,
+            ResolvedEa::Index { base, index, disp } => self
+                .index_base(base)
+                .wrapping_add(self.index_value(index))
+                .wrapping_add(disp),
+            ResolvedEa::MemIndirectPre {
+                base,
+                index,
+                disp,
+                outer,
+            } => {
+                let ptr = self
+                    .index_base(base)
+                    .wrapping_add(self.index_value(index))
+                    .wrapping_add(disp);
+                self.memory.read_long(ptr as usize)?.wrapping_add(outer)
+            }
+            ResolvedEa::MemIndirectPost {
+                base,
+                index,
+                disp,
+                outer,
+            } => {
+                let ptr = self.index_base(base).wrapping_add(disp);
+                self.memory
+                    .read_long(ptr as usize)?
+                    .wrapping_add(self.index_value(index))
+                    .wrapping_add(outer)
             }
-        }
-    }
-
-    fn compute_effective_address(&self, mode: &AddressingMode, inst_addr: usize) -> Result<usize> {
-        match mode.ea {
-            EffectiveAddress::Addr(reg) => Ok(self.addr_regs[addr_reg_index(reg)] as usize),
-            EffectiveAddress::AddrPostIncr(reg) => Ok(self.addr_regs[addr_reg_index(reg)] as usize),
-            EffectiveAddress::AddrPreDecr(reg) => Ok(self.addr_regs[addr_reg_index(reg)] as usize),
-            EffectiveAddress::AddrDisplace(reg) => {
-                let disp =
-                    mode.short_data()
-                        .ok_or_else(|| anyhow!("missing displacement"))? as i16;
-                let base = self.addr_regs[addr_reg_index(reg)] as i64;
-                let eff = base
-                    .checked_add(disp as i64)
-                    .ok_or_else(|| anyhow!("address overflow computing displacement"))?;
-                Ok(eff as u32 as usize)
-            }
-            EffectiveAddress::AbsShort => mode
-                .short_data()
-                .map(|v| v as i16 as i32 as usize) // Sign-extend 16-bit to 32-bit
-                .ok_or_else(|| anyhow!("missing AbsShort data")),
-            EffectiveAddress::AbsLong => mode
-                .long_data()
-                .map(|v| v as usize)
-                .ok_or_else(|| anyhow!("missing AbsLong data")),
-            EffectiveAddress::PCDisplace => {
-                let disp = mode
-                    .short_data()
-                    .ok_or_else(|| anyhow!("missing PC displacement"))?
-                    as i16;
-                let base = inst_addr
-                    .checked_add(2)
-                    .ok_or_else(|| anyhow!("overflow computing PC base"))?;
-                let eff = (base as i64)
-                    .checked_add(disp as i64)
-                    .ok_or_else(|| anyhow!("address overflow computing PC displacement"))?;
-                Ok(eff as u32 as usize)
-            }
-            EffectiveAddress::AddrIndex(reg) => {
-                let (ext_word, base_disp) = mode
-                    .index_ext()
-                    .ok_or_else(|| anyhow!("missing index extension word"))?;
-                // Check base suppress (68020+ full format)
-                let is_full_format = (ext_word & 0x0100) != 0;
-                let base_suppress = is_full_format && (ext_word & 0x0080) != 0;
-                let base = if base_suppress {
-                    0i64
-                } else {
-                    self.addr_regs[addr_reg_index(reg)] as i64
-                };
-                let index = self.decode_index_register(ext_word);
-                let eff = base
-                    .checked_add(index)
-                    .and_then(|v| v.checked_add(base_disp as i64))
-                    .ok_or_else(|| anyhow!("address overflow computing indexed address"))?;
-                Ok(eff as u32 as usize)
-            }
-            EffectiveAddress::PCIndex => {
-                let (ext_word, base_disp) = mode
-                    .index_ext()
-                    .ok_or_else(|| anyhow!("missing PC index extension word"))?;
-                // Check base suppress (68020+ full format)
-                let is_full_format = (ext_word & 0x0100) != 0;
-                let base_suppress = is_full_format && (ext_word & 0x0080) != 0;
-                let base = if base_suppress {
-                    0i64
-                } else {
-                    inst_addr
-                        .checked_add(2)
-                        .ok_or_else(|| anyhow!("overflow computing PC base"))?
-                        as i64
-                };
-
-                // Check for memory indirect (68020+)
-                // Bits 2-0: I/IS field
-                // 0 = no memory indirect
-                // 1-3 = preindexed (index before indirection)
-                // 5-7 = postindexed (index after indirection)
-                let i_is = ext_word & 0x7;
-                if is_full_format && i_is != 0 {
-                    // Memory indirect mode
-                    let is_postindexed = (i_is & 0x4) != 0;
-                    let index = self.decode_index_register(ext_word);
-
-                    let intermediate = if is_postindexed {
-                        // Postindexed: (base + bd), then add index
-                        base.checked_add(base_disp as i64)
-                            .ok_or_else(|| anyhow!("address overflow"))?
-                    } else {
-                        // Preindexed: (base + index + bd)
-                        base.checked_add(index)
-                            .and_then(|v| v.checked_add(base_disp as i64))
-                            .ok_or_else(|| anyhow!("address overflow"))?
-                    };
-
-                    // Read pointer from intermediate address
-                    let ptr_addr = usize::try_from(intermediate)
-                        .map_err(|_| anyhow!("negative intermediate address"))?;
-                    let ptr = self.memory.read_long(ptr_addr)? as i64;
-
-                    // Add index (if postindexed) and outer displacement
-                    // For now, outer displacement is 0 (null) for i_is = 1 or 5
-                    let final_addr = if is_postindexed {
-                        ptr.checked_add(index)
-                            .ok_or_else(|| anyhow!("address overflow"))?
-                    } else {
-                        ptr
-                    };
-
-                    Ok(final_addr as u32 as usize)
-                } else {
-                    // Simple indexed (no memory indirect)
-                    let index = self.decode_index_register(ext_word);
-                    let eff = base
-                        .checked_add(index)
-                        .and_then(|v| v.checked_add(base_disp as i64))
-                        .ok_or_else(|| anyhow!("address overflow computing PC indexed address"))?;
-                    usize::try_from(eff).map_err(|_| anyhow!("negative effective address"))
-                }
+            ResolvedEa::Dn(_) | ResolvedEa::An(_) | ResolvedEa::Imm(_) | ResolvedEa::Unresolved => {
+                bail!(
+                    "unsupported addressing mode {:?} for effective address",
+                    mode.ea
+                )
             }
-            _ => bail!(
-                "unsupported addressing mode {:?} for effective address",
-                mode.ea
-            ),
-        }
+        };
+        Ok(addr as usize)
     }
 
-    /// Decode the index register value from an extension word.
-    /// Extension word format:
-    /// - Bit 15: D/A (0=Dn, 1=An)
-    /// - Bits 14-12: register number
-    /// - Bit 11: W/L (0=word sign-extended, 1=long)
-    /// - Bits 10-9: scale (00=1, 01=2, 10=4, 11=8) - 68020+
-    /// - Bit 8: full extension word indicator (68020+)
-    /// - Bit 6: IS (index suppress) - 68020+
-    fn decode_index_register(&self, ext_word: u16) -> i64 {
-        // Check if index is suppressed (68020+ full format only)
-        let is_full_format = (ext_word & 0x0100) != 0;
-        if is_full_format && (ext_word & 0x0040) != 0 {
-            return 0; // Index suppressed
-        }
-
-        let is_addr_reg = (ext_word & 0x8000) != 0;
-        let reg_num = ((ext_word >> 12) & 0x7) as usize;
-        let is_long = (ext_word & 0x0800) != 0;
-        let scale = 1i64 << ((ext_word >> 9) & 0x3); // 1, 2, 4, or 8
+    fn index_base(&self, base: Option<u8>) -> u32 {
+        base.map_or(0, |reg| self.addr_regs[reg as usize])
+    }
 
-        let reg_value = if is_addr_reg {
-            self.addr_regs[reg_num]
+    /// Scaled value of an index register; zero when the index is suppressed.
+    fn index_value(&self, index: Option<IndexReg>) -> u32 {
+        let Some(index) = index else {
+            return 0;
+        };
+        let reg = index.reg as usize;
+        let value = if reg < 8 {
+            self.data_regs[reg]
         } else {
-            self.data_regs[reg_num]
+            self.addr_regs[reg - 8]
         };
-
-        let index = if is_long {
-            reg_value as i32 as i64
+        let value = if index.long {
+            value
         } else {
-            // Word-sized: sign-extend low 16 bits
-            (reg_value as i16) as i64
+            value as i16 as i32 as u32
         };
-
-        index * scale
+        value << index.shift
     }
 
-    fn read_mem(&mut self, addr: usize, size: Size) -> Result<u32> {
+    pub(super) fn read_mem(&mut self, addr: usize, size: Size) -> Result<u32> {
+        if let Some(ptr) = self.stack_slot(addr, size) {
+            // SAFETY: `stack_slot` checked the access against a live window.
+            return Ok(unsafe {
+                match size {
+                    Size::Byte => *ptr as u32,
+                    Size::Word => u16::from_be_bytes(ptr.cast::<[u8; 2]>().read()) as u32,
+                    Size::Long => u32::from_be_bytes(ptr.cast::<[u8; 4]>().read()),
+                }
+            });
+        }
         Ok(match size {
             Size::Byte => self.memory.read_byte(addr)? as u32,
             Size::Word => self.memory.read_word(addr)? as u32,
@@ -3241,7 +3327,7 @@ impl Cpu {
         }
     }
 
-    fn ea_step(size: Size, is_a7: bool) -> u32 {
+    pub(super) fn ea_step(size: Size, is_a7: bool) -> u32 {
         match size {
             Size::Byte => {
                 if is_a7 {
@@ -3262,7 +3348,7 @@ impl Cpu {
         self.set_flag(FLAG_N, is_negative);
     }
 
-    fn set_flag(&mut self, mask: u16, set: bool) {
+    pub(super) fn set_flag(&mut self, mask: u16, set: bool) {
         if set {
             self.sr |= mask;
         } else {
@@ -3271,22 +3357,31 @@ impl Cpu {
     }
 }
 
-const FLAG_C: u16 = 0x0001;
-const FLAG_V: u16 = 0x0002;
-const FLAG_Z: u16 = 0x0004;
-const FLAG_N: u16 = 0x0008;
-const FLAG_X: u16 = 0x0010;
+/// Where an operand lives once its effective address has been resolved.
+#[derive(Debug, Clone, Copy)]
+pub(super) enum Loc {
+    Data(usize),
+    Addr(usize),
+    Imm(u32),
+    Mem(usize),
+}
+
+pub(super) const FLAG_C: u16 = 0x0001;
+pub(super) const FLAG_V: u16 = 0x0002;
+pub(super) const FLAG_Z: u16 = 0x0004;
+pub(super) const FLAG_N: u16 = 0x0008;
+pub(super) const FLAG_X: u16 = 0x0010;
 
 /// Size-related constants bundled together
-struct SizeInfo {
-    mask: u32,
+pub(super) struct SizeInfo {
+    pub(super) mask: u32,
     sign_bit: u32,
-    bits: u32,
+    pub(super) bits: u32,
     bytes: u32,
 }
 
 impl SizeInfo {
-    fn new(size: Size) -> Self {
+    pub(super) fn new(size: Size) -> Self {
         match size {
             Size::Byte => Self {
                 mask: 0xFF,
@@ -3309,16 +3404,16 @@ impl SizeInfo {
         }
     }
 
-    fn apply(&self, value: u32) -> u32 {
+    pub(super) fn apply(&self, value: u32) -> u32 {
         value & self.mask
     }
 
-    fn is_negative(&self, value: u32) -> bool {
+    pub(super) fn is_negative(&self, value: u32) -> bool {
         (value & self.sign_bit) != 0
     }
 }
 
-fn write_sized_data_reg(orig: u32, value: u32, size: Size) -> u32 {
+pub(super) fn write_sized_data_reg(orig: u32, value: u32, size: Size) -> u32 {
     match size {
         Size::Byte => (orig & 0xFFFF_FF00) | (value & 0xFF),
         Size::Word => (orig & 0xFFFF_0000) | (value & 0xFFFF),
@@ -3326,7 +3421,7 @@ fn write_sized_data_reg(orig: u32, value: u32, size: Size) -> u32 {
     }
 }
 
-fn size_mask(value: u32, size: Size) -> u32 {
+pub(super) fn size_mask(value: u32, size: Size) -> u32 {
     SizeInfo::new(size).apply(value)
 }
 
@@ -3343,7 +3438,7 @@ fn addr_reg_index(reg: AddrReg) -> usize {
 }
 
 /// Add with full flag computation (N, Z, V, C, X)
-fn add_with_flags(src: u32, dst: u32, size: Size, cpu: &mut Cpu) -> u32 {
+pub(super) fn add_with_flags(src: u32, dst: u32, size: Size, cpu: &mut Cpu) -> u32 {
     let si = SizeInfo::new(size);
     let src = si.apply(src);
     let dst = si.apply(dst);
@@ -3362,7 +3457,7 @@ fn add_with_flags(src: u32, dst: u32, size: Size, cpu: &mut Cpu) -> u32 {
 }
 
 /// Subtract with full flag computation (N, Z, V, C, X). Computes dst - src.
-fn sub_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) -> u32 {
+pub(super) fn sub_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) -> u32 {
     let si = SizeInfo::new(size);
     let src = si.apply(src);
     let dst = si.apply(dst);
@@ -3381,7 +3476,7 @@ fn sub_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) -> u32 {
 }
 
 /// Compare (dst - src) setting only N, Z, V, C (not X)
-fn cmp_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) {
+pub(super) fn cmp_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) {
     let si = SizeInfo::new(size);
     let src = si.apply(src);
     let dst = si.apply(dst);
@@ -3396,7 +3491,7 @@ fn cmp_with_flags(dst: u32, src: u32, size: Size, cpu: &mut Cpu) {
     cpu.set_flag(FLAG_C, src > dst);
 }
 
-fn imm_to_u32(imm: Immediate) -> u32 {
+pub(super) fn imm_to_u32(imm: Immediate) -> u32 {
     match imm {
         Immediate::Byte(v) => v as u32,
         Immediate::Word(v) => v as u32,
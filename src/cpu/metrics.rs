@@ -0,0 +1,316 @@
+use std::{
+    fmt::Write as _,
+    fs,
+    str::FromStr,
+    sync::atomic::{AtomicBool, Ordering},
+    thread,
+    time::Duration,
+};
+
+use anyhow::{Context, bail};
+
+use super::{Cpu, on_host_signal};
+use crate::syscall::m68k_syscall_name;
+
+/// Upper bounds, in seconds, of the syscall latency histogram buckets.
+const LATENCY_BOUNDS: [f64; 7] = [1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1.0];
+
+/// Set by SIGUSR2 or the interval thread; the registry is dumped at the
+/// next syscall.
+static DUMP_REQUESTED: AtomicBool = AtomicBool::new(false);
+
+extern "C" fn request_dump(_: libc::c_int) {
+    DUMP_REQUESTED.store(true, Ordering::Relaxed);
+}
+
+/// Output format of `--metrics`.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum MetricsFormat {
+    #[default]
+    Json,
+    /// Prometheus text exposition format.
+    Prometheus,
+}
+
+impl FromStr for MetricsFormat {
+    type Err = anyhow::Error;
+
+    fn from_str(s: &str) -> anyhow::Result<Self> {
+        match s {
+            "json" => Ok(MetricsFormat::Json),
+            "prometheus" | "prom" => Ok(MetricsFormat::Prometheus),
+            _ => bail!("unknown metrics format {s:?} (expected json or prometheus)"),
+        }
+    }
+}
+
+enum Kind {
+    Counter,
+    Gauge,
+}
+
+/// One sample of the registry, in a form both formats can render.
+struct Sample {
+    name: &'static str,
+    help: &'static str,
+    kind: Kind,
+    value: u64,
+}
+
+/// Counters owned by the run loop thread. Hot counters stay plain fields
+/// on `Cpu`; this holds the ones only `--metrics` needs, and everything
+/// else is merged in when the registry is dumped.
+pub(super) struct Metrics {
+    /// Calls per m68k syscall number.
+    syscalls: Vec<u64>,
+    /// Syscall host latency: one count per `LATENCY_BOUNDS` entry plus an
+    /// overflow bucket, and the sum in seconds.
+    latency: [u64; LATENCY_BOUNDS.len() + 1],
+    latency_sum: f64,
+    /// Process that writes to the `--metrics` path itself; forked
+    /// children write to `<path>.<pid>`.
+    pid: u32,
+}
+
+impl Metrics {
+    pub(super) fn new(interval: Option<Duration>) -> Self {
+        on_host_signal(libc::SIGUSR2, request_dump);
+        if let Some(interval) = interval {
+            thread::spawn(move || {
+                loop {
+                    thread::sleep(interval);
+                    DUMP_REQUESTED.store(true, Ordering::Relaxed);
+                }
+            });
+        }
+        Self {
+            syscalls: Vec::new(),
+            latency: [0; LATENCY_BOUNDS.len() + 1],
+            latency_sum: 0.0,
+            pid: std::process::id(),
+        }
+    }
+
+    pub(super) fn syscall(&mut self, number: u32, elapsed: Duration) {
+        let number = number as usize;
+        if self.syscalls.len() <= number {
+            self.syscalls.resize(number + 1, 0);
+        }
+        self.syscalls[number] += 1;
+        let secs = elapsed.as_secs_f64();
+        let bucket = LATENCY_BOUNDS.partition_point(|&bound| bound < secs);
+        self.latency[bucket] += 1;
+        self.latency_sum += secs;
+    }
+}
+
+fn syscall_name(number: usize) -> String {
+    match m68k_syscall_name(number as u32) {
+        Some(name) => name.to_string(),
+        None => format!("syscall_{number}"),
+    }
+}
+
+impl Cpu {
+    /// Set up the registry requested on the command line.
+    pub(super) fn start_metrics(&mut self) {
+        if self.options.metrics.is_some() {
+            let interval = self.options.metrics_interval.map(Duration::from_secs);
+            self.metrics = Some(Box::new(Metrics::new(interval)));
+        }
+    }
+
+    /// Account one syscall and dump the registry if a dump is due.
+    pub(super) fn metrics_syscall(&mut self, number: u32, elapsed: Duration) {
+        if let Some(metrics) = &mut self.metrics {
+            metrics.syscall(number, elapsed);
+            if DUMP_REQUESTED.swap(false, Ordering::Relaxed) {
+                self.dump_metrics();
+            }
+        }
+    }
+
+    fn samples(&self) -> Vec<Sample> {
+        let counter = |name, help, value| Sample {
+            name,
+            help,
+            kind: Kind::Counter,
+            value,
+        };
+        let gauge = |name, help, value| Sample {
+            name,
+            help,
+            kind: Kind::Gauge,
+            value,
+        };
+        let segments = self.memory.segments();
+        let mut samples = vec![
+            counter("instructions", "Guest instructions executed", self.executed),
+            counter(
+                "blocks_entered",
+                "Guest blocks entered (instructions on the interpreter tier)",
+                self.blocks_entered,
+            ),
+            counter("syscalls", "Guest syscalls made", self.syscalls),
+            counter(
+                "memory_slow_lookups",
+                "Guest accesses that missed the stack window and searched the segment list",
+                self.slow_lookups,
+            ),
+            counter(
+                "stack_window_refills",
+                "Times the stack window was re-fetched",
+                self.window_refills,
+            ),
+            gauge(
+                "memory_segments",
+                "Guest memory segments mapped",
+                segments.len() as u64,
+            ),
+            gauge(
+                "memory_mapped_bytes",
+                "Bytes of guest memory mapped",
+                segments.iter().map(|s| s.len() as u64).sum(),
+            ),
+            gauge(
+                "brk_bytes",
+                "Bytes between the initial and current program break",
+                (self.brk - self.brk_base) as u64,
+            ),
+            counter(
+                "mmap_bytes",
+                "Bytes mapped by anonymous mmap calls",
+                self.mmap_bytes,
+            ),
+        ];
+        if let Some(stats) = &self.code_cache_stats {
+            let stats = stats.counters();
+            let get = |name| stats.iter().find(|s| s.0 == name).map_or(0, |s| s.3);
+            // Blocks the run loop had to translate itself; worker
+            // translations are prefetches, not misses.
+            let misses = get("code_cache_translations") - get("code_cache_prefetched");
+            samples.push(counter(
+                "code_cache_hits",
+                "Block lookups served by the code cache",
+                self.blocks_entered.saturating_sub(misses),
+            ));
+            samples.push(counter(
+                "code_cache_misses",
+                "Block lookups that translated on the run loop",
+                misses,
+            ));
+            for (name, help, is_gauge, value) in stats {
+                samples.push(if is_gauge {
+                    gauge(name, help, value)
+                } else {
+                    counter(name, help, value)
+                });
+            }
+        }
+        samples
+    }
+
+    fn render_json(&self, metrics: &Metrics) -> String {
+        let mut out = String::from("{\n");
+        for sample in self.samples() {
+            let _ = writeln!(out, "  \"{}\": {},", sample.name, sample.value);
+        }
+        let calls: Vec<String> = metrics
+            .syscalls
+            .iter()
+            .enumerate()
+            .filter(|&(_, &count)| count > 0)
+            .map(|(number, count)| format!("\"{}\": {count}", syscall_name(number)))
+            .collect();
+        let _ = writeln!(out, "  \"syscall_calls\": {{{}}},", calls.join(", "));
+        let buckets: Vec<String> = LATENCY_BOUNDS
+            .iter()
+            .map(|bound| format!("\"{bound:e}\""))
+            .chain(["\"+Inf\"".to_string()])
+            .zip(metrics.latency)
+            .map(|(bound, count)| format!("{bound}: {count}"))
+            .collect();
+        let _ = writeln!(
+            out,
+            "  \"syscall_seconds\": {{\"buckets\": {{{}}}, \"sum\": {}}}\n}}",
+            buckets.join(", "),
+            metrics.latency_sum
+        );
+        out
+    }
+
+    fn render_prometheus(&self, metrics: &Metrics) -> String {
+        let mut out = String::new();
+        for sample in self.samples() {
+            let (kind, suffix) = match sample.kind {
+                Kind::Counter => ("counter", "_total"),
+                Kind::Gauge => ("gauge", ""),
+            };
+            let name = format!("behistun_{}{suffix}", sample.name);
+            let _ = writeln!(out, "# HELP {name} {}", sample.help);
+            let _ = writeln!(out, "# TYPE {name} {kind}");
+            let _ = writeln!(out, "{name} {}", sample.value);
+        }
+        let _ = writeln!(
+            out,
+            "# HELP behistun_syscall_calls_total Guest syscalls by name"
+        );
+        let _ = writeln!(out, "# TYPE behistun_syscall_calls_total counter");
+        for (number, &count) in metrics.syscalls.iter().enumerate() {
+            if count > 0 {
+                let _ = writeln!(
+                    out,
+                    "behistun_syscall_calls_total{{syscall=\"{}\"}} {count}",
+                    syscall_name(number)
+                );
+            }
+        }
+        let _ = writeln!(
+            out,
+            "# HELP behistun_syscall_seconds Host time spent in guest syscalls"
+        );
+        let _ = writeln!(out, "# TYPE behistun_syscall_seconds histogram");
+        let mut cumulative = 0;
+        for (i, count) in metrics.latency.iter().enumerate() {
+            cumulative += count;
+            let bound = LATENCY_BOUNDS
+                .get(i)
+                .map_or("+Inf".to_string(), |b| format!("{b:e}"));
+            let _ = writeln!(
+                out,
+                "behistun_syscall_seconds_bucket{{le=\"{bound}\"}} {cumulative}"
+            );
+        }
+        let _ = writeln!(out, "behistun_syscall_seconds_sum {}", metrics.latency_sum);
+        let _ = writeln!(out, "behistun_syscall_seconds_count {cumulative}");
+        out
+    }
+
+    /// Write the registry to the `--metrics` destination: `-` for stderr,
+    /// otherwise a file replaced atomically so scrapers never see half of
+    /// it.
+    pub(super) fn dump_metrics(&self) {
+        let (Some(metrics), Some(dest)) = (&self.metrics, &self.options.metrics) else {
+            return;
+        };
+        let text = match self.options.metrics_format {
+            MetricsFormat::Json => self.render_json(metrics),
+            MetricsFormat::Prometheus => self.render_prometheus(metrics),
+        };
+        if dest == "-" {
+            eprint!("{text}");
+            return;
+        }
+        let mut dest = dest.clone();
+        if std::process::id() != metrics.pid {
+            let _ = write!(dest, ".{}", std::process::id());
+        }
+        let tmp = format!("{dest}.tmp.{}", std::process::id());
+        let written = fs::write(&tmp, text)
+            .and_then(|()| fs::rename(&tmp, &dest))
+            .with_context(|| format!("writing metrics to {dest}"));
+        if let Err(e) = written {
+            eprintln!("{e:#}");
+        }
+    }
+}
@@ -1,7 +1,81 @@
+mod discover;
+mod ir;
 mod m68020;
+mod metrics;
+mod output;
+mod perfmap;
+mod pgo;
+mod profile;
+mod replay;
+mod snapshot;
+#[cfg(feature = "stats")]
+mod stats;
 mod syscall;
+mod syscall_stats;
+mod sysroot;
+mod threaded;
+mod tracing;
+mod translate;
 
+use std::str::FromStr;
+
+use anyhow::bail;
+
+use crate::decoder::InstructionKind;
+
+pub use discover::save_code_map;
 pub use m68020::{Cpu, ElfInfo};
+pub use metrics::MetricsFormat;
+
+/// Execution engine used by `Cpu::run_jit`.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum ExecTier {
+    /// Decode and execute one instruction at a time.
+    #[default]
+    Interpreter,
+    /// Lower blocks to the optimized micro-op IR and interpret that.
+    Ir,
+    /// Run blocks of pre-bound handlers with operands resolved at decode time.
+    Threaded,
+}
+
+impl FromStr for ExecTier {
+    type Err = anyhow::Error;
+
+    fn from_str(s: &str) -> anyhow::Result<Self> {
+        match s {
+            "interp" | "interpreter" => Ok(ExecTier::Interpreter),
+            "ir" => Ok(ExecTier::Ir),
+            "threaded" => Ok(ExecTier::Threaded),
+            _ => bail!("unknown execution tier {s:?} (expected interp, threaded or ir)"),
+        }
+    }
+}
+
+/// How the code cache makes room once it exceeds its byte budget.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum EvictPolicy {
+    /// Drop the least recently entered blocks.
+    #[default]
+    Lru,
+    /// Drop every block translated in the oldest generation.
+    Generation,
+    /// Drop everything and start over.
+    Flush,
+}
+
+impl FromStr for EvictPolicy {
+    type Err = anyhow::Error;
+
+    fn from_str(s: &str) -> anyhow::Result<Self> {
+        match s {
+            "lru" => Ok(EvictPolicy::Lru),
+            "generation" => Ok(EvictPolicy::Generation),
+            "flush" => Ok(EvictPolicy::Flush),
+            _ => bail!("unknown eviction policy {s:?} (expected lru, generation or flush)"),
+        }
+    }
+}
 
 // m68k uses a fixed TLS layout where the thread pointer lives 0x7000 bytes
 // past the start of the TLS block. TLS offsets (tpoff) are negative relative
@@ -14,3 +88,43 @@ pub(super) const TLS_DATA_PAD: usize = 0x1000;
 pub(super) fn align_up(value: usize, align: usize) -> usize {
     (value + align - 1) & !(align - 1)
 }
+
+/// Install `handler` for the host `signal`, restarting any syscall it
+/// interrupts. Used for the signals that ask for a report mid-run, whose
+/// handlers only set a flag the guest thread checks at its next syscall.
+fn on_host_signal(signal: libc::c_int, handler: extern "C" fn(libc::c_int)) {
+    // SAFETY: the action is fully initialized before it is installed, and
+    // callers' handlers only store to an atomic.
+    unsafe {
+        let mut action: libc::sigaction = std::mem::zeroed();
+        action.sa_sigaction = handler as usize;
+        action.sa_flags = libc::SA_RESTART;
+        libc::sigemptyset(&mut action.sa_mask);
+        libc::sigaction(signal, &action, std::ptr::null_mut());
+    }
+}
+
+/// Instructions that may leave PC anywhere but the next instruction, and so
+/// end a translated block.
+pub(super) fn ends_block(kind: &InstructionKind) -> bool {
+    matches!(
+        kind,
+        InstructionKind::Rts
+            | InstructionKind::Rtd { .. }
+            | InstructionKind::Rtr
+            | InstructionKind::Rte
+            | InstructionKind::Bra { .. }
+            | InstructionKind::Bcc { .. }
+            | InstructionKind::DBcc { .. }
+            | InstructionKind::Bsr { .. }
+            | InstructionKind::Jsr { .. }
+            | InstructionKind::Jmp { .. }
+            | InstructionKind::Trap { .. }
+            | InstructionKind::Trapcc { .. }
+            | InstructionKind::TrapV
+            | InstructionKind::Chk { .. }
+            | InstructionKind::Chk2 { .. }
+            | InstructionKind::Illegal
+            | InstructionKind::Reset
+    )
+}
@@ -0,0 +1,186 @@
+// Guest stdout/stderr coalescing for `--buffer-output`. Writes to fds 1
+// and 2 that aren't terminals are gathered into one buffer, in the order
+// the guest made them, and written out when it fills, every
+// FLUSH_INTERVAL from a helper thread, and before any syscall that could
+// observe the output or the order it was written in.
+
+use std::{
+    sync::{Arc, Mutex, MutexGuard, PoisonError},
+    thread,
+    time::Duration,
+};
+
+use super::Cpu;
+
+/// Bytes held before the buffer is written out.
+const CAPACITY: usize = 64 * 1024;
+
+/// Longest buffered output waits when the guest stops writing.
+const FLUSH_INTERVAL: Duration = Duration::from_millis(20);
+
+/// Buffered output: the bytes, and for each run of writes to the same fd,
+/// the fd and where its bytes end.
+#[derive(Default)]
+struct Pending {
+    bytes: Vec<u8>,
+    runs: Vec<(i32, usize)>,
+}
+
+impl Pending {
+    fn push(&mut self, fd: i32, data: &[u8]) {
+        self.bytes.extend_from_slice(data);
+        match self.runs.last_mut() {
+            Some((last, end)) if *last == fd => *end = self.bytes.len(),
+            _ => self.runs.push((fd, self.bytes.len())),
+        }
+    }
+
+    /// Write everything out in order. Errors are dropped: the guest was
+    /// told its writes succeeded.
+    fn flush(&mut self) {
+        let mut start = 0;
+        for &(fd, end) in &self.runs {
+            let mut data = &self.bytes[start..end];
+            while !data.is_empty() {
+                // SAFETY: `data` is a live byte slice.
+                let n = unsafe { libc::write(fd, data.as_ptr().cast(), data.len()) };
+                if n < 0 {
+                    if std::io::Error::last_os_error().kind() == std::io::ErrorKind::Interrupted {
+                        continue;
+                    }
+                    break;
+                }
+                data = &data[n as usize..];
+            }
+            start = end;
+        }
+        self.bytes.clear();
+        self.runs.clear();
+    }
+}
+
+pub(super) struct OutputBuffer {
+    pending: Arc<Mutex<Pending>>,
+    /// Whether fds 1 and 2 are buffered; terminals are written straight
+    /// through so interactive output isn't held back.
+    buffered: [bool; 2],
+    /// Process the flusher thread runs in. Threads don't survive fork, so
+    /// a child starts its own.
+    pid: u32,
+}
+
+impl OutputBuffer {
+    fn new() -> Self {
+        let mut output = Self {
+            pending: Arc::default(),
+            buffered: [false; 2],
+            pid: 0,
+        };
+        output.refresh();
+        output
+    }
+
+    /// Recheck which of fds 1 and 2 can be buffered.
+    fn refresh(&mut self) {
+        for (fd, buffered) in (1..).zip(&mut self.buffered) {
+            // SAFETY: fcntl(F_GETFD) and isatty only inspect `fd`.
+            *buffered = unsafe { libc::fcntl(fd, libc::F_GETFD) >= 0 && libc::isatty(fd) == 0 };
+        }
+    }
+
+    /// Write out what is buffered. A process that hasn't buffered
+    /// anything since it was forked has nothing to write.
+    fn flush(&mut self) {
+        if self.pid == std::process::id() {
+            self.pending
+                .lock()
+                .unwrap_or_else(PoisonError::into_inner)
+                .flush();
+        }
+    }
+
+    /// The buffer, with a flusher thread running for this process.
+    fn pending(&mut self) -> MutexGuard<'_, Pending> {
+        let pid = std::process::id();
+        if self.pid != pid {
+            // The parent flushed before forking, but its flusher may have
+            // held the lock at that moment; start over with a fresh one.
+            self.pending = Arc::default();
+            self.pid = pid;
+            let pending = Arc::downgrade(&self.pending);
+            thread::spawn(move || {
+                loop {
+                    thread::sleep(FLUSH_INTERVAL);
+                    let Some(pending) = pending.upgrade() else {
+                        break;
+                    };
+                    pending
+                        .lock()
+                        .unwrap_or_else(PoisonError::into_inner)
+                        .flush();
+                }
+            });
+        }
+        self.pending.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+}
+
+impl Cpu {
+    pub(super) fn start_output_buffer(&mut self) {
+        if self.options.buffer_output {
+            self.output = Some(Box::new(OutputBuffer::new()));
+        }
+    }
+
+    /// Take a guest write of `data` to `fd` into the buffer. Returns false
+    /// if it has to go to the host now, after what is already buffered.
+    pub(super) fn buffer_write(&mut self, fd: i32, data: &[u8]) -> bool {
+        let Some(output) = &mut self.output else {
+            return false;
+        };
+        let buffered = matches!(fd, 1 | 2) && output.buffered[fd as usize - 1];
+        if !buffered || data.len() >= CAPACITY {
+            output.flush();
+            return false;
+        }
+        let mut pending = output.pending();
+        pending.push(fd, data);
+        if pending.bytes.len() >= CAPACITY {
+            pending.flush();
+        }
+        true
+    }
+
+    /// Write out buffered output before a syscall that could observe it.
+    /// Bookkeeping syscalls that can't are let through.
+    pub(super) fn flush_output_for(&mut self, number: u32) {
+        let Some(output) = &mut self.output else {
+            return;
+        };
+        // write, time, getpid, brk, gettimeofday, mmap, munmap, mprotect,
+        // mmap2, gettid, clock_gettime, clock_gettime64
+        if !matches!(
+            number,
+            4 | 13 | 20 | 45 | 78 | 90 | 91 | 125 | 192 | 221 | 260 | 403
+        ) {
+            output.flush();
+        }
+    }
+
+    /// Recheck fds 1 and 2 after a syscall that may have replaced them
+    /// (close, dup2, dup3).
+    pub(super) fn refresh_output(&mut self, number: u32) {
+        if let Some(output) = &mut self.output
+            && matches!(number, 6 | 63 | 326)
+        {
+            output.refresh();
+        }
+    }
+
+    /// Write out buffered output on the way out of the guest.
+    pub(super) fn flush_output(&mut self) {
+        if let Some(output) = &mut self.output {
+            output.flush();
+        }
+    }
+}
@@ -0,0 +1,156 @@
+use std::{collections::HashMap, ffi::c_void, fmt::Write as _, fs};
+
+use anyhow::{Context, Result, bail};
+
+use super::Cpu;
+use crate::symbols::Symbols;
+
+/// `push %rbp; mov %rsp,%rbp; call *%rsi; pop %rbp; ret`, padded with
+/// int3. Calls `callee(data)` from a host address unique to one guest
+/// block, so a host profiler attributes the block's time to that address.
+const TRAMPOLINE: [u8; 16] = [
+    0x55, 0x48, 0x89, 0xe5, 0xff, 0xd6, 0x5d, 0xc3, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc,
+];
+
+/// Trampolines per executable chunk.
+const CHUNK_SLOTS: usize = 4096;
+
+type Callee = extern "C" fn(*mut c_void);
+type Trampoline = unsafe extern "C" fn(*mut c_void, Callee);
+
+/// Host trampolines for `--perf-map`: each guest block runs through its own
+/// stub, and `/tmp/perf-<pid>.map` names the stubs after the guest code, so
+/// `perf report` shows `m68k:<symbol>+off@<pc>` instead of the interpreter
+/// loop.
+pub(super) struct PerfMap {
+    chunk: *mut u8,
+    used: usize,
+    slots: HashMap<usize, Trampoline>,
+    /// (host address, name) for every stub handed out.
+    entries: Vec<(usize, String)>,
+}
+
+impl PerfMap {
+    pub(super) fn new() -> Result<Self> {
+        if !cfg!(target_arch = "x86_64") {
+            bail!("--perf-map is only supported on x86_64 hosts");
+        }
+        Ok(Self {
+            chunk: std::ptr::null_mut(),
+            used: CHUNK_SLOTS,
+            slots: HashMap::new(),
+            entries: Vec::new(),
+        })
+    }
+
+    /// Stub for the block at guest `pc`, created on first use. `None` if
+    /// no executable memory could be mapped.
+    fn trampoline(&mut self, pc: usize, symbols: &Symbols) -> Option<Trampoline> {
+        if let Some(&stub) = self.slots.get(&pc) {
+            return Some(stub);
+        }
+        if self.used == CHUNK_SLOTS {
+            self.chunk = map_chunk()?;
+            self.used = 0;
+        }
+        // SAFETY: the slot is inside the current chunk, which holds a
+        // complete trampoline at every slot.
+        let stub = unsafe {
+            let slot = self.chunk.add(self.used * TRAMPOLINE.len());
+            std::mem::transmute::<*mut u8, Trampoline>(slot)
+        };
+        self.used += 1;
+        self.slots.insert(pc, stub);
+        self.entries.push((
+            stub as usize,
+            format!("m68k:{}@{pc:#x}", symbols.describe(pc)),
+        ));
+        Some(stub)
+    }
+
+    /// Write `/tmp/perf-<pid>.map` for the current process; a forked child
+    /// inherits the stubs and writes its own map.
+    pub(super) fn write(&self) -> Result<()> {
+        let path = format!("/tmp/perf-{}.map", std::process::id());
+        let mut out = String::new();
+        for (addr, name) in &self.entries {
+            let _ = writeln!(out, "{addr:x} {:x} {name}", TRAMPOLINE.len());
+        }
+        fs::write(&path, out).with_context(|| format!("writing {path}"))
+    }
+}
+
+/// Map a chunk of `CHUNK_SLOTS` trampolines. Every stub is the same code,
+/// so the chunk is filled once and made read-only before any of it runs.
+/// Chunks are never unmapped: stubs of invalidated blocks stay valid, and
+/// their perf map names with them.
+fn map_chunk() -> Option<*mut u8> {
+    let len = CHUNK_SLOTS * TRAMPOLINE.len();
+    // SAFETY: a fresh anonymous mapping aliases no Rust memory.
+    let chunk = unsafe {
+        libc::mmap(
+            std::ptr::null_mut(),
+            len,
+            libc::PROT_READ | libc::PROT_WRITE,
+            libc::MAP_PRIVATE | libc::MAP_ANONYMOUS,
+            -1,
+            0,
+        )
+    };
+    if chunk == libc::MAP_FAILED {
+        return None;
+    }
+    let chunk: *mut u8 = chunk.cast();
+    // SAFETY: every slot lies inside the `len` bytes just mapped writable.
+    let sealed = unsafe {
+        for slot in 0..CHUNK_SLOTS {
+            chunk
+                .add(slot * TRAMPOLINE.len())
+                .copy_from_nonoverlapping(TRAMPOLINE.as_ptr(), TRAMPOLINE.len());
+        }
+        libc::mprotect(chunk.cast(), len, libc::PROT_READ | libc::PROT_EXEC) == 0
+    };
+    if !sealed {
+        // SAFETY: nothing has been handed out from the chunk yet.
+        unsafe { libc::munmap(chunk.cast(), len) };
+        return None;
+    }
+    Some(chunk)
+}
+
+/// Run `f` through `stub`.
+fn call_via<F: FnOnce() -> R, R>(stub: Trampoline, f: F) -> R {
+    extern "C" fn callee<F: FnOnce() -> R, R>(data: *mut c_void) {
+        // SAFETY: `data` is the `state` below, live for the whole call.
+        let state = unsafe { &mut *data.cast::<(Option<F>, Option<R>)>() };
+        if let Some(f) = state.0.take() {
+            state.1 = Some(f());
+        }
+    }
+    let mut state: (Option<F>, Option<R>) = (Some(f), None);
+    // SAFETY: the stub only forwards its first argument to `callee`.
+    unsafe { stub((&raw mut state).cast(), callee::<F, R>) };
+    state
+        .1
+        .expect("trampoline returned without running the block")
+}
+
+impl Cpu {
+    /// Run the block starting at `pc`, recording it in the `--trace`
+    /// stream and going through its perf map stub when `--perf-map` is on.
+    #[inline]
+    pub(super) fn enter_block<R>(&mut self, pc: usize, f: impl FnOnce(&mut Cpu) -> R) -> R {
+        self.blocks_entered += 1;
+        if let Some(trace) = &mut self.trace {
+            trace.block(pc as u32);
+        }
+        let stub = match &mut self.perf_map {
+            None => None,
+            Some(map) => map.trampoline(pc, &self.symbols),
+        };
+        match stub {
+            None => f(self),
+            Some(stub) => call_via(stub, || f(self)),
+        }
+    }
+}
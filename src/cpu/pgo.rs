@@ -0,0 +1,214 @@
+use std::{collections::HashMap, fmt::Write as _, fs, path::Path, sync::Arc};
+
+use anyhow::{Context, Result, bail};
+
+use super::{Cpu, ends_block, translate::BranchBias};
+use crate::decoder::{Instruction, InstructionKind};
+
+const HEADER: &str = "# behistun block profile v1";
+
+/// Branches need this many recorded outcomes before `--profile-in` lays
+/// them out by bias.
+const MIN_BRANCH_SAMPLES: u64 = 32;
+
+/// A branch is laid out along one side when at least this many tenths of
+/// its outcomes went that way.
+const BIAS_TENTHS: u64 = 9;
+
+/// FNV-1a over the guest binary, so a profile is only applied to the build
+/// it was recorded from.
+pub(super) fn binary_hash(path: &str) -> Result<u64> {
+    let data = fs::read(path).with_context(|| format!("reading {path}"))?;
+    Ok(data.iter().fold(0xcbf2_9ce4_8422_2325, |hash, &byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0100_0000_01b3)
+    }))
+}
+
+/// Block entries and conditional branch outcomes seen by the run loop, for
+/// `--profile-out`. Entries are the targets of control transfers, so the
+/// profile means the same thing on every tier.
+pub(super) struct BlockProfile {
+    binary: u64,
+    entries: HashMap<usize, u64>,
+    /// Taken and not-taken counts by branch address.
+    branches: HashMap<usize, [u64; 2]>,
+    /// Process that writes the `--profile-out` path itself; forked children
+    /// write to `<path>.<pid>`.
+    pid: u32,
+}
+
+impl BlockProfile {
+    fn new(binary: u64, entry: usize) -> Self {
+        Self {
+            binary,
+            entries: HashMap::from([(entry, 1)]),
+            branches: HashMap::new(),
+            pid: std::process::id(),
+        }
+    }
+
+    fn write(&self, path: &str) -> Result<()> {
+        let mut entries: Vec<_> = self.entries.iter().map(|(&pc, &n)| (pc, n)).collect();
+        entries.sort_unstable_by(|a, b| b.1.cmp(&a.1).then(a.0.cmp(&b.0)));
+        let mut branches: Vec<_> = self.branches.iter().map(|(&pc, &n)| (pc, n)).collect();
+        branches.sort_unstable();
+        write_profile(path, self.binary, &entries, &branches)
+    }
+}
+
+/// Write a profile: block entries in the order `--profile-in` should
+/// translate them, then branch outcomes.
+pub(super) fn write_profile(
+    path: &str,
+    binary: u64,
+    entries: &[(usize, u64)],
+    branches: &[(usize, [u64; 2])],
+) -> Result<()> {
+    let mut out = format!("{HEADER}\nbinary {binary:016x}\n");
+    for (pc, count) in entries {
+        let _ = writeln!(out, "block {pc:#x} {count}");
+    }
+    for (pc, [taken, not_taken]) in branches {
+        let _ = writeln!(out, "branch {pc:#x} {taken} {not_taken}");
+    }
+    fs::write(path, out).with_context(|| format!("writing profile {path}"))
+}
+
+/// What `--profile-in` and `--predecode` hand to the code cache.
+#[derive(Default)]
+pub(super) struct ProfileHints {
+    /// Block entries, hottest first, to translate before the guest starts.
+    pub(super) hot: Vec<usize>,
+    pub(super) bias: Arc<BranchBias>,
+    /// Roots to discover and translate code from before the guest starts.
+    pub(super) predecode: Vec<usize>,
+}
+
+impl ProfileHints {
+    /// Parse a `--profile-out` file, or `None` if it was recorded from a
+    /// different binary.
+    fn load(path: &str, binary: u64) -> Result<Option<Self>> {
+        let text = fs::read_to_string(path).with_context(|| format!("reading {path}"))?;
+        let mut lines = text.lines().enumerate();
+        if lines.next().map(|(_, line)| line) != Some(HEADER) {
+            bail!("{path}: not a behistun block profile");
+        }
+        let mut hot = Vec::new();
+        let mut bias = BranchBias::new();
+        let mut keyed = false;
+        for (index, line) in lines {
+            let fields: Vec<&str> = line.split_whitespace().collect();
+            let number = |i: usize| -> Result<u64> {
+                let field = fields.get(i).copied().unwrap_or_default();
+                let parsed = match field.strip_prefix("0x") {
+                    Some(hex) => u64::from_str_radix(hex, 16),
+                    None => field.parse(),
+                };
+                parsed.with_context(|| format!("{path}:{}: bad field {field:?}", index + 1))
+            };
+            match fields.first().copied() {
+                Some("binary") => {
+                    let hash = fields.get(1).copied().unwrap_or_default();
+                    if u64::from_str_radix(hash, 16).ok() != Some(binary) {
+                        return Ok(None);
+                    }
+                    keyed = true;
+                }
+                Some("block") => hot.push(number(1)? as usize),
+                Some("branch") => {
+                    let (taken, not_taken) = (number(2)?, number(3)?);
+                    let total = taken + not_taken;
+                    if total < MIN_BRANCH_SAMPLES {
+                        continue;
+                    }
+                    if taken * 10 >= total * BIAS_TENTHS {
+                        bias.insert(number(1)? as usize, true);
+                    } else if not_taken * 10 >= total * BIAS_TENTHS {
+                        bias.insert(number(1)? as usize, false);
+                    }
+                }
+                None => {}
+                Some(other) => bail!("{path}:{}: unknown record {other:?}", index + 1),
+            }
+        }
+        if !keyed {
+            bail!("{path}: no binary hash");
+        }
+        Ok(Some(Self {
+            hot,
+            bias: Arc::new(bias),
+            predecode: Vec::new(),
+        }))
+    }
+}
+
+impl Cpu {
+    /// Load `--profile-in`, or the `behistun aot` code map saved next to
+    /// the binary, and start `--profile-out`. A profile from another build
+    /// of the binary is ignored with a warning, since the guest still runs
+    /// correctly without it.
+    pub(super) fn start_block_profile(&mut self) -> Result<()> {
+        let code_map = format!("{}.aot", self.exe_path);
+        let hints = match &self.options.profile_in {
+            Some(path) => Some(path.clone()),
+            None => Path::new(&code_map).exists().then_some(code_map),
+        };
+        if hints.is_none() && self.options.profile_out.is_none() {
+            return Ok(());
+        }
+        let binary = binary_hash(&self.exe_path)?;
+        if let Some(path) = &hints {
+            self.profile_hints = ProfileHints::load(path, binary)?.map(Box::new);
+            if self.profile_hints.is_none() {
+                eprintln!(
+                    "warning: {path} was recorded from a different build of {}; ignoring it",
+                    self.exe_path
+                );
+            }
+        }
+        if self.options.profile_out.is_some() {
+            self.block_profile = Some(Box::new(BlockProfile::new(binary, self.pc)));
+        }
+        Ok(())
+    }
+
+    /// Account the control transfers in `insts`, the instructions a block
+    /// just executed, the last of which continued at the current pc. A
+    /// block laid out by branch bias runs through conditional branches, so
+    /// each instruction is followed to the one after it.
+    #[inline]
+    pub(super) fn profile_edges(&mut self, insts: &[Instruction]) {
+        let Some(profile) = &mut self.block_profile else {
+            return;
+        };
+        let successors = insts.iter().skip(1).map(|inst| inst.address);
+        for (inst, pc) in insts.iter().zip(successors.chain([self.pc])) {
+            let next = inst.address + inst.len();
+            if matches!(inst.kind, InstructionKind::Bcc { .. }) {
+                let outcome = profile.branches.entry(inst.address).or_default();
+                outcome[usize::from(pc == next)] += 1;
+            }
+            if pc != next || ends_block(&inst.kind) {
+                *profile.entries.entry(pc).or_default() += 1;
+            }
+        }
+    }
+
+    /// Write the `--profile-out` file. Called on the way out of the guest
+    /// and before execve, after which the profile no longer describes the
+    /// running binary and collection stops.
+    pub(super) fn save_block_profile(&mut self) {
+        let (Some(profile), Some(path)) = (self.block_profile.take(), &self.options.profile_out)
+        else {
+            return;
+        };
+        let path = if std::process::id() == profile.pid {
+            path.clone()
+        } else {
+            format!("{path}.{}", std::process::id())
+        };
+        if let Err(e) = profile.write(&path) {
+            eprintln!("{e:#}");
+        }
+    }
+}
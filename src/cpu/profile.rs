@@ -0,0 +1,217 @@
+use std::{
+    collections::HashMap,
+    fmt::Write as _,
+    fs,
+    sync::atomic::{AtomicBool, Ordering},
+    thread,
+    time::Duration,
+};
+
+use anyhow::{Context, Result};
+
+use super::Cpu;
+use crate::symbols::Symbols;
+
+/// Default instructions between samples. Prime, so the sampling period
+/// does not line up with guest loops.
+const DEFAULT_INTERVAL: u64 = 10_007;
+
+/// Deepest guest call stack recorded per sample.
+const MAX_DEPTH: usize = 128;
+
+/// In timer mode, how many instructions run between checks of the tick.
+const TIMER_POLL: u64 = 1000;
+
+/// Rows in the flat report printed at exit.
+const REPORT_ROWS: usize = 30;
+
+/// Set by the timer thread, cleared when a sample is taken.
+static TICK: AtomicBool = AtomicBool::new(false);
+
+/// Sampling profiler for guest code (`--guest-profile`). Samples the pc
+/// and the A6 frame chain either every `interval` instructions or on a
+/// host timer, and writes folded stacks at exit.
+pub(super) struct Profiler {
+    path: String,
+    interval: u64,
+    timer_hz: Option<u32>,
+    /// Process the timer thread runs in; a forked child starts its own.
+    pid: u32,
+    /// Raw guest pc stacks, innermost first, for the current image.
+    stacks: HashMap<Vec<u32>, u64>,
+    /// Symbolized stacks ("outer;inner") from images replaced by execve.
+    folded: HashMap<String, u64>,
+}
+
+impl Profiler {
+    pub(super) fn new(path: String, interval: Option<u64>, timer_hz: Option<u32>) -> Self {
+        let profiler = Self {
+            path,
+            interval: interval.unwrap_or(DEFAULT_INTERVAL).max(1),
+            timer_hz,
+            pid: std::process::id(),
+            stacks: HashMap::new(),
+            folded: HashMap::new(),
+        };
+        profiler.start_timer();
+        profiler
+    }
+
+    fn start_timer(&self) {
+        let Some(hz) = self.timer_hz else {
+            return;
+        };
+        let period = Duration::from_secs(1) / hz.max(1);
+        thread::spawn(move || {
+            loop {
+                thread::sleep(period);
+                TICK.store(true, Ordering::Relaxed);
+            }
+        });
+    }
+
+    /// Instruction count at which the run loop should call back next.
+    fn next_check(&self, executed: u64) -> u64 {
+        executed
+            + if self.timer_hz.is_some() {
+                TIMER_POLL
+            } else {
+                self.interval
+            }
+    }
+
+    /// Symbolize the stacks recorded so far, before `symbols` stops
+    /// describing guest memory.
+    pub(super) fn resolve(&mut self, symbols: &Symbols) {
+        for (stack, count) in self.stacks.drain() {
+            let mut line = String::new();
+            for (i, pc) in stack.iter().rev().enumerate() {
+                if i > 0 {
+                    line.push(';');
+                }
+                line.push_str(&symbols.function(*pc as usize));
+            }
+            *self.folded.entry(line).or_default() += count;
+        }
+    }
+
+    /// Write folded stacks (flamegraph.pl / inferno input) and print a
+    /// per-function summary. Forked children write to `<path>.<pid>`.
+    pub(super) fn finish(&mut self, symbols: &Symbols) -> Result<()> {
+        self.resolve(symbols);
+        let mut path = self.path.clone();
+        if std::process::id() != self.pid {
+            let _ = write!(path, ".{}", std::process::id());
+        }
+
+        let mut lines: Vec<_> = self.folded.iter().collect();
+        lines.sort();
+        let mut out = String::new();
+        for (stack, count) in &lines {
+            let _ = writeln!(out, "{stack} {count}");
+        }
+        fs::write(&path, out).with_context(|| format!("writing guest profile to {path}"))?;
+
+        // Self time is the innermost frame; total counts a function once
+        // per sample even when it recurses.
+        let total: u64 = self.folded.values().sum();
+        let mut flat: HashMap<&str, (u64, u64)> = HashMap::new();
+        for (stack, &count) in &self.folded {
+            let frames: Vec<&str> = stack.split(';').collect();
+            if let Some(leaf) = frames.last() {
+                flat.entry(leaf).or_default().0 += count;
+            }
+            let mut seen: Vec<&str> = Vec::new();
+            for frame in frames {
+                if !seen.contains(&frame) {
+                    seen.push(frame);
+                    flat.entry(frame).or_default().1 += count;
+                }
+            }
+        }
+        let mut rows: Vec<_> = flat.into_iter().collect();
+        rows.sort_by(|a, b| b.1.0.cmp(&a.1.0).then(b.1.1.cmp(&a.1.1)).then(a.0.cmp(b.0)));
+        let pct = |n: u64| 100.0 * n as f64 / total.max(1) as f64;
+        eprintln!("guest profile: {total} samples written to {path}");
+        eprintln!("  {:>7} {:>7}  function", "self", "total");
+        for (name, (own, all)) in rows.into_iter().take(REPORT_ROWS) {
+            eprintln!("  {:>6.2}% {:>6.2}%  {name}", pct(own), pct(all));
+        }
+        Ok(())
+    }
+}
+
+impl Cpu {
+    /// Called by the run loops once `executed` reaches `sample_at`. Costs
+    /// nothing beyond that comparison when profiling is off, since
+    /// `sample_at` stays at `u64::MAX`.
+    #[cold]
+    pub(super) fn profile_tick(&mut self) {
+        let Some(mut profiler) = self.profiler.take() else {
+            self.sample_at = u64::MAX;
+            return;
+        };
+        if profiler.timer_hz.is_some() {
+            if std::process::id() != profiler.pid {
+                profiler.pid = std::process::id();
+                profiler.start_timer();
+            }
+            if TICK.swap(false, Ordering::Relaxed) {
+                self.take_sample(&mut profiler);
+            }
+        } else {
+            self.take_sample(&mut profiler);
+        }
+        self.sample_at = profiler.next_check(self.executed);
+        self.profiler = Some(profiler);
+    }
+
+    fn take_sample(&self, profiler: &mut Profiler) {
+        let mut stack = Vec::with_capacity(8);
+        stack.push(self.pc as u32);
+        // Each Link An frame holds the caller's A6 at (A6) and the return
+        // address at 4(A6). Frames of callers live at higher addresses, so
+        // stop as soon as the chain stops climbing.
+        let mut fp = self.addr_regs[6];
+        while stack.len() < MAX_DEPTH
+            && fp.is_multiple_of(2)
+            && self.memory.covers_range(fp as usize, 8)
+        {
+            let (Ok(next), Ok(ret)) = (
+                self.memory.read_long(fp as usize),
+                self.memory.read_long(fp as usize + 4),
+            ) else {
+                break;
+            };
+            stack.push(ret);
+            if next <= fp {
+                break;
+            }
+            fp = next;
+        }
+        *profiler.stacks.entry(stack).or_default() += 1;
+    }
+
+    /// Start the profiler requested on the command line.
+    pub(super) fn start_profiler(&mut self) {
+        if let Some(path) = &self.options.guest_profile {
+            let profiler = Profiler::new(
+                path.clone(),
+                self.options.guest_profile_every,
+                self.options.guest_profile_hz,
+            );
+            self.sample_at = profiler.next_check(self.executed);
+            self.profiler = Some(profiler);
+        }
+    }
+
+    /// Write the profile on the way out of the guest.
+    pub(super) fn finish_profiler(&mut self) {
+        self.sample_at = u64::MAX;
+        if let Some(mut profiler) = self.profiler.take()
+            && let Err(e) = profiler.finish(&self.symbols)
+        {
+            eprintln!("{e:#}");
+        }
+    }
+}
@@ -0,0 +1,303 @@
+use std::{
+    fs::File,
+    io::{BufReader, BufWriter, ErrorKind, Read, Write},
+};
+
+use anyhow::{Context, Result, bail};
+
+use super::Cpu;
+use crate::{memory::JournalEntry, syscall::m68k_syscall_name};
+
+const MAGIC: &[u8; 4] = b"BHRR";
+const VERSION: u8 = 1;
+
+/// Syscall entry: number and D1-D6.
+const TAG_ENTRY: u8 = b'S';
+/// Syscall completion: result and the guest memory it changed.
+const TAG_RESULT: u8 = b'R';
+
+/// Syscalls that only change emulator state (memory layout, TLS, the code
+/// cache) or leave the guest. Replay runs these for real and checks their
+/// results against the log; everything else comes from the log. File
+/// mappings are the exception: the fd was never opened on replay, so they
+/// come back as anonymous memory holding the recorded bytes.
+fn runs_on_replay(number: u32) -> bool {
+    // exit, execve, brk, mmap, munmap, cacheflush, mprotect, mremap, mmap2,
+    // exit_group, get/set_thread_area, atomic_cmpxchg_32, atomic_barrier
+    matches!(
+        number,
+        1 | 11 | 45 | 90 | 91 | 123 | 125 | 163 | 192 | 247 | 333..=336
+    )
+}
+
+fn is_fork(number: u32) -> bool {
+    matches!(
+        m68k_syscall_name(number),
+        Some("fork" | "vfork" | "clone" | "clone3")
+    )
+}
+
+fn describe(number: u32, args: &[u32]) -> String {
+    let name = match m68k_syscall_name(number) {
+        Some(name) => name.to_string(),
+        None => format!("syscall_{number}"),
+    };
+    let args: Vec<String> = args.iter().map(|a| format!("{a:#x}")).collect();
+    format!("{name}({})", args.join(", "))
+}
+
+/// Guest bytes one syscall wrote, by address.
+type Effects = Vec<(usize, Vec<u8>)>;
+
+/// `--record` / `--replay` state.
+pub(super) enum SyscallLog {
+    Record {
+        out: BufWriter<File>,
+        /// Process the log belongs to; a forked child stops recording.
+        pid: u32,
+    },
+    Replay {
+        input: BufReader<File>,
+        /// Syscalls replayed so far, for divergence reports.
+        index: u64,
+    },
+}
+
+pub(super) fn read_u8(input: &mut impl Read) -> std::io::Result<u8> {
+    let mut buf = [0; 1];
+    input.read_exact(&mut buf)?;
+    Ok(buf[0])
+}
+
+pub(super) fn read_u32(input: &mut impl Read) -> std::io::Result<u32> {
+    let mut buf = [0; 4];
+    input.read_exact(&mut buf)?;
+    Ok(u32::from_le_bytes(buf))
+}
+
+fn read_i64(input: &mut impl Read) -> std::io::Result<i64> {
+    let mut buf = [0; 8];
+    input.read_exact(&mut buf)?;
+    Ok(i64::from_le_bytes(buf))
+}
+
+impl SyscallLog {
+    fn record(path: &str) -> Result<Self> {
+        let file = File::create(path).with_context(|| format!("creating {path}"))?;
+        let mut out = BufWriter::new(file);
+        out.write_all(MAGIC)?;
+        out.write_all(&[VERSION])?;
+        Ok(SyscallLog::Record {
+            out,
+            pid: std::process::id(),
+        })
+    }
+
+    fn replay(path: &str) -> Result<Self> {
+        let file = File::open(path).with_context(|| format!("opening {path}"))?;
+        let mut input = BufReader::new(file);
+        let mut header = [0; 5];
+        input
+            .read_exact(&mut header)
+            .with_context(|| format!("reading {path}"))?;
+        if &header[..4] != MAGIC {
+            bail!("{path}: not a behistun syscall recording");
+        }
+        if header[4] != VERSION {
+            bail!(
+                "{path}: recording version {} (expected {VERSION})",
+                header[4]
+            );
+        }
+        Ok(SyscallLog::Replay { input, index: 0 })
+    }
+}
+
+impl Cpu {
+    /// Open the `--record` or `--replay` log requested on the command line.
+    pub(super) fn start_syscall_log(&mut self) -> Result<()> {
+        let log = match (&self.options.record, &self.options.replay) {
+            (Some(path), None) => SyscallLog::record(path)?,
+            (None, Some(path)) => SyscallLog::replay(path)?,
+            (None, None) => return Ok(()),
+            (Some(_), Some(_)) => bail!("--record and --replay are mutually exclusive"),
+        };
+        self.syscall_log = Some(Box::new(log));
+        Ok(())
+    }
+
+    /// Called before a syscall is dispatched. When recording, logs the call
+    /// and starts journaling guest memory writes. When replaying, checks the
+    /// call against the log and returns the recorded result, with its
+    /// memory effects already applied, unless the syscall must run for real.
+    pub(super) fn replay_syscall(&mut self, number: u32) -> Result<Option<i64>> {
+        let args: [u32; 6] = self.data_regs[1..7].try_into().unwrap();
+        let maps_file = self.syscall_log.is_some()
+            && self
+                .mmap_request(number)
+                .is_ok_and(|req| req.is_some_and(|req| req.file.is_some()));
+        match self.syscall_log.as_deref_mut() {
+            None => Ok(None),
+            Some(SyscallLog::Record { out, .. }) => {
+                out.write_all(&[TAG_ENTRY])?;
+                out.write_all(&number.to_le_bytes())?;
+                for arg in args {
+                    out.write_all(&arg.to_le_bytes())?;
+                }
+                if !runs_on_replay(number) || maps_file {
+                    self.memory.open_journal();
+                }
+                Ok(None)
+            }
+            Some(SyscallLog::Replay { input, index }) => {
+                *index += 1;
+                let at = *index;
+                let (rec_number, rec_args) = match read_entry(input) {
+                    Ok(entry) => entry,
+                    Err(e) if e.kind() == ErrorKind::UnexpectedEof => bail!(
+                        "replay ran past the end of the recording at syscall {at}: {}",
+                        describe(number, &args)
+                    ),
+                    Err(e) => return Err(e).context("reading recording"),
+                };
+                if rec_number != number || rec_args != args {
+                    bail!(
+                        "replay diverged at syscall {at}: recorded {}, guest made {}",
+                        describe(rec_number, &rec_args),
+                        describe(number, &args)
+                    );
+                }
+                if runs_on_replay(number) && !maps_file {
+                    return Ok(None);
+                }
+                let (result, effects) = read_result(input).context("reading recording")?;
+                if maps_file && result >= 0 {
+                    let req = self.mmap_request(number)?.unwrap();
+                    let flags = libc::MAP_FIXED | libc::MAP_PRIVATE | libc::MAP_ANONYMOUS;
+                    self.alloc_mmap(result as usize, req.length, req.prot, flags, None)?;
+                }
+                for (addr, bytes) in effects {
+                    let ptr = self
+                        .memory
+                        .guest_to_host_mut(addr, bytes.len())
+                        .with_context(|| {
+                            format!("replayed write to unmapped {addr:#x} at syscall {at}")
+                        })?;
+                    // SAFETY: `guest_to_host_mut` checked the whole range.
+                    unsafe { ptr.copy_from_nonoverlapping(bytes.as_ptr(), bytes.len()) };
+                }
+                Ok(Some(result))
+            }
+        }
+    }
+
+    /// Called after a syscall ran for real: logs its result and memory
+    /// effects, or checks it against the log when replaying.
+    pub(super) fn log_syscall_result(&mut self, number: u32, result: i64) -> Result<()> {
+        let journal = self.memory.take_journal();
+        if let Some(SyscallLog::Record { pid, .. }) = self.syscall_log.as_deref()
+            && is_fork(number)
+            && result == 0
+            && std::process::id() != *pid
+        {
+            // A child's log could not be replayed from the start; drop it
+            // without flushing the events the parent still has buffered.
+            if let Some(log) = self.syscall_log.take()
+                && let SyscallLog::Record { out, .. } = *log
+            {
+                let _ = out.into_parts();
+            }
+            return Ok(());
+        }
+        let effects = self.journal_effects(journal);
+        match self.syscall_log.as_deref_mut() {
+            None => Ok(()),
+            Some(SyscallLog::Record { out, .. }) => {
+                out.write_all(&[TAG_RESULT])?;
+                out.write_all(&result.to_le_bytes())?;
+                out.write_all(&(effects.len() as u32).to_le_bytes())?;
+                for (addr, bytes) in effects {
+                    out.write_all(&(addr as u32).to_le_bytes())?;
+                    out.write_all(&(bytes.len() as u32).to_le_bytes())?;
+                    out.write_all(&bytes)?;
+                }
+                Ok(())
+            }
+            Some(SyscallLog::Replay { input, index }) => {
+                let at = *index;
+                let (recorded, _) = read_result(input).context("reading recording")?;
+                if recorded != result {
+                    bail!(
+                        "replay diverged at syscall {at}: {} returned {result}, recorded {recorded}",
+                        describe(number, &self.data_regs[1..7])
+                    );
+                }
+                Ok(())
+            }
+        }
+    }
+
+    /// Guest bytes a syscall actually changed, from the ranges it wrote or
+    /// was handed host pointers to.
+    fn journal_effects(&self, journal: Vec<JournalEntry>) -> Effects {
+        let mut effects = Vec::new();
+        for entry in journal {
+            let Some(ptr) = self.memory.guest_to_host(entry.addr, entry.len) else {
+                continue;
+            };
+            // SAFETY: `guest_to_host` checked the whole range.
+            let after = unsafe { std::slice::from_raw_parts(ptr, entry.len) };
+            let (start, end) = match &entry.before {
+                None => (0, entry.len),
+                Some(before) => {
+                    let differs = |i: &usize| before[*i] != after[*i];
+                    let Some(first) = (0..entry.len).find(differs) else {
+                        continue;
+                    };
+                    let last = (0..entry.len).rev().find(differs).unwrap_or(first);
+                    (first, last + 1)
+                }
+            };
+            effects.push((entry.addr + start, after[start..end].to_vec()));
+        }
+        effects
+    }
+
+    /// Write out the rest of the recording on the way out of the guest.
+    pub(super) fn finish_syscall_log(&mut self) {
+        if let Some(SyscallLog::Record { out, .. }) = self.syscall_log.as_deref_mut()
+            && let Err(e) = out.flush()
+        {
+            eprintln!("writing recording: {e}");
+        }
+    }
+}
+
+fn read_entry(input: &mut impl Read) -> std::io::Result<(u32, [u32; 6])> {
+    if read_u8(input)? != TAG_ENTRY {
+        return Err(ErrorKind::InvalidData.into());
+    }
+    let number = read_u32(input)?;
+    let mut args = [0; 6];
+    for arg in &mut args {
+        *arg = read_u32(input)?;
+    }
+    Ok((number, args))
+}
+
+fn read_result(input: &mut impl Read) -> std::io::Result<(i64, Effects)> {
+    if read_u8(input)? != TAG_RESULT {
+        return Err(ErrorKind::InvalidData.into());
+    }
+    let result = read_i64(input)?;
+    let count = read_u32(input)?;
+    let mut effects = Vec::with_capacity(count as usize);
+    for _ in 0..count {
+        let addr = read_u32(input)? as usize;
+        let len = read_u32(input)? as usize;
+        let mut bytes = vec![0; len];
+        input.read_exact(&mut bytes)?;
+        effects.push((addr, bytes));
+    }
+    Ok((result, effects))
+}
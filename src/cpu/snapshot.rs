@@ -0,0 +1,374 @@
+// Process snapshots for `--snapshot` and `--restore`. A snapshot holds the
+// registers, the brk/TLS/stack bookkeeping, the entry points of every
+// translated block and each guest memory segment as a list of pages. Pages
+// are stored once however many times they occur, all-zero pages are not
+// stored at all, and the page pool is page-aligned so a restore maps it
+// copy-on-write instead of reading it.
+
+use std::{
+    collections::HashMap,
+    fs::{self, File},
+    io::{BufReader, Read, Write},
+    os::{fd::AsRawFd, unix::fs::FileExt},
+    sync::Arc,
+};
+
+use anyhow::{Context, Result, bail};
+use goblin::Object;
+
+use super::{
+    Cpu,
+    replay::{read_u8, read_u32},
+};
+use crate::{
+    loader::ElfFile,
+    memory::{MemoryData, MemoryImage, MemorySegment},
+    options::Options,
+    symbols::Symbols,
+};
+
+const MAGIC: &[u8; 4] = b"BHSN";
+const VERSION: u8 = 1;
+const PAGE_SIZE: usize = 4096;
+
+/// Page table entry for a page that is all zeros.
+const ZERO_PAGE: u64 = u64::MAX;
+
+/// Guest syscall that writes the `--snapshot` file at its return address.
+/// It returns 0 in the process that took the snapshot and 1 in a restored
+/// one, and -ENOSYS without `--snapshot`.
+pub(super) const SNAPSHOT_SYSCALL: u32 = 0x4253;
+
+fn read_u64(input: &mut impl Read) -> std::io::Result<u64> {
+    let mut buf = [0; 8];
+    input.read_exact(&mut buf)?;
+    Ok(u64::from_le_bytes(buf))
+}
+
+fn put_u32(out: &mut Vec<u8>, value: u32) {
+    out.extend_from_slice(&value.to_le_bytes());
+}
+
+fn put_u64(out: &mut Vec<u8>, value: u64) {
+    out.extend_from_slice(&value.to_le_bytes());
+}
+
+impl Cpu {
+    /// Arm `--snapshot-at`, given as an address or a function name.
+    pub(super) fn start_snapshot(&mut self) -> Result<()> {
+        let Some(at) = &self.options.snapshot_at else {
+            return Ok(());
+        };
+        if self.options.snapshot.is_none() {
+            bail!("--snapshot-at needs --snapshot PATH");
+        }
+        let pc = match at.strip_prefix("0x") {
+            Some(hex) => usize::from_str_radix(hex, 16).ok(),
+            None => self.symbols.starts().find(|&start| {
+                self.symbols
+                    .lookup(start)
+                    .is_some_and(|(name, _)| name == at)
+            }),
+        };
+        self.snapshot_at = pc.with_context(|| format!("--snapshot-at: no function {at:?}"))?;
+        Ok(())
+    }
+
+    /// The snapshot hypercall: have the run loop write the snapshot once
+    /// this syscall returns.
+    pub(super) fn sys_snapshot(&mut self) -> i64 {
+        if self.options.snapshot.is_none() {
+            return -(libc::ENOSYS as i64);
+        }
+        self.snapshot_requested = true;
+        0
+    }
+
+    /// Write the `--snapshot` file, with `blocks` as the translated code to
+    /// warm up on restore. Called by the run loop between blocks. A failed
+    /// snapshot does not stop the guest: the hypercall returns -errno
+    /// instead of 0, and `--snapshot-at` only warns.
+    pub(super) fn save_snapshot(&mut self, blocks: Vec<usize>) {
+        let requested = self.snapshot_requested;
+        if let Err(e) = self.write_snapshot(blocks) {
+            eprintln!("warning: {e:#}; continuing without a snapshot");
+            if requested {
+                let errno = e
+                    .root_cause()
+                    .downcast_ref::<std::io::Error>()
+                    .and_then(std::io::Error::raw_os_error)
+                    .unwrap_or(libc::EIO);
+                self.data_regs[0] = -errno as u32;
+            }
+        }
+    }
+
+    fn write_snapshot(&mut self, blocks: Vec<usize>) -> Result<()> {
+        let Some(path) = self.options.snapshot.clone() else {
+            return Ok(());
+        };
+        // A restored process learns from the hypercall's result that it was
+        // restored; `--snapshot-at` leaves the registers alone.
+        let d0 = if self.snapshot_requested {
+            1
+        } else {
+            self.data_regs[0]
+        };
+        self.snapshot_at = usize::MAX;
+        self.snapshot_requested = false;
+
+        let mut header = Vec::new();
+        header.extend_from_slice(MAGIC);
+        header.push(VERSION);
+        put_u32(&mut header, d0);
+        for &reg in self.data_regs[1..].iter().chain(&self.addr_regs) {
+            put_u32(&mut header, reg);
+        }
+        put_u32(&mut header, u32::from(self.sr));
+        for value in [
+            self.pc,
+            self.brk,
+            self.brk_base,
+            self.heap_segment_base,
+            self.stack_base,
+            self.tls_memsz,
+        ] {
+            put_u64(&mut header, value as u64);
+        }
+        put_u32(&mut header, self.tls_base);
+        header.push(u8::from(self.tls_initialized));
+        put_u32(&mut header, self.exe_path.len() as u32);
+        header.extend_from_slice(self.exe_path.as_bytes());
+        put_u32(&mut header, blocks.len() as u32);
+        for pc in blocks {
+            put_u32(&mut header, pc as u32);
+        }
+
+        // Pool offsets are relative to the start of the pool until the
+        // header's size is known.
+        let mut pool: Vec<&[u8]> = Vec::new();
+        let mut seen: HashMap<&[u8], u64> = HashMap::new();
+        let segments = self.memory.segments();
+        put_u32(&mut header, segments.len() as u32);
+        let mut tables = Vec::new();
+        for segment in segments {
+            if let MemoryData::Foreign { .. } = segment.data {
+                bail!(
+                    "cannot snapshot the shared memory segment at {:#x}",
+                    segment.vaddr
+                );
+            }
+            let bytes = segment.as_slice();
+            let mut table = Vec::new();
+            for page in bytes.chunks(PAGE_SIZE) {
+                if page.iter().all(|&b| b == 0) {
+                    table.push(ZERO_PAGE);
+                    continue;
+                }
+                let next = (pool.len() * PAGE_SIZE) as u64;
+                let offset = *seen.entry(page).or_insert_with(|| {
+                    pool.push(page);
+                    next
+                });
+                table.push(offset);
+            }
+            tables.push((segment, table));
+        }
+        let table_bytes: usize = tables.iter().map(|(_, t)| 16 + t.len() * 8).sum();
+        let pool_start = (header.len() + table_bytes).next_multiple_of(PAGE_SIZE) as u64;
+        for (segment, table) in tables {
+            for value in [
+                segment.vaddr,
+                segment.len(),
+                segment.flags as usize,
+                segment.align,
+            ] {
+                put_u32(&mut header, value as u32);
+            }
+            for offset in table {
+                let offset = match offset {
+                    ZERO_PAGE => ZERO_PAGE,
+                    offset => pool_start + offset,
+                };
+                put_u64(&mut header, offset);
+            }
+        }
+
+        let tmp = format!("{path}.tmp.{}", std::process::id());
+        let written = (|| -> std::io::Result<()> {
+            let mut file = File::create(&tmp)?;
+            file.write_all(&header)?;
+            for (index, page) in pool.iter().enumerate() {
+                file.write_all_at(page, pool_start + (index * PAGE_SIZE) as u64)?;
+            }
+            // A short last page still occupies a whole page of the pool.
+            file.set_len(pool_start + (pool.len() * PAGE_SIZE) as u64)?;
+            fs::rename(&tmp, &path)
+        })();
+        if written.is_err() {
+            let _ = fs::remove_file(&tmp);
+        }
+        written.with_context(|| format!("writing snapshot {path}"))?;
+        eprintln!(
+            "snapshot: {path} at {:#x}, {} unique pages",
+            self.pc,
+            pool.len()
+        );
+        Ok(())
+    }
+
+    /// Resume the process saved in the `--restore` file. Guest memory is
+    /// mapped from the file copy-on-write, and the blocks that were
+    /// translated when it was taken are translated again before the first
+    /// instruction.
+    pub fn restore(path: &str, options: Options) -> Result<Self> {
+        let file = Arc::new(File::open(path).with_context(|| format!("opening {path}"))?);
+        let mut input = BufReader::new(&*file);
+        let mut magic = [0; 4];
+        input
+            .read_exact(&mut magic)
+            .with_context(|| format!("reading {path}"))?;
+        if &magic != MAGIC {
+            bail!("{path}: not a behistun snapshot");
+        }
+        let version = read_u8(&mut input)?;
+        if version != VERSION {
+            bail!("{path}: snapshot version {version} (expected {VERSION})");
+        }
+        let mut regs = [0; 16];
+        for reg in &mut regs {
+            *reg = read_u32(&mut input)?;
+        }
+        let sr = read_u32(&mut input)? as u16;
+        let mut words = [0; 6];
+        for word in &mut words {
+            *word = read_u64(&mut input)? as usize;
+        }
+        let [pc, brk, brk_base, heap_segment_base, stack_base, tls_memsz] = words;
+        let tls_base = read_u32(&mut input)?;
+        let tls_initialized = read_u8(&mut input)? != 0;
+        let mut exe_path = vec![0; read_u32(&mut input)? as usize];
+        input.read_exact(&mut exe_path)?;
+        let exe_path = String::from_utf8(exe_path).context("snapshot executable path")?;
+        let blocks = (0..read_u32(&mut input)?)
+            .map(|_| read_u32(&mut input).map(|pc| pc as usize))
+            .collect::<std::io::Result<Vec<_>>>()?;
+
+        let mut segments = Vec::new();
+        for _ in 0..read_u32(&mut input)? {
+            let vaddr = read_u32(&mut input)? as usize;
+            let len = read_u32(&mut input)? as usize;
+            let flags = read_u32(&mut input)?;
+            let align = read_u32(&mut input)? as usize;
+            let table = (0..len.div_ceil(PAGE_SIZE))
+                .map(|_| read_u64(&mut input))
+                .collect::<std::io::Result<Vec<_>>>()?;
+            let data = map_pages(&file, len, &table)
+                .with_context(|| format!("mapping snapshot segment at {vaddr:#x}"))?;
+            segments.push(MemorySegment {
+                vaddr,
+                data,
+                flags,
+                align,
+            });
+        }
+        drop(input);
+
+        // Symbols only name code in profiles, so a missing binary is fine.
+        let symbols = ElfFile::open(&exe_path)
+            .ok()
+            .and_then(|data| match Object::parse(&data) {
+                Ok(Object::Elf(elf)) => Some(Symbols::from_elf(&elf)),
+                _ => None,
+            })
+            .unwrap_or_default();
+        let mut cpu = Self {
+            sr,
+            pc,
+            tls_base,
+            tls_initialized,
+            tls_memsz,
+            brk,
+            brk_base,
+            heap_segment_base,
+            stack_base,
+            exe_path,
+            ..Self::with_memory(MemoryImage::new(segments), options, Arc::new(symbols))
+        };
+        cpu.data_regs.copy_from_slice(&regs[..8]);
+        cpu.addr_regs.copy_from_slice(&regs[8..]);
+        cpu.start_tools()?;
+        cpu.profile_hints.get_or_insert_default().hot.extend(blocks);
+        Ok(cpu)
+    }
+}
+
+/// Guest memory for one snapshot segment: zero pages from an anonymous
+/// mapping, everything else mapped from the pool, one mapping per run of
+/// pages that are consecutive in the file.
+fn map_pages(file: &Arc<File>, len: usize, table: &[u64]) -> std::io::Result<MemoryData> {
+    // A segment that is one run from the pool can be mapped again later
+    // instead of copied; see `MemoryData::Mapped`.
+    let contiguous = table
+        .windows(2)
+        .all(|w| w[0] != ZERO_PAGE && w[1] == w[0] + PAGE_SIZE as u64);
+    if let Some(&first) = table.first()
+        && first != ZERO_PAGE
+        && contiguous
+    {
+        return MemoryData::map_file(Arc::clone(file), first, len);
+    }
+
+    // A zero-length mapping can't be made, or unmapped when dropped.
+    if len == 0 {
+        return Ok(MemoryData::Owned(Vec::new()));
+    }
+    let mapped = len.next_multiple_of(PAGE_SIZE);
+    // SAFETY: a fresh anonymous mapping aliases no Rust memory.
+    let base = unsafe {
+        libc::mmap(
+            std::ptr::null_mut(),
+            mapped,
+            libc::PROT_READ | libc::PROT_WRITE,
+            libc::MAP_PRIVATE | libc::MAP_ANONYMOUS,
+            -1,
+            0,
+        )
+    };
+    if base == libc::MAP_FAILED {
+        return Err(std::io::Error::last_os_error());
+    }
+    let data = MemoryData::Mapped {
+        ptr: base.cast(),
+        len,
+        source: None,
+    };
+    let mut page = 0;
+    while page < table.len() {
+        if table[page] == ZERO_PAGE {
+            page += 1;
+            continue;
+        }
+        let start = page;
+        while page + 1 < table.len() && table[page + 1] == table[page] + PAGE_SIZE as u64 {
+            page += 1;
+        }
+        page += 1;
+        // SAFETY: the target lies inside the anonymous mapping above, which
+        // `data` owns and nothing else references yet.
+        let ptr = unsafe {
+            libc::mmap(
+                base.cast::<u8>().add(start * PAGE_SIZE).cast(),
+                (page - start) * PAGE_SIZE,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE | libc::MAP_FIXED,
+                file.as_raw_fd(),
+                table[start] as libc::off_t,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error());
+        }
+    }
+    Ok(data)
+}
@@ -0,0 +1,292 @@
+use std::{collections::HashMap, fmt::Write as _, fs};
+
+use anyhow::{Context, Result};
+
+use crate::decoder::{
+    Abcd, Add, AddressingMode, Addx, And, BitOp, DataDir, DnToEa, EaToDn, EffectiveAddress, Exg,
+    Instruction, InstructionKind, MovepDirection, Or, Sbcd, Shift, Size, Sub, Subx,
+};
+
+/// Rows printed per table; the JSON output has every row.
+const REPORT_ROWS: usize = 40;
+
+/// Dynamic instruction mix for `--inst-stats`, only compiled in with the
+/// `stats` feature. Counts are kept per guest address and grouped by
+/// kind, operand shape and branch condition when the report is built.
+#[derive(Default)]
+pub(super) struct InstStats {
+    sites: HashMap<usize, Site>,
+}
+
+struct Site {
+    kind: InstructionKind,
+    count: u64,
+    /// Executions that left through something other than the fall-through.
+    taken: u64,
+}
+
+/// Operand shape: size and source/destination addressing mode classes.
+type Shape = (
+    Option<&'static str>,
+    Option<&'static str>,
+    Option<&'static str>,
+);
+
+impl InstStats {
+    /// Record a run of instructions that executed back to back, the last of
+    /// which continued at `next_pc`. Blocks laid out by branch bias can
+    /// take a branch before their last instruction, so each instruction is
+    /// checked against the address of the one after it.
+    pub(super) fn record(&mut self, insts: &[Instruction], next_pc: usize) {
+        let successors = insts.iter().skip(1).map(|inst| inst.address);
+        for (inst, next) in insts.iter().zip(successors.chain([next_pc])) {
+            let taken = next != inst.address + inst.len();
+            let site = self.site(inst);
+            site.count += 1;
+            site.taken += taken as u64;
+        }
+    }
+
+    fn site(&mut self, inst: &Instruction) -> &mut Site {
+        self.sites.entry(inst.address).or_insert_with(|| Site {
+            kind: inst.kind,
+            count: 0,
+            taken: 0,
+        })
+    }
+
+    fn tables(&self) -> Tables {
+        let mut tables = Tables::default();
+        for site in self.sites.values() {
+            let name = kind_name(&site.kind);
+            *tables.kinds.entry(name.clone()).or_default() += site.count;
+            *tables.shapes.entry((name, shape(&site.kind))).or_default() += site.count;
+            if let InstructionKind::Bcc { condition, .. } = site.kind {
+                let entry = tables.branches.entry(condition.to_string()).or_default();
+                entry.0 += site.taken;
+                entry.1 += site.count - site.taken;
+            }
+        }
+        tables.total = tables.kinds.values().sum();
+        tables
+    }
+
+    pub(super) fn report(&self) {
+        let tables = self.tables();
+        let pct = |n: u64| 100.0 * n as f64 / tables.total.max(1) as f64;
+
+        eprintln!("instruction mix: {} executed", tables.total);
+        for (name, count) in sorted(&tables.kinds).into_iter().take(REPORT_ROWS) {
+            eprintln!("  {name:<12} {count:>14} {:>6.2}%", pct(count));
+        }
+        eprintln!("by operand shape:");
+        for ((name, shape), count) in sorted(&tables.shapes).into_iter().take(REPORT_ROWS) {
+            eprintln!(
+                "  {:<28} {count:>14} {:>6.2}%",
+                format_shape(name, *shape),
+                pct(count)
+            );
+        }
+        eprintln!("bcc by condition (taken / not taken):");
+        let mut branches: Vec<_> = tables.branches.iter().collect();
+        branches.sort_by_key(|(_, (taken, not_taken))| std::cmp::Reverse(taken + not_taken));
+        for (cond, (taken, not_taken)) in branches {
+            eprintln!("  b{cond:<4} {taken:>14} {not_taken:>14}");
+        }
+    }
+
+    pub(super) fn write_json(&self, path: &str) -> Result<()> {
+        let tables = self.tables();
+        let mut out = String::new();
+        let _ = writeln!(out, "{{\n  \"total\": {},\n  \"kinds\": [", tables.total);
+        let rows: Vec<String> = sorted(&tables.kinds)
+            .into_iter()
+            .map(|(name, count)| format!("    {{\"kind\": \"{name}\", \"count\": {count}}}"))
+            .collect();
+        let _ = writeln!(out, "{}\n  ],\n  \"shapes\": [", rows.join(",\n"));
+        let opt = |s: Option<&str>| s.map_or("null".to_string(), |s| format!("\"{s}\""));
+        let rows: Vec<String> = sorted(&tables.shapes)
+            .into_iter()
+            .map(|((name, (size, src, dst)), count)| {
+                format!(
+                    "    {{\"kind\": \"{name}\", \"size\": {}, \"src\": {}, \"dst\": {}, \"count\": {count}}}",
+                    opt(*size),
+                    opt(*src),
+                    opt(*dst),
+                )
+            })
+            .collect();
+        let _ = writeln!(out, "{}\n  ],\n  \"bcc\": [", rows.join(",\n"));
+        let mut branches: Vec<_> = tables.branches.iter().collect();
+        branches.sort();
+        let rows: Vec<String> = branches
+            .into_iter()
+            .map(|(cond, (taken, not_taken))| {
+                format!(
+                    "    {{\"condition\": \"{cond}\", \"taken\": {taken}, \"not_taken\": {not_taken}}}"
+                )
+            })
+            .collect();
+        let _ = writeln!(out, "{}\n  ]\n}}", rows.join(",\n"));
+        fs::write(path, out).with_context(|| format!("writing instruction stats to {path}"))
+    }
+}
+
+#[derive(Default)]
+struct Tables {
+    total: u64,
+    kinds: HashMap<String, u64>,
+    shapes: HashMap<(String, Shape), u64>,
+    /// Condition -> (taken, not taken).
+    branches: HashMap<String, (u64, u64)>,
+}
+
+/// Entries by descending count, ties broken by key for stable output.
+fn sorted<K: Ord>(map: &HashMap<K, u64>) -> Vec<(&K, u64)> {
+    let mut rows: Vec<_> = map.iter().map(|(k, v)| (k, *v)).collect();
+    rows.sort_by(|a, b| b.1.cmp(&a.1).then(a.0.cmp(b.0)));
+    rows
+}
+
+/// Variant name, e.g. "Move" for `Move { .. }`.
+fn kind_name(kind: &InstructionKind) -> String {
+    let mut name = format!("{kind:?}");
+    let end = name
+        .find(|c: char| !c.is_ascii_alphanumeric())
+        .unwrap_or(name.len());
+    name.truncate(end);
+    name
+}
+
+fn sized(size: Size) -> Option<&'static str> {
+    Some(match size {
+        Size::Byte => "b",
+        Size::Word => "w",
+        Size::Long => "l",
+    })
+}
+
+fn format_shape(name: &str, (size, src, dst): Shape) -> String {
+    let mut s = name.to_string();
+    if let Some(size) = size {
+        let _ = write!(s, ".{size}");
+    }
+    let operands: Vec<&str> = [src, dst].into_iter().flatten().collect();
+    if !operands.is_empty() {
+        let _ = write!(s, " {}", operands.join(","));
+    }
+    s
+}
+
+fn ea(mode: &AddressingMode) -> Option<&'static str> {
+    Some(match mode.ea {
+        EffectiveAddress::Dr(_) => "Dn",
+        EffectiveAddress::Ar(_) => "An",
+        EffectiveAddress::Addr(_) => "(An)",
+        EffectiveAddress::AddrPostIncr(_) => "(An)+",
+        EffectiveAddress::AddrPreDecr(_) => "-(An)",
+        EffectiveAddress::AddrDisplace(_) => "(d,An)",
+        EffectiveAddress::AddrIndex(_) => "(d,An,Xn)",
+        EffectiveAddress::PCDisplace => "(d,PC)",
+        EffectiveAddress::PCIndex => "(d,PC,Xn)",
+        EffectiveAddress::AbsShort => "abs.w",
+        EffectiveAddress::AbsLong => "abs.l",
+        EffectiveAddress::Immediate => "#imm",
+    })
+}
+
+const DN: Option<&str> = Some("Dn");
+const AN: Option<&str> = Some("An");
+const IMM: Option<&str> = Some("#imm");
+const PREDEC: Option<&str> = Some("-(An)");
+
+fn ea_to_dn(op: &EaToDn) -> Shape {
+    (sized(op.size), ea(&op.src), DN)
+}
+
+fn dn_to_ea(op: &DnToEa) -> Shape {
+    (sized(op.size), DN, ea(&op.dst))
+}
+
+/// Size and source/destination addressing classes of an instruction.
+/// Operands that are always registers are reported as Dn/An.
+fn shape(kind: &InstructionKind) -> Shape {
+    use InstructionKind as K;
+    match kind {
+        K::Move { size, src, dst } => (sized(*size), ea(src), ea(dst)),
+        K::Movea { size, src, .. } => (sized(*size), ea(src), AN),
+        K::Moveq { .. } => (sized(Size::Long), IMM, DN),
+        K::Add(Add::EaToDn(op))
+        | K::Sub(Sub::EaToDn(op))
+        | K::And(And::EaToDn(op))
+        | K::Or(Or::EaToDn(op))
+        | K::Cmp(op) => ea_to_dn(op),
+        K::Add(Add::DnToEa(op))
+        | K::Sub(Sub::DnToEa(op))
+        | K::And(And::DnToEa(op))
+        | K::Or(Or::DnToEa(op))
+        | K::Eor(op) => dn_to_ea(op),
+        K::Adda { size, mode, .. } | K::Suba { size, mode, .. } => (sized(*size), ea(mode), AN),
+        K::Cmpa { size, src, .. } => (sized(*size), ea(src), AN),
+        K::Addx(Addx::Dn(op)) | K::Subx(Subx::Dn(op)) => (sized(op.size), DN, DN),
+        K::Addx(Addx::PreDec(op)) | K::Subx(Subx::PreDec(op)) => (sized(op.size), PREDEC, PREDEC),
+        K::Abcd(Abcd::Dn { .. }) | K::Sbcd(Sbcd::Dn { .. }) => (sized(Size::Byte), DN, DN),
+        K::Abcd(Abcd::PreDec { .. }) | K::Sbcd(Sbcd::PreDec { .. }) => {
+            (sized(Size::Byte), PREDEC, PREDEC)
+        }
+        K::Addi(op) | K::Subi(op) | K::Andi(op) | K::Ori(op) | K::Eori(op) | K::Cmpi(op) => {
+            (sized(op.size), IMM, ea(&op.mode))
+        }
+        K::Addq(op) | K::Subq(op) => (sized(op.size), IMM, ea(&op.mode)),
+        K::Clr(op) | K::Neg(op) | K::Negx(op) | K::Not(op) => (sized(op.size), None, ea(&op.mode)),
+        K::Tst { size, mode } => (sized(*size), ea(mode), None),
+        K::Asd(shift) | K::Lsd(shift) | K::Roxd(shift) | K::Rod(shift) => match shift {
+            Shift::Ea(op) => (sized(Size::Word), None, ea(&op.mode)),
+            Shift::Reg(op) => (sized(op.size), None, DN),
+        },
+        K::Btst(op) | K::Bchg(op) | K::Bclr(op) | K::Bset(op) => match op {
+            BitOp::Imm(op) => (None, IMM, ea(&op.mode)),
+            BitOp::Reg(op) => (None, DN, ea(&op.mode)),
+        },
+        K::Mulu { src, .. } | K::Muls { src, .. } | K::Divu { src, .. } | K::Divs { src, .. } => {
+            (sized(Size::Word), ea(src), DN)
+        }
+        K::MuluL { src, .. }
+        | K::MulsL { src, .. }
+        | K::DivuL { src, .. }
+        | K::DivsL { src, .. } => (sized(Size::Long), ea(src), DN),
+        K::Lea { src, .. } => (None, ea(src), AN),
+        K::Pea { mode } | K::Jsr { mode } | K::Jmp { mode } => (None, ea(mode), None),
+        K::Scc { mode, .. } | K::Tas { mode } | K::Nbcd { mode } => {
+            (sized(Size::Byte), None, ea(mode))
+        }
+        K::Movem(op) => match op.direction {
+            DataDir::RegToMem => (sized(op.size), None, ea(&op.mode)),
+            DataDir::MemToReg => (sized(op.size), ea(&op.mode), None),
+        },
+        K::Movep(op) => match op.direction {
+            MovepDirection::MemToReg => (sized(op.size), Some("(d,An)"), DN),
+            MovepDirection::RegToMem => (sized(op.size), DN, Some("(d,An)")),
+        },
+        K::Exg(exg) => match exg {
+            Exg::DataData { .. } => (sized(Size::Long), DN, DN),
+            Exg::AddrAddr { .. } => (sized(Size::Long), AN, AN),
+            Exg::DataAddr { .. } => (sized(Size::Long), DN, AN),
+        },
+        K::Cmpm { size, .. } => (sized(*size), Some("(An)+"), Some("(An)+")),
+        K::Chk { size, src, .. } => (sized(*size), ea(src), DN),
+        K::Cas { size, mode, .. } => (sized(*size), DN, ea(mode)),
+        K::Cmp2 { size, mode, .. } | K::Chk2 { size, mode, .. } => (sized(*size), ea(mode), None),
+        K::Bftst { mode, .. }
+        | K::Bfchg { mode, .. }
+        | K::Bfclr { mode, .. }
+        | K::Bfset { mode, .. } => (None, None, ea(mode)),
+        K::Bfextu { src, .. } | K::Bfexts { src, .. } | K::Bfffo { src, .. } => (None, ea(src), DN),
+        K::Bfins { dst, .. } => (None, DN, ea(dst)),
+        K::MoveFromSr { dst } => (sized(Size::Word), None, ea(dst)),
+        K::MoveToCcr { src } | K::MoveToSr { src } => (sized(Size::Word), ea(src), None),
+        K::Swap { .. } | K::Ext { .. } => (None, None, DN),
+        K::Link { .. } | K::Unlk { .. } => (None, None, AN),
+        _ => (None, None, None),
+    }
+}
@@ -11,4 +11,14 @@ impl Cpu {
 
         Ok(unsafe { libc::syscall(syscall_num as i64, path_cstr.as_ptr(), extra_arg) })
     }
+
+    /// `sys_path1` for syscalls that only look the path up, such as access,
+    /// which see files under `--sysroot`.
+    pub(crate) fn sys_lookup_path1(&mut self, syscall_num: u32, extra_arg: i64) -> Result<i64> {
+        let path_addr = self.data_regs[1] as usize;
+        let path_cstr = self.guest_cstring(path_addr)?;
+        let path_cstr = self.sysroot_path(&path_cstr, true);
+
+        Ok(unsafe { libc::syscall(syscall_num as i64, path_cstr.as_ptr(), extra_arg) })
+    }
 }
@@ -3,8 +3,10 @@ pub mod llseek;
 pub mod pipe;
 pub mod pread64;
 pub mod preadv;
+pub mod preadv2;
 pub mod pwrite64;
 pub mod pwritev;
+pub mod pwritev2;
 pub mod read;
 pub mod readv;
 pub mod sendfile;
@@ -0,0 +1,21 @@
+use anyhow::Result;
+
+use crate::Cpu;
+
+impl Cpu {
+    /// pwritev2(fd, iov, iovcnt, pos_l, pos_h, flags)
+    /// An offset of -1 writes at the file position, like writev.
+    pub(crate) fn sys_pwritev2(&mut self) -> Result<i64> {
+        let fd = self.data_regs[1] as i32;
+        let iov_addr = self.data_regs[2] as usize;
+        let iovcnt = self.data_regs[3] as usize;
+        let off_lo = self.data_regs[4] as i64;
+        let off_hi = self.data_regs[5] as i64;
+        let offset = (off_hi << 32) | off_lo;
+        let flags = self.data_regs[6] as i32;
+        let iovecs = self.build_iovecs(iov_addr, iovcnt, false)?;
+        let result =
+            unsafe { libc::pwritev2(fd, iovecs.as_ptr(), iovecs.len() as i32, offset, flags) };
+        Ok(Self::libc_to_kernel(result as i64))
+    }
+}
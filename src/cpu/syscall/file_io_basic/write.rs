@@ -3,12 +3,20 @@ use anyhow::Result;
 use crate::Cpu;
 
 impl Cpu {
-    pub(crate) fn sys_write(&self) -> Result<i64> {
+    pub(crate) fn sys_write(&mut self) -> Result<i64> {
         let fd = self.data_regs[1] as i32;
         let buf = self.data_regs[2] as usize;
         let count = self.data_regs[3] as usize;
 
         let host_ptr = self.guest_const_ptr(buf, count)?;
+        if self.output.is_some() {
+            // SAFETY: `guest_const_ptr` checked `count` bytes of guest
+            // memory, which nothing changes during the copy.
+            let data = unsafe { std::slice::from_raw_parts(host_ptr.cast::<u8>(), count) };
+            if self.buffer_write(fd, data) {
+                return Ok(count as i64);
+            }
+        }
 
         let result = unsafe { libc::write(fd, host_ptr, count) as i64 };
         Ok(Self::libc_to_kernel(result))
@@ -10,6 +10,7 @@ impl Cpu {
         let flags = self.data_regs[4] as i32;
 
         let path_cstr = self.guest_cstring(path_addr)?;
+        let path_cstr = self.sysroot_path(&path_cstr, flags & libc::AT_SYMLINK_NOFOLLOW == 0);
         let mut stat: libc::stat = unsafe { std::mem::zeroed() };
         let result = unsafe {
             libc::syscall(
@@ -8,6 +8,7 @@ impl Cpu {
         let path_addr = self.data_regs[1] as usize;
         let buf_addr = self.data_regs[2] as usize;
         let path = self.guest_cstring(path_addr)?;
+        let path = self.sysroot_path(&path, syscall_num != libc::SYS_lstat as u32);
         let mut stat: libc::stat = unsafe { std::mem::zeroed() };
         let result = unsafe { libc::syscall(syscall_num as i64, path.as_ptr(), &mut stat) };
         if result == 0 {
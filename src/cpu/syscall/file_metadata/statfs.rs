@@ -8,6 +8,7 @@ impl Cpu {
         let path_addr = self.data_regs[1] as usize;
         let buf_addr = self.data_regs[2] as usize;
         let path = self.guest_cstring(path_addr)?;
+        let path = self.sysroot_path(&path, true);
         let mut statfs: libc::statfs = unsafe { std::mem::zeroed() };
         let result = unsafe { libc::statfs(path.as_ptr(), &mut statfs) };
         if result == 0 {
@@ -12,6 +12,7 @@ impl Cpu {
         let statxbuf_addr = self.data_regs[5] as usize;
 
         let pathname = self.guest_cstring(pathname_addr)?;
+        let pathname = self.sysroot_path(&pathname, flags & libc::AT_SYMLINK_NOFOLLOW == 0);
 
         // Allocate statx buffer
         let mut statxbuf: libc::statx = unsafe { std::mem::zeroed() };
@@ -4,13 +4,14 @@ use crate::Cpu;
 
 impl Cpu {
     /// faccessat(dirfd, path, mode, flags)
-    pub(crate) fn sys_faccessat(&self) -> Result<i64> {
+    pub(crate) fn sys_faccessat(&mut self) -> Result<i64> {
         let dirfd = self.data_regs[1] as i32;
         let path_addr = self.data_regs[2] as usize;
         let mode = self.data_regs[3] as i32;
         let flags = self.data_regs[4] as i32;
 
         let path_cstr = self.guest_cstring(path_addr)?;
+        let path_cstr = self.sysroot_path(&path_cstr, flags & libc::AT_SYMLINK_NOFOLLOW == 0);
         let result = unsafe { libc::faccessat(dirfd, path_cstr.as_ptr(), mode, flags) as i64 };
         Ok(Self::libc_to_kernel(result))
     }
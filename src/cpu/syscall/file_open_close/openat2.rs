@@ -5,7 +5,7 @@ use crate::Cpu;
 impl Cpu {
     /// openat2(dirfd, path, how, size)
     /// Extended version of openat with struct open_how for additional control
-    pub(crate) fn sys_openat2(&self) -> Result<i64> {
+    pub(crate) fn sys_openat2(&mut self) -> Result<i64> {
         let dirfd = self.data_regs[1] as i32;
         let path_addr = self.data_regs[2] as usize;
         let how_addr = self.data_regs[3] as usize;
@@ -26,6 +26,7 @@ impl Cpu {
 
         // Translate flags from m68k to host
         let host_flags = Self::translate_open_flags(m68k_flags as i32) as u64;
+        let path_cstr = self.sysroot_open_path(&path_cstr, host_flags as i32);
 
         // Build host open_how structure
         #[repr(C)]
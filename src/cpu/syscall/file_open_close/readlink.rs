@@ -22,6 +22,7 @@ impl Cpu {
             return Ok(copy_len as i64);
         }
 
+        let path = self.sysroot_path(&path, false);
         Ok(unsafe { libc::readlink(path.as_ptr(), host_buf as *mut i8, size) as i64 })
     }
 }
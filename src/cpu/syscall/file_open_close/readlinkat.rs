@@ -11,6 +11,7 @@ impl Cpu {
         let bufsiz = self.data_regs[4] as usize;
 
         let path_cstr = self.guest_cstring(path_addr)?;
+        let path_cstr = self.sysroot_path(&path_cstr, false);
         let host_buf = self
             .memory
             .guest_to_host_mut(buf_addr, bufsiz)
@@ -3,6 +3,7 @@ pub mod mincore;
 pub mod mmap;
 pub mod mmap2;
 pub mod mprotect;
+pub mod munmap;
 pub mod pkey_alloc;
 pub mod pkey_free;
 pub mod pkey_mprotect;
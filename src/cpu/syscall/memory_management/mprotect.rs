@@ -1,13 +1,13 @@
 use anyhow::{Result, anyhow};
 
-use crate::Cpu;
+use crate::{Cpu, cpu::syscall::prot_flags};
 
 impl Cpu {
     /// mprotect(addr, len, prot)
-    pub(crate) fn sys_mprotect(&self) -> Result<i64> {
+    pub(crate) fn sys_mprotect(&mut self) -> Result<i64> {
         let addr = self.data_regs[1] as usize;
         let len = self.data_regs[2] as usize;
-        let _prot = self.data_regs[3] as i32;
+        let prot = self.data_regs[3] as i32;
 
         // Validate that the memory range exists
         // For now, just check if we can access the start and end
@@ -24,8 +24,15 @@ impl Cpu {
             }
         }
 
-        // Just return success - we don't actually change protection bits
-        // since the memory is already accessible to the guest
+        // Code written into the range may be about to run.
+        if prot & libc::PROT_EXEC != 0 {
+            self.invalidate_code(addr..addr.saturating_add(len), true);
+        }
+
+        // Grant what was asked for, e.g. to the PROT_NONE reservation a
+        // dynamic loader maps libraries into. Nothing is revoked since the
+        // memory was already accessible to the guest.
+        self.memory.protect(addr, len, prot_flags(prot));
         Ok(0)
     }
 }
@@ -0,0 +1,25 @@
+use crate::Cpu;
+
+impl Cpu {
+    /// munmap(addr, length)
+    /// Guest mappings live in the memory image, so this never reaches the
+    /// host.
+    pub(crate) fn sys_munmap(&mut self) -> i64 {
+        let (addr, length): (u32, u32) = self.get_args();
+        let (addr, length) = (addr as usize, length as usize);
+        if !addr.is_multiple_of(4096) || length == 0 {
+            return -(libc::EINVAL as i64);
+        }
+        self.invalidate_code(addr..addr.saturating_add(length), false);
+        self.memory.unmap(addr, length.next_multiple_of(4096));
+        0
+    }
+
+    /// mremap(old_addr, old_size, new_size, flags, new_addr)
+    pub(crate) fn sys_mremap(&mut self, x86_num: u32) -> i64 {
+        let (addr, old_size): (u32, u32) = self.get_args();
+        let addr = addr as usize;
+        self.invalidate_code(addr..addr.saturating_add(old_size as usize), false);
+        self.sys_passthrough(x86_num, 5)
+    }
+}
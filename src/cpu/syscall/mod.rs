@@ -22,12 +22,33 @@ mod thread_and_tls;
 mod timers_and_clocks;
 mod user_identity;
 
-use std::ffi::CString;
+use std::{
+    ffi::CString,
+    fs::File,
+    io,
+    os::{fd::FromRawFd, unix::fs::FileExt},
+    sync::Arc,
+    time::Instant,
+};
 
 use anyhow::{Result, anyhow, bail};
 
-use super::{Cpu, M68K_TLS_TCB_SIZE, TLS_DATA_PAD};
-use crate::syscall::m68k_to_x86_64_syscall;
+use super::{Cpu, M68K_TLS_TCB_SIZE, TLS_DATA_PAD, snapshot::SNAPSHOT_SYSCALL};
+use crate::{
+    memory::{MemoryData, MemorySegment},
+    syscall::m68k_to_x86_64_syscall,
+};
+pub(super) use sockets::mmsg::MsgArena;
+
+/// What an mmap or mmap2 call asks for; `file` is (fd, offset in bytes)
+/// unless the mapping is anonymous.
+pub(super) struct MmapRequest {
+    pub(super) addr: usize,
+    pub(super) length: usize,
+    pub(super) prot: i32,
+    pub(super) flags: i32,
+    pub(super) file: Option<(i32, u64)>,
+}
 
 impl Cpu {
     /// Read syscall arguments from D1..D6 as a typed tuple.
@@ -37,6 +58,34 @@ impl Cpu {
 
     pub(super) fn handle_syscall(&mut self) -> Result<()> {
         let m68k_num = self.data_regs[0];
+        self.syscalls += 1;
+        let start = (self.syscall_stats.is_some() || self.metrics.is_some()).then(Instant::now);
+        if let Some(trace) = &mut self.trace {
+            trace.syscall(m68k_num, &self.data_regs[1..7]);
+        }
+
+        let result = match self.replay_syscall(m68k_num)? {
+            Some(result) => result,
+            None => {
+                self.flush_output_for(m68k_num);
+                let result = self.dispatch_syscall(m68k_num)?;
+                self.refresh_output(m68k_num);
+                self.log_syscall_result(m68k_num, result)?;
+                result
+            }
+        };
+
+        if let Some(start) = start {
+            let elapsed = start.elapsed();
+            self.record_syscall(m68k_num, elapsed, result);
+            self.metrics_syscall(m68k_num, elapsed);
+        }
+        self.trace_result(m68k_num, result);
+        self.data_regs[0] = result as u32;
+        Ok(())
+    }
+
+    fn dispatch_syscall(&mut self, m68k_num: u32) -> Result<i64> {
         let x86_num = m68k_to_x86_64_syscall(m68k_num).unwrap_or_default();
 
         // m68k Linux ABI: D0=syscall, D1-D5=args
@@ -143,7 +192,7 @@ impl Cpu {
             32 => -1,
 
             // access(path, mode) - path is pointer
-            33 => self.sys_path1(x86_num, self.data_regs[2] as i64)?,
+            33 => self.sys_lookup_path1(x86_num, self.data_regs[2] as i64)?,
 
             // nice(incr)
             34 => bail!("nice not yet implemented"),
@@ -324,7 +373,7 @@ impl Cpu {
             90 => self.sys_mmap()?,
 
             // munmap(addr, length) - no pointers (addr is value)
-            91 => self.sys_passthrough(x86_num, 2),
+            91 => self.sys_munmap(),
 
             // truncate(path, length) - path pointer
             92 => self.sys_path1(x86_num, self.data_regs[2] as i64)?,
@@ -550,7 +599,7 @@ impl Cpu {
             162 => self.sys_nanosleep()?,
 
             // mremap(old_addr, old_size, new_size, flags, new_addr) - no pointers
-            163 => self.sys_passthrough(x86_num, 5),
+            163 => self.sys_mremap(x86_num),
 
             // setresuid(ruid, euid, suid) - no pointers
             164 => self.sys_passthrough(x86_num, 3),
@@ -801,7 +850,7 @@ impl Cpu {
             246 => self.sys_passthrough(x86_num, 4),
 
             // exit_group(status)
-            247 => self.sys_passthrough(x86_num, 1),
+            247 => self.sys_exit_group(x86_num),
 
             // lookup_dcookie(cookie, buffer, len)
             248 => bail!("lookup_dcookie not yet implemented"),
@@ -1171,10 +1220,10 @@ impl Cpu {
             370 => self.sys_passthrough(x86_num, 2),
 
             // recvmmsg(sockfd, msgvec, vlen, flags, timeout)
-            371 => bail!("recvmmsg not yet implemented"),
+            371 => self.sys_recvmmsg(false)?,
 
             // sendmmsg(sockfd, msgvec, vlen, flags)
-            372 => bail!("sendmmsg not yet implemented"),
+            372 => self.sys_sendmmsg()?,
 
             // userfaultfd(flags)
             373 => bail!("userfaultfd not yet implemented"),
@@ -1188,11 +1237,11 @@ impl Cpu {
             // copy_file_range(fd_in, off_in, fd_out, off_out, len, flags) - m68k 376
             376 => self.sys_copy_file_range()?,
 
-            // preadv2(fd, iov, iovcnt, offset, flags)
-            377 => bail!("preadv2 not yet implemented"),
+            // preadv2(fd, iov, iovcnt, pos_l, pos_h, flags)
+            377 => self.sys_preadv2()?,
 
-            // pwritev2(fd, iov, iovcnt, offset, flags)
-            378 => bail!("pwritev2 not yet implemented"),
+            // pwritev2(fd, iov, iovcnt, pos_l, pos_h, flags)
+            378 => self.sys_pwritev2()?,
 
             // statx(dirfd, pathname, flags, mask, statxbuf) - m68k 379
             379 => self.sys_statx()?,
@@ -1282,7 +1331,7 @@ impl Cpu {
             416 => bail!("io_pgetevents_time64 not yet implemented"),
 
             // recvmmsg_time64(sockfd, msgvec, vlen, flags, timeout)
-            417 => bail!("recvmmsg_time64 not yet implemented"),
+            417 => self.sys_recvmmsg(true)?,
 
             // mq_timedsend_time64 - m68k 418 (same as mq_timedsend, already handles 64-bit time_t)
             418 => self.sys_mq_timedsend()?,
@@ -1437,12 +1486,13 @@ impl Cpu {
             // file_setattr(dirfd, path, *fsx, size, at_flags)
             469 => bail!("file_setattr not yet implemented"),
 
+            // behistun's snapshot hypercall
+            SNAPSHOT_SYSCALL => self.sys_snapshot(),
+
             // For syscalls with no pointer args, passthrough directly
             syscall_num => bail!("Unsupported syscall number: {syscall_num}"),
         };
-
-        self.data_regs[0] = result as u32;
-        Ok(())
+        Ok(result)
     }
 
     /// Set thread area
@@ -1653,6 +1703,19 @@ impl Cpu {
         writable: bool,
     ) -> Result<Vec<libc::iovec>> {
         let mut iovecs = Vec::with_capacity(count);
+        self.append_iovecs(&mut iovecs, base_addr, count, writable)?;
+        Ok(iovecs)
+    }
+
+    /// Resolve the guest iovec array at `base_addr` to host iovecs on the
+    /// end of `iovecs`.
+    fn append_iovecs(
+        &mut self,
+        iovecs: &mut Vec<libc::iovec>,
+        base_addr: usize,
+        count: usize,
+        writable: bool,
+    ) -> Result<()> {
         for i in 0..count {
             let entry = base_addr + i * 8;
             let iov_base = self.memory.read_long(entry)? as usize;
@@ -1681,15 +1744,79 @@ impl Cpu {
                 iov_len,
             });
         }
-        Ok(iovecs)
+        Ok(())
     }
 
-    fn alloc_anonymous_mmap(&mut self, req_addr: usize, length: usize, prot: i32) -> Result<usize> {
-        use crate::memory::MemorySegment;
-        use goblin::elf::program_header;
+    /// The mapping an mmap (90) or mmap2 (192) call asks for, or `None`
+    /// for any other syscall.
+    pub(super) fn mmap_request(&self, number: u32) -> Result<Option<MmapRequest>> {
+        let (addr, length, prot, flags, fd, offset) = match number {
+            // old_mmap passes a pointer to mmap_arg_struct
+            //   { void *addr; u32 len; u32 prot; u32 flags; u32 fd; u32 offset; }
+            // with the offset in bytes.
+            90 => {
+                let args_ptr = self.data_regs[1] as usize;
+                let mut args = [0u32; 6];
+                for (i, arg) in args.iter_mut().enumerate() {
+                    *arg = self.memory.read_long(args_ptr + i * 4)?;
+                }
+                let [addr, length, prot, flags, fd, offset] = args;
+                (addr, length, prot, flags, fd, offset as u64)
+            }
+            // mmap2 passes the offset in 4096-byte pages.
+            192 => {
+                let [addr, length, prot, flags, fd, pgoffset]: [u32; 6] =
+                    self.data_regs[1..7].try_into().unwrap();
+                (addr, length, prot, flags, fd, pgoffset as u64 * 4096)
+            }
+            _ => return Ok(None),
+        };
+        let (flags, fd) = (flags as i32, fd as i32);
+        let is_anonymous = flags & libc::MAP_ANONYMOUS != 0 || fd == -1;
+        Ok(Some(MmapRequest {
+            addr: addr as usize,
+            length: length as usize,
+            prot: prot as i32,
+            flags,
+            file: (!is_anonymous).then_some((fd, offset)),
+        }))
+    }
 
+    /// Back a guest mmap with a new segment: zero pages, or a private
+    /// copy-on-write mapping of `file` = (fd, offset) as the dynamic
+    /// loader uses for shared libraries. MAP_FIXED replaces whatever was
+    /// mapped there; otherwise `req_addr` is only a hint.
+    pub(super) fn alloc_mmap(
+        &mut self,
+        req_addr: usize,
+        length: usize,
+        prot: i32,
+        flags: i32,
+        file: Option<(i32, u64)>,
+    ) -> Result<i64> {
         let aligned_len = (length + 4095) & !4095;
-        let addr = if req_addr != 0 {
+        let fixed = flags & libc::MAP_FIXED != 0;
+        if length == 0 || (fixed && !req_addr.is_multiple_of(4096)) {
+            return Ok(-(libc::EINVAL as i64));
+        }
+
+        let data = match file {
+            None => MemoryData::Owned(vec![0u8; aligned_len]),
+            // Writes to a shared mapping would never reach the file.
+            Some(_) if flags & libc::MAP_SHARED != 0 && prot & libc::PROT_WRITE != 0 => {
+                return Ok(-(libc::ENODEV as i64));
+            }
+            Some((_, offset)) if !offset.is_multiple_of(4096) => return Ok(-(libc::EINVAL as i64)),
+            Some((fd, offset)) => match map_guest_file(fd, offset, aligned_len) {
+                Ok(data) => data,
+                Err(e) => return Ok(-(e.raw_os_error().unwrap_or(libc::EIO) as i64)),
+            },
+        };
+
+        let addr = if fixed {
+            self.memory.unmap_fixed(req_addr, aligned_len);
+            req_addr
+        } else if req_addr != 0 && self.memory.is_free(req_addr, aligned_len) {
             req_addr
         } else {
             self.memory
@@ -1697,25 +1824,22 @@ impl Cpu {
                 .ok_or_else(|| anyhow!("mmap: no free address range for {aligned_len} bytes"))?
         };
 
-        let mut elf_flags = 0u32;
-        if prot & 0x1 != 0 {
-            elf_flags |= program_header::PF_R;
-        }
-        if prot & 0x2 != 0 {
-            elf_flags |= program_header::PF_W;
-        }
-        if prot & 0x4 != 0 {
-            elf_flags |= program_header::PF_X;
-        }
-
         self.memory.add_segment(MemorySegment {
             vaddr: addr,
-            data: crate::memory::MemoryData::Owned(vec![0u8; aligned_len]),
-            flags: elf_flags,
+            data,
+            flags: prot_flags(prot),
             align: 4096,
         });
+        if prot & 0x4 != 0 || fixed {
+            self.invalidate_code(addr..addr + aligned_len, true);
+        }
+        if file.is_some() {
+            // A replay has no file to map; it gets these bytes from the log.
+            self.memory.journal_range(addr, aligned_len);
+        }
+        self.mmap_bytes += aligned_len as u64;
 
-        Ok(addr)
+        Ok(addr as i64)
     }
 
     fn read_itimerval(&self, addr: usize) -> Result<libc::itimerval> {
@@ -1961,7 +2085,6 @@ impl Cpu {
 
     /// Write a u64 to big-endian m68k memory
     /// m68k stores u64 as two consecutive u32 values in big-endian order
-    #[allow(unused)]
     fn write_u64_be(&mut self, addr: usize, value: u64) -> Result<()> {
         let hi = (value >> 32) as u32;
         let lo = value as u32;
@@ -2075,3 +2198,47 @@ impl_from_regs! {
     A, B, C, D, E;
     A, B, C, D, E, F;
 }
+
+/// Segment flags for mmap/mprotect `prot` bits. Executable memory is also
+/// writable, like code loaded from the binary, so code that patches itself
+/// keeps working.
+pub(super) fn prot_flags(prot: i32) -> u32 {
+    use goblin::elf::program_header::{PF_R, PF_W, PF_X};
+
+    let mut flags = 0;
+    if prot & libc::PROT_READ != 0 {
+        flags |= PF_R;
+    }
+    if prot & libc::PROT_WRITE != 0 {
+        flags |= PF_W;
+    }
+    if prot & libc::PROT_EXEC != 0 {
+        flags |= PF_X | PF_W;
+    }
+    flags
+}
+
+/// `len` bytes of the guest's open file `fd` from `offset`, mapped from the
+/// host file so that every process running a library shares its clean
+/// pages. The mapping holds its own descriptor, since the guest may close
+/// `fd` straight away.
+fn map_guest_file(fd: i32, offset: u64, len: usize) -> io::Result<MemoryData> {
+    // SAFETY: F_DUPFD_CLOEXEC only reads `fd` and returns a new descriptor.
+    let dup = unsafe { libc::fcntl(fd, libc::F_DUPFD_CLOEXEC, 0) };
+    if dup < 0 {
+        return Err(io::Error::last_os_error());
+    }
+    // SAFETY: `dup` is a fresh descriptor nothing else owns.
+    let file = unsafe { File::from_raw_fd(dup) };
+    let size = file.metadata()?.len();
+    if offset + len as u64 <= size.next_multiple_of(4096) {
+        return MemoryData::map_file(Arc::new(file), offset, len);
+    }
+    // Whole pages past the end of the file would fault on the host, so a
+    // mapping that runs over the end (or of a device like /dev/zero) is
+    // read instead.
+    let mut data = vec![0u8; len];
+    let available = size.saturating_sub(offset).min(len as u64) as usize;
+    file.read_exact_at(&mut data[..available], offset)?;
+    Ok(MemoryData::Owned(data))
+}
@@ -1,9 +1,10 @@
 use anyhow::{Result, anyhow, bail};
 use goblin::{Object, elf::program_header};
-use std::fs;
+use std::{ffi::OsStr, os::unix::ffi::OsStrExt, sync::Arc};
 
 use crate::Cpu;
 use crate::cpu::{ElfInfo, M68K_TLS_TCB_SIZE, align_up};
+use crate::loader::{ElfFile, load_memory_image};
 
 impl Cpu {
     /// execve(filename, argv, envp)
@@ -36,7 +37,8 @@ impl Cpu {
         };
 
         // Load the new ELF binary
-        let data = fs::read(filename).map_err(|e| anyhow!("failed to read {}: {}", filename, e))?;
+        let host_filename = self.sysroot_path(&filename_cstr, true);
+        let data = ElfFile::open(OsStr::from_bytes(host_filename.to_bytes()))?;
 
         let elf = match Object::parse(&data)? {
             Object::Elf(elf) => elf,
@@ -46,38 +48,20 @@ impl Cpu {
         };
 
         // Load the new memory image
-        let new_memory = crate::loader::load_memory_image(&elf, &data)?;
+        let new_memory = load_memory_image(&elf, &data)?;
+        let elf_info = ElfInfo::from_elf(&elf);
 
-        // Find where program headers are loaded in memory
-        let first_load_vaddr = elf
-            .program_headers
-            .iter()
-            .find(|ph| ph.p_type == program_header::PT_LOAD)
-            .map(|ph| ph.p_vaddr)
-            .unwrap_or(0x80000000);
-
-        let phdr_addr = first_load_vaddr + elf.header.e_phoff;
-
-        let elf_info = ElfInfo {
-            entry_point: elf.entry as u32,
-            phdr_addr: phdr_addr as u32,
-            phent_size: elf.header.e_phentsize as u32,
-            phnum: elf.header.e_phnum as u32,
-            tls_vaddr: elf
-                .program_headers
-                .iter()
-                .find(|ph| ph.p_type == program_header::PT_TLS)
-                .map(|ph| ph.p_vaddr as u32),
-            tls_memsz: elf
-                .program_headers
-                .iter()
-                .find(|ph| ph.p_type == program_header::PT_TLS)
-                .map(|ph| ph.p_memsz as u32)
-                .unwrap_or(0),
-        };
-
-        // Replace memory and reset CPU state
+        // Replace memory and reset CPU state. Samples so far belong to the
+        // old image, so name them with its symbols first.
+        if let Some(profiler) = &mut self.profiler {
+            profiler.resolve(&self.symbols);
+        }
+        self.save_block_profile();
+        self.symbols = Arc::clone(&elf_info.symbols);
         self.memory = new_memory;
+        if let Some(trace) = &mut self.trace {
+            trace.exec(filename);
+        }
 
         // Reset registers
         self.data_regs = [0; 8];
@@ -151,15 +135,13 @@ impl Cpu {
         }
 
         // Set up the initial stack with new argc/argv/envp
-        self.setup_initial_stack(&argv, &elf_info)?;
-
-        // execve doesn't return on success - it replaces the current process
-        // We need to restart execution with the new memory image
-        // The decoder in run_jit() has a clone of the old memory, so we need to
-        // restart the run loop to create a new decoder with the new memory
-        self.run_jit()?;
-
-        // If run_jit returns (program exited), we should exit this process too
-        std::process::exit(0);
+        let interp_base = self.load_interpreter(&elf_info)?;
+        self.setup_initial_stack(&argv, &elf_info, interp_base)?;
+
+        // execve doesn't return on success. Translations of the old image are
+        // all stale; the run loop flushes them and reloads the decoder from
+        // the new memory before running the new entry point.
+        self.invalidate_code(0..usize::MAX, true);
+        Ok(0)
     }
 }
@@ -4,6 +4,13 @@ impl Cpu {
     pub(crate) fn sys_exit(&mut self) -> ! {
         let (exit_code,): (i32,) = self.get_args();
 
+        self.report_exit_stats();
         std::process::exit(exit_code);
     }
+
+    /// exit_group(status)
+    pub(crate) fn sys_exit_group(&mut self, x86_num: u32) -> i64 {
+        self.report_exit_stats();
+        self.sys_passthrough(x86_num, 1)
+    }
 }
@@ -0,0 +1,211 @@
+use anyhow::{Result, anyhow};
+
+use crate::Cpu;
+
+/// Size of a guest `struct mmsghdr`: the 28-byte msghdr, then msg_len.
+const MMSGHDR_SIZE: usize = 32;
+
+/// Most messages one call moves, as UIO_MAXIOV caps it on Linux.
+const MAX_MESSAGES: usize = 1024;
+
+/// Host headers and iovecs for a guest mmsghdr array. Kept on the `Cpu` so
+/// batched calls reuse the allocations of the previous one; both vectors
+/// are emptied after every call.
+#[derive(Default)]
+pub(crate) struct MsgArena {
+    headers: Vec<libc::mmsghdr>,
+    iovecs: Vec<libc::iovec>,
+}
+
+// The pointers only live between `fill_msg_arena` and the end of the
+// syscall that uses them, on the thread running the guest.
+unsafe impl Send for MsgArena {}
+
+impl Cpu {
+    /// recvmmsg(fd, msgvec, vlen, flags, timeout) and recvmmsg_time64,
+    /// whose timeout is a 64-bit timespec.
+    pub(crate) fn sys_recvmmsg(&mut self, time64: bool) -> Result<i64> {
+        let (fd, msgvec, vlen, flags, timeout_addr): (i32, usize, usize, i32, usize) =
+            self.get_args();
+        let mut timeout = if timeout_addr == 0 {
+            None
+        } else if time64 {
+            let sec = self.read_u64_be(timeout_addr)? as i64;
+            let nsec = self.read_u64_be(timeout_addr + 8)? as i64;
+            Some(libc::timespec {
+                tv_sec: sec,
+                tv_nsec: nsec,
+            })
+        } else {
+            Some(libc::timespec {
+                tv_sec: self.memory.read_long(timeout_addr)? as i32 as i64,
+                tv_nsec: self.memory.read_long(timeout_addr + 4)? as i32 as i64,
+            })
+        };
+
+        let mut arena = std::mem::take(&mut self.msg_arena);
+        let result = self
+            .fill_msg_arena(&mut arena, msgvec, vlen, true)
+            .map(|()| {
+                let timeout = timeout
+                    .as_mut()
+                    .map_or(std::ptr::null_mut(), |t| t as *mut libc::timespec);
+                // SAFETY: every pointer in the arena was resolved from guest
+                // memory, which stays mapped for the duration of the call.
+                let n = unsafe {
+                    libc::recvmmsg(
+                        fd,
+                        arena.headers.as_mut_ptr(),
+                        arena.headers.len() as u32,
+                        flags,
+                        timeout,
+                    )
+                };
+                Self::libc_to_kernel(n as i64)
+            })
+            .and_then(|n| {
+                // Only the lengths the kernel filled in go back.
+                for (i, header) in arena.headers.iter().take(n.max(0) as usize).enumerate() {
+                    let entry = msgvec + i * MMSGHDR_SIZE;
+                    let msg = &header.msg_hdr;
+                    self.memory
+                        .write_data(entry + 4, &msg.msg_namelen.to_be_bytes())?;
+                    self.memory
+                        .write_data(entry + 20, &(msg.msg_controllen as u32).to_be_bytes())?;
+                    self.memory
+                        .write_data(entry + 24, &msg.msg_flags.to_be_bytes())?;
+                    self.memory
+                        .write_data(entry + 28, &header.msg_len.to_be_bytes())?;
+                }
+                Ok(n)
+            });
+        arena.clear();
+        self.msg_arena = arena;
+        let n = result?;
+
+        if n >= 0
+            && let Some(left) = timeout
+        {
+            if time64 {
+                self.write_u64_be(timeout_addr, left.tv_sec as u64)?;
+                self.write_u64_be(timeout_addr + 8, left.tv_nsec as u64)?;
+            } else {
+                self.memory
+                    .write_data(timeout_addr, &(left.tv_sec as u32).to_be_bytes())?;
+                self.memory
+                    .write_data(timeout_addr + 4, &(left.tv_nsec as u32).to_be_bytes())?;
+            }
+        }
+        Ok(n)
+    }
+
+    /// sendmmsg(fd, msgvec, vlen, flags)
+    pub(crate) fn sys_sendmmsg(&mut self) -> Result<i64> {
+        let (fd, msgvec, vlen, flags): (i32, usize, usize, i32) = self.get_args();
+
+        let mut arena = std::mem::take(&mut self.msg_arena);
+        let result = self
+            .fill_msg_arena(&mut arena, msgvec, vlen, false)
+            .map(|()| {
+                // SAFETY: as in `sys_recvmmsg`; sendmmsg only reads through
+                // the pointers.
+                let n = unsafe {
+                    libc::sendmmsg(
+                        fd,
+                        arena.headers.as_mut_ptr(),
+                        arena.headers.len() as u32,
+                        flags,
+                    )
+                };
+                Self::libc_to_kernel(n as i64)
+            })
+            .and_then(|n| {
+                for (i, header) in arena.headers.iter().take(n.max(0) as usize).enumerate() {
+                    self.memory.write_data(
+                        msgvec + i * MMSGHDR_SIZE + 28,
+                        &header.msg_len.to_be_bytes(),
+                    )?;
+                }
+                Ok(n)
+            });
+        arena.clear();
+        self.msg_arena = arena;
+        result
+    }
+
+    /// Bytes moved by the first `count` messages of the guest mmsghdr
+    /// array at `msgvec`, as sendmmsg/recvmmsg left them.
+    pub(crate) fn mmsg_bytes(&self, msgvec: usize, count: usize) -> u64 {
+        (0..count.min(MAX_MESSAGES))
+            .map(|i| {
+                let msg_len = msgvec + i * MMSGHDR_SIZE + 28;
+                u64::from(self.memory.read_long(msg_len).unwrap_or(0))
+            })
+            .sum()
+    }
+
+    /// Resolve the guest mmsghdr array at `msgvec` into `arena` in one pass.
+    /// Buffers are resolved for writing when `writable`.
+    fn fill_msg_arena(
+        &mut self,
+        arena: &mut MsgArena,
+        msgvec: usize,
+        vlen: usize,
+        writable: bool,
+    ) -> Result<()> {
+        let resolve = |cpu: &mut Self, addr: usize, len: usize, what: &str| {
+            if addr == 0 || len == 0 {
+                return Ok(std::ptr::null_mut());
+            }
+            let ptr = if writable {
+                cpu.memory.guest_to_host_mut(addr, len)
+            } else {
+                cpu.memory.guest_to_host(addr, len).map(|p| p as *mut u8)
+            };
+            ptr.map(|p| p as *mut libc::c_void)
+                .ok_or_else(|| anyhow!("invalid {what} pointer {addr:#x}"))
+        };
+
+        for i in 0..vlen.min(MAX_MESSAGES) {
+            let entry = msgvec + i * MMSGHDR_SIZE;
+            let msg_name = self.memory.read_long(entry)? as usize;
+            let msg_namelen = self.memory.read_long(entry + 4)?;
+            let msg_iov = self.memory.read_long(entry + 8)? as usize;
+            let msg_iovlen = self.memory.read_long(entry + 12)? as usize;
+            let msg_control = self.memory.read_long(entry + 16)? as usize;
+            let msg_controllen = self.memory.read_long(entry + 20)? as usize;
+
+            let name = resolve(self, msg_name, msg_namelen as usize, "msg_name")?;
+            let control = resolve(self, msg_control, msg_controllen, "msg_control")?;
+            self.append_iovecs(&mut arena.iovecs, msg_iov, msg_iovlen, writable)?;
+            // msg_iov is pointed into `iovecs` once it has stopped growing.
+            arena.headers.push(libc::mmsghdr {
+                msg_hdr: libc::msghdr {
+                    msg_name: name,
+                    msg_namelen,
+                    msg_iov: std::ptr::null_mut(),
+                    msg_iovlen,
+                    msg_control: control,
+                    msg_controllen: if control.is_null() { 0 } else { msg_controllen },
+                    msg_flags: 0,
+                },
+                msg_len: 0,
+            });
+        }
+
+        let mut next = arena.iovecs.as_mut_ptr();
+        for header in &mut arena.headers {
+            header.msg_hdr.msg_iov = next;
+            // SAFETY: the counts add up to `iovecs.len()`.
+            next = unsafe { next.add(header.msg_hdr.msg_iovlen) };
+        }
+        Ok(())
+    }
+}
+
+impl MsgArena {
+    fn clear(&mut self) {
+        self.headers.clear();
+        self.iovecs.clear();
+    }
+}
@@ -1,6 +1,7 @@
 pub mod accept4;
 pub mod getsockname;
 pub mod getsockopt;
+pub mod mmsg;
 pub mod recvfrom;
 pub mod recvmsg;
 pub mod sendmsg;
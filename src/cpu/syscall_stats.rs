@@ -0,0 +1,199 @@
+use std::{
+    collections::HashMap,
+    sync::atomic::{AtomicBool, Ordering},
+    time::Duration,
+};
+
+use super::{Cpu, on_host_signal};
+use crate::syscall::m68k_syscall_name;
+
+/// Syscalls whose non-negative result is a byte count.
+const MOVES_BYTES: &[&str] = &[
+    "read",
+    "write",
+    "readv",
+    "writev",
+    "pread64",
+    "pwrite64",
+    "preadv",
+    "pwritev",
+    "preadv2",
+    "pwritev2",
+    "send",
+    "sendto",
+    "recv",
+    "recvfrom",
+    "sendmsg",
+    "recvmsg",
+    "sendfile",
+    "sendfile64",
+    "splice",
+    "tee",
+    "copy_file_range",
+];
+
+/// Syscalls whose non-negative result is a count of guest `mmsghdr`s,
+/// each holding the bytes it moved.
+const MOVES_MESSAGES: &[&str] = &["sendmmsg", "recvmmsg", "recvmmsg_time64"];
+
+/// Latency buckets below this many nanoseconds are exact; above it each
+/// power of two is split into `SUB_BUCKETS` linear steps (~12% wide).
+const EXACT: u64 = 16;
+const SUB_BUCKETS: u64 = 8;
+
+/// Set by the SIGUSR1 handler; the summary is printed at the next syscall.
+static DUMP_REQUESTED: AtomicBool = AtomicBool::new(false);
+
+extern "C" fn request_dump(_: libc::c_int) {
+    DUMP_REQUESTED.store(true, Ordering::Relaxed);
+}
+
+#[derive(Default)]
+struct Syscall {
+    calls: u64,
+    errors: u64,
+    total: Duration,
+    max_ns: u64,
+    bytes: u64,
+    /// Log-linear latency histogram, indexed by `bucket`.
+    latency: Vec<u64>,
+}
+
+fn bucket(ns: u64) -> usize {
+    if ns < EXACT {
+        return ns as usize;
+    }
+    let exp = u64::from(63 - ns.leading_zeros());
+    let step = exp - u64::from(SUB_BUCKETS.trailing_zeros());
+    let sub = (ns >> step) & (SUB_BUCKETS - 1);
+    (EXACT + (exp - u64::from(EXACT.trailing_zeros())) * SUB_BUCKETS + sub) as usize
+}
+
+/// Largest latency that lands in `index`.
+fn bucket_limit(index: usize) -> u64 {
+    let index = index as u64;
+    if index < EXACT {
+        return index;
+    }
+    let exp = (index - EXACT) / SUB_BUCKETS + u64::from(EXACT.trailing_zeros());
+    let sub = (index - EXACT) % SUB_BUCKETS;
+    let step = exp - u64::from(SUB_BUCKETS.trailing_zeros());
+    ((SUB_BUCKETS + sub + 1) << step) - 1
+}
+
+impl Syscall {
+    fn p99_ns(&self) -> u64 {
+        let target = self.calls - self.calls / 100;
+        let mut seen = 0;
+        for (index, &count) in self.latency.iter().enumerate() {
+            seen += count;
+            if seen >= target {
+                return bucket_limit(index).min(self.max_ns);
+            }
+        }
+        self.max_ns
+    }
+}
+
+/// Per-syscall counts and host latency for `--syscall-summary`, in the
+/// spirit of `strace -c` but covering only the guest's syscalls.
+#[derive(Default)]
+pub(super) struct SyscallStats {
+    by_number: HashMap<u32, Syscall>,
+}
+
+impl SyscallStats {
+    pub(super) fn new() -> Self {
+        on_host_signal(libc::SIGUSR1, request_dump);
+        Self::default()
+    }
+
+    /// Account one call; `bytes` is what a successful call moved.
+    fn record(&mut self, number: u32, elapsed: Duration, result: i64, bytes: u64) {
+        let entry = self.by_number.entry(number).or_default();
+        entry.calls += 1;
+        entry.total += elapsed;
+        if (-4095..0).contains(&result) {
+            entry.errors += 1;
+        } else {
+            entry.bytes += bytes;
+        }
+        let ns = elapsed.as_nanos().min(u128::from(u64::MAX)) as u64;
+        entry.max_ns = entry.max_ns.max(ns);
+        let index = bucket(ns);
+        if entry.latency.len() <= index {
+            entry.latency.resize(index + 1, 0);
+        }
+        entry.latency[index] += 1;
+    }
+
+    /// Print the table to stderr, most host time first.
+    pub(super) fn report(&self) {
+        let mut rows: Vec<_> = self.by_number.iter().collect();
+        rows.sort_by(|a, b| b.1.total.cmp(&a.1.total).then(a.0.cmp(b.0)));
+        let total: Duration = rows.iter().map(|(_, s)| s.total).sum();
+        let pct =
+            |d: Duration| 100.0 * d.as_secs_f64() / total.as_secs_f64().max(f64::MIN_POSITIVE);
+
+        eprintln!("syscall summary (pid {}):", std::process::id());
+        eprintln!(
+            "{:>7} {:>11} {:>11} {:>11} {:>9} {:>8} {:>12}  syscall",
+            "% time", "seconds", "usecs/call", "p99 usecs", "calls", "errors", "bytes"
+        );
+        let (mut calls, mut errors, mut bytes) = (0, 0, 0);
+        for (&number, stat) in rows {
+            calls += stat.calls;
+            errors += stat.errors;
+            bytes += stat.bytes;
+            let name = match m68k_syscall_name(number) {
+                Some(name) => name.to_string(),
+                None => format!("syscall_{number}"),
+            };
+            eprintln!(
+                "{:>7.2} {:>11.6} {:>11.1} {:>11.1} {:>9} {:>8} {:>12}  {name}",
+                pct(stat.total),
+                stat.total.as_secs_f64(),
+                stat.total.as_secs_f64() * 1e6 / stat.calls as f64,
+                stat.p99_ns() as f64 / 1e3,
+                stat.calls,
+                stat.errors,
+                stat.bytes,
+            );
+        }
+        eprintln!(
+            "{:>7} {:>11.6} {:>11} {:>11} {:>9} {:>8} {:>12}  total",
+            "100.00",
+            total.as_secs_f64(),
+            "",
+            "",
+            calls,
+            errors,
+            bytes,
+        );
+    }
+}
+
+impl Cpu {
+    /// Account one completed syscall, and print the summary if SIGUSR1
+    /// asked for it since the last one.
+    pub(super) fn record_syscall(&mut self, number: u32, elapsed: Duration, result: i64) {
+        if self.syscall_stats.is_none() {
+            return;
+        }
+        let bytes = match m68k_syscall_name(number) {
+            _ if result <= 0 => 0,
+            Some(name) if MOVES_BYTES.contains(&name) => result as u64,
+            // The arguments are still in D1-D5; D0 takes the result later.
+            Some(name) if MOVES_MESSAGES.contains(&name) => {
+                self.mmsg_bytes(self.data_regs[2] as usize, result as usize)
+            }
+            _ => 0,
+        };
+        if let Some(stats) = &mut self.syscall_stats {
+            stats.record(number, elapsed, result, bytes);
+            if DUMP_REQUESTED.swap(false, Ordering::Relaxed) {
+                stats.report();
+            }
+        }
+    }
+}
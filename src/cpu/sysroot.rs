@@ -0,0 +1,113 @@
+// Guest paths under `--sysroot`, the m68k root filesystem that holds the
+// dynamic loader, shared libraries and configuration files of the guest.
+// Absolute paths the guest looks up or opens for reading are taken from
+// the sysroot when they exist there and from the host otherwise. Lookups
+// are remembered, misses included, since dynamic loaders and path searches
+// probe the same candidates over and over; the sysroot is assumed not to
+// change while the guest runs.
+
+use std::{
+    borrow::Cow,
+    ffi::{CStr, CString, OsStr},
+    fs,
+    os::unix::ffi::{OsStrExt, OsStringExt},
+    path::Path,
+};
+
+use super::Cpu;
+
+/// Remembered lookups before the cache starts over.
+const CACHE_ENTRIES: usize = 4096;
+
+/// Symlinks in the sysroot followed before giving up, like the kernel's
+/// ELOOP limit.
+const MAX_LINKS: usize = 40;
+
+impl Cpu {
+    /// Host path for the guest's `path`: an absolute path that exists under
+    /// `--sysroot` is taken from there, anything else from the host.
+    /// `follow` is false for lookups of a final symlink itself (lstat,
+    /// readlink, AT_SYMLINK_NOFOLLOW).
+    pub(super) fn sysroot_path<'a>(&mut self, path: &'a CStr, follow: bool) -> Cow<'a, CStr> {
+        let Some(root) = &self.options.sysroot else {
+            return Cow::Borrowed(path);
+        };
+        if !path.to_bytes().starts_with(b"/") {
+            return Cow::Borrowed(path);
+        }
+        let key = (path.to_owned(), follow);
+        let host = match self.sysroot_cache.get(&key) {
+            Some(host) => host.clone(),
+            None => {
+                let host = resolve(root.trim_end_matches('/'), path.to_bytes(), follow);
+                if self.sysroot_cache.len() >= CACHE_ENTRIES {
+                    self.sysroot_cache.clear();
+                }
+                self.sysroot_cache.insert(key, host.clone());
+                host
+            }
+        };
+        host.map_or(Cow::Borrowed(path), Cow::Owned)
+    }
+
+    /// Host path for an open of the guest's `path` with host `flags`. Only
+    /// read-only opens go through the sysroot; a file the guest creates,
+    /// truncates or writes is the host's.
+    pub(super) fn sysroot_open_path<'a>(&mut self, path: &'a CStr, flags: i32) -> Cow<'a, CStr> {
+        let writes = flags & libc::O_ACCMODE != libc::O_RDONLY;
+        if writes || flags & (libc::O_CREAT | libc::O_TRUNC) != 0 {
+            return Cow::Borrowed(path);
+        }
+        self.sysroot_path(path, flags & libc::O_NOFOLLOW == 0)
+    }
+}
+
+/// `path` under `root` if it exists there. The path is walked a component
+/// at a time so that every symlink on the way, absolute or relative, and
+/// every `..` resolves inside the sysroot as if it were `/`.
+fn resolve(root: &str, path: &[u8], follow: bool) -> Option<CString> {
+    let host = |names: &[Vec<u8>]| {
+        let mut host = root.as_bytes().to_vec();
+        for name in names {
+            host.push(b'/');
+            host.extend_from_slice(name);
+        }
+        host
+    };
+    // Components still to walk, last one first.
+    let mut pending: Vec<Vec<u8>> = path
+        .split(|&b| b == b'/')
+        .rev()
+        .map(<[u8]>::to_vec)
+        .collect();
+    let mut resolved: Vec<Vec<u8>> = Vec::new();
+    let mut links = 0;
+    while let Some(name) = pending.pop() {
+        match name.as_slice() {
+            b"" | b"." => continue,
+            b".." => {
+                resolved.pop();
+                continue;
+            }
+            _ => resolved.push(name),
+        }
+        let host_path = host(&resolved);
+        let meta = fs::symlink_metadata(Path::new(OsStr::from_bytes(&host_path))).ok()?;
+        let last = pending.iter().all(|name| name.is_empty() || name == b".");
+        if !meta.file_type().is_symlink() || (last && !follow) {
+            continue;
+        }
+        links += 1;
+        if links > MAX_LINKS {
+            return None;
+        }
+        let target = fs::read_link(Path::new(OsStr::from_bytes(&host_path))).ok()?;
+        let target = target.into_os_string().into_vec();
+        resolved.pop();
+        if target.starts_with(b"/") {
+            resolved.clear();
+        }
+        pending.extend(target.split(|&b| b == b'/').rev().map(<[u8]>::to_vec));
+    }
+    CString::new(host(&resolved)).ok()
+}
@@ -0,0 +1,668 @@
+// Threaded-code tier. Every decoded instruction is bound once to a handler
+// function and a set of pre-resolved operands (register numbers,
+// displacements, immediates, branch targets), and a block is a slice of these
+// run back to back. The hot path never re-matches `InstructionKind` or
+// unpacks `AddressingMode` extension data. Instructions without a handler run
+// through `Cpu::execute`.
+
+use anyhow::Result;
+
+use super::{
+    ends_block,
+    m68020::{
+        Cpu, FLAG_C, FLAG_V, add_with_flags, cmp_with_flags, imm_to_u32, sub_with_flags,
+        write_sized_data_reg,
+    },
+    translate::{BranchBias, CodeCache, Layout, Translate, branch_layout},
+};
+use crate::decoder::{
+    Add, AddressingMode, And, Condition, Decoder, DnToEa, EaToDn, EffectiveAddress, ExtMode, ImmOp,
+    Instruction, InstructionKind, Or, QuickOp, ResolvedEa, Size, Sub, UnaryOp,
+};
+
+/// Upper bound on instructions bound into one block.
+const MAX_BLOCK_INSTS: usize = 64;
+
+type Handler = fn(&mut Cpu, &Bound, &Instruction) -> Result<()>;
+
+/// One instruction bound to its handler. Memory operands come from the
+/// decoder already resolved (`AddressingMode::resolved`).
+struct Bound {
+    run: Handler,
+    size: Size,
+    src: AddressingMode,
+    dst: AddressingMode,
+    /// Register number for handlers with a fixed register operand.
+    reg: usize,
+    /// Immediate data or displacement, depending on the handler.
+    imm: u32,
+    cond: Condition,
+    /// Branch target for control transfers.
+    target: usize,
+    /// Address of the following instruction.
+    next: usize,
+}
+
+struct Block {
+    insts: Vec<Instruction>,
+    bound: Vec<Bound>,
+}
+
+impl Block {
+    fn build(decoder: &Decoder, bias: &BranchBias, start: usize) -> Result<Self> {
+        let mut insts = Vec::new();
+        let mut bound = Vec::new();
+        let mut pc = start;
+        loop {
+            let inst = match decoder.decode_instruction(pc) {
+                Ok(inst) => inst,
+                // Let the failure surface when execution actually reaches it.
+                Err(_) if !insts.is_empty() => break,
+                Err(e) => return Err(e),
+            };
+            pc = inst.address + inst.len();
+            bound.push(bind(&inst));
+            // A branch that usually falls through leaves the block only when
+            // taken. Following the taken side would need the handler to
+            // expect the target, so those still end the block here.
+            let ends = ends_block(&inst.kind)
+                && !matches!(branch_layout(bias, &inst), Some(Layout::FallThrough));
+            insts.push(inst);
+            if ends || insts.len() >= MAX_BLOCK_INSTS {
+                break;
+            }
+        }
+        Ok(Self { insts, bound })
+    }
+}
+
+impl Translate for Block {
+    fn translate(decoder: &Decoder, bias: &BranchBias, start: usize) -> Result<Self> {
+        Self::build(decoder, bias, start)
+    }
+
+    fn insts(&self) -> &[Instruction] {
+        &self.insts
+    }
+
+    fn footprint(&self) -> usize {
+        std::mem::size_of::<Self>()
+            + self.insts.iter().map(Translate::footprint).sum::<usize>()
+            + self.bound.capacity() * std::mem::size_of::<Bound>()
+    }
+}
+
+impl Cpu {
+    /// Run with guest code bound to pre-resolved handler blocks.
+    pub(crate) fn run_threaded(&mut self) -> Result<()> {
+        let mut blocks: CodeCache<Block> = self.code_cache();
+
+        while !self.halted {
+            let pc = self.pc;
+            let block = blocks.get(pc)?;
+
+            let mut current = 0;
+            if let Err(e) = self.enter_block(pc, |cpu| cpu.exec_bound_block(block, &mut current)) {
+                let inst = &block.insts[current];
+                self.pc = inst.address;
+                eprintln!("FAILED at PC={:#010x}: {:?}", inst.address, inst.kind);
+                eprintln!("Error: {:?}", e);
+                self.dump_registers();
+                return Err(e);
+            }
+            self.executed += current as u64 + 1;
+            self.profile_edges(&block.insts[..=current]);
+            if self.executed >= self.sample_at {
+                self.profile_tick();
+            }
+            #[cfg(feature = "stats")]
+            self.record_insts(&block.insts[..=current]);
+            if !self.stale_code.is_empty() {
+                blocks.invalidate(&mut self.stale_code, &self.memory);
+            }
+            if self.pc == self.snapshot_at || self.snapshot_requested {
+                self.save_snapshot(blocks.entries());
+            }
+        }
+
+        Ok(())
+    }
+
+    fn exec_bound_block(&mut self, block: &Block, current: &mut usize) -> Result<()> {
+        for (index, (b, inst)) in block.bound.iter().zip(&block.insts).enumerate() {
+            *current = index;
+            self.pc = b.next;
+            (b.run)(self, b, inst)?;
+            if self.halted || self.pc != b.next {
+                break;
+            }
+        }
+        Ok(())
+    }
+
+    fn read_op(&mut self, mode: &AddressingMode, size: Size) -> Result<u32> {
+        let loc = self.locate(mode, size)?;
+        self.read_loc(loc, size)
+    }
+
+    fn logic_flags(&mut self, value: u32, size: Size) {
+        self.update_nz_flags_sized(value, size);
+        self.set_flag(FLAG_V, false);
+        self.set_flag(FLAG_C, false);
+    }
+}
+
+/// Placeholder for handlers that do not use an operand slot.
+const NO_OPERAND: AddressingMode = AddressingMode {
+    ea: EffectiveAddress::Immediate,
+    data: None,
+    resolved: ResolvedEa::Unresolved,
+};
+
+impl Bound {
+    fn new(run: Handler, next: usize) -> Self {
+        Self {
+            run,
+            size: Size::Long,
+            src: NO_OPERAND,
+            dst: NO_OPERAND,
+            reg: 0,
+            imm: 0,
+            cond: Condition::True,
+            target: 0,
+            next,
+        }
+    }
+}
+
+fn bind(inst: &Instruction) -> Bound {
+    bind_native(inst).unwrap_or_else(|| Bound::new(fallback, inst.address + inst.len()))
+}
+
+/// Bind `inst` to a specialized handler, or None if it has no handler or
+/// uses an operand form that is left to the interpreter.
+fn bind_native(inst: &Instruction) -> Option<Bound> {
+    let pc = inst.address;
+    let mut b = Bound::new(fallback, pc + inst.len());
+    let branch_target = |displacement: i32| (pc as i64 + 2 + displacement as i64) as usize;
+
+    match inst.kind {
+        InstructionKind::Nop => b.run = nop,
+        InstructionKind::Moveq { data, dst } => {
+            b.run = moveq;
+            b.imm = data as i32 as u32;
+            b.reg = dst as usize;
+        }
+        InstructionKind::Move { size, src, dst } => {
+            b.run = move_;
+            b.size = size;
+            b.src = operand(src)?;
+            b.dst = dest(dst)?;
+        }
+        // MOVEA.B is not a valid encoding; let the interpreter decide.
+        InstructionKind::Movea { size, src, dst } if size != Size::Byte => {
+            b.run = movea;
+            b.size = size;
+            b.src = operand(src)?;
+            b.reg = dst as usize;
+        }
+        InstructionKind::Lea { src, dst } => {
+            b.run = lea;
+            b.src = control(src)?;
+            b.reg = dst as usize;
+        }
+        InstructionKind::Pea { mode } => {
+            b.run = pea;
+            b.src = control(mode)?;
+        }
+        InstructionKind::Clr(UnaryOp { size, mode }) => {
+            b.run = clr;
+            b.size = size;
+            b.dst = dest(mode)?;
+        }
+        InstructionKind::Tst { size, mode } => {
+            b.run = tst;
+            b.size = size;
+            b.src = operand(mode)?;
+        }
+        InstructionKind::Ext { data_reg, mode } => {
+            b.run = match mode {
+                ExtMode::ByteToWord => ext_bw,
+                ExtMode::WordToLong => ext_wl,
+                ExtMode::ByteToLong => ext_bl,
+            };
+            b.reg = data_reg as usize;
+        }
+        InstructionKind::Swap { data_reg } => {
+            b.run = swap;
+            b.reg = data_reg as usize;
+        }
+        InstructionKind::Add(Add::EaToDn(EaToDn { size, dst, src }))
+        | InstructionKind::Sub(Sub::EaToDn(EaToDn { size, dst, src }))
+        | InstructionKind::And(And::EaToDn(EaToDn { size, dst, src }))
+        | InstructionKind::Or(Or::EaToDn(EaToDn { size, dst, src })) => {
+            b.run = binary_handler(&inst.kind);
+            b.size = size;
+            b.src = operand(src)?;
+            b.dst = EffectiveAddress::Dr(dst).into();
+        }
+        InstructionKind::Add(Add::DnToEa(DnToEa { size, src, dst }))
+        | InstructionKind::Sub(Sub::DnToEa(DnToEa { size, src, dst }))
+        | InstructionKind::And(And::DnToEa(DnToEa { size, src, dst }))
+        | InstructionKind::Or(Or::DnToEa(DnToEa { size, src, dst }))
+        | InstructionKind::Eor(DnToEa { size, src, dst }) => {
+            b.run = binary_handler(&inst.kind);
+            b.size = size;
+            b.src = EffectiveAddress::Dr(src).into();
+            b.dst = dest(dst)?;
+        }
+        InstructionKind::Addi(ImmOp { imm, size, mode })
+        | InstructionKind::Subi(ImmOp { imm, size, mode })
+        | InstructionKind::Andi(ImmOp { imm, size, mode })
+        | InstructionKind::Ori(ImmOp { imm, size, mode })
+        | InstructionKind::Eori(ImmOp { imm, size, mode }) => {
+            b.run = binary_handler(&inst.kind);
+            b.size = size;
+            b.src = immediate(imm_to_u32(imm));
+            b.dst = dest(mode)?;
+        }
+        InstructionKind::Addq(QuickOp { data, size, mode })
+        | InstructionKind::Subq(QuickOp { data, size, mode }) => {
+            let is_add = matches!(inst.kind, InstructionKind::Addq(_));
+            let amount = if data == 0 { 8 } else { data as u32 };
+            if let EffectiveAddress::Ar(reg) = mode.ea {
+                // Quick ops on An work on the full register and leave the
+                // flags alone.
+                b.run = if is_add { adda } else { suba };
+                b.src = immediate(amount);
+                b.reg = reg as usize;
+            } else {
+                b.run = if is_add { add } else { sub };
+                b.size = size;
+                b.src = immediate(amount);
+                b.dst = dest(mode)?;
+            }
+        }
+        InstructionKind::Adda {
+            addr_reg,
+            size,
+            mode,
+        }
+        | InstructionKind::Suba {
+            addr_reg,
+            size,
+            mode,
+        } => {
+            b.run = if matches!(inst.kind, InstructionKind::Adda { .. }) {
+                adda
+            } else {
+                suba
+            };
+            b.size = size;
+            b.src = operand(mode)?;
+            b.reg = addr_reg as usize;
+        }
+        InstructionKind::Cmp(EaToDn { size, dst, src }) => {
+            b.run = cmp;
+            b.size = size;
+            b.src = operand(src)?;
+            b.dst = EffectiveAddress::Dr(dst).into();
+        }
+        InstructionKind::Cmpa {
+            addr_reg,
+            size,
+            src,
+        } => {
+            b.run = cmpa;
+            b.size = size;
+            b.src = operand(src)?;
+            b.reg = addr_reg as usize;
+        }
+        InstructionKind::Cmpi(ImmOp { imm, size, mode }) => {
+            b.run = cmp;
+            b.size = size;
+            b.src = immediate(imm_to_u32(imm));
+            b.dst = operand(mode)?;
+        }
+        InstructionKind::Scc { condition, mode } => {
+            b.run = scc;
+            b.cond = condition;
+            b.size = Size::Byte;
+            b.dst = dest(mode)?;
+        }
+        InstructionKind::Link {
+            addr_reg,
+            displacement,
+        } => {
+            b.run = link;
+            b.reg = addr_reg as usize;
+            b.imm = displacement as i32 as u32;
+        }
+        InstructionKind::Unlk { addr_reg } => {
+            b.run = unlk;
+            b.reg = addr_reg as usize;
+        }
+        InstructionKind::Bra { displacement } => {
+            b.run = bra;
+            b.target = branch_target(displacement);
+        }
+        InstructionKind::Bcc {
+            condition,
+            displacement,
+        } => {
+            b.run = bcc;
+            b.cond = condition;
+            b.target = branch_target(displacement);
+        }
+        InstructionKind::DBcc {
+            condition,
+            data_reg,
+            displacement,
+        } => {
+            b.run = dbcc;
+            b.cond = condition;
+            b.reg = data_reg as usize;
+            b.target = branch_target(displacement as i32);
+        }
+        InstructionKind::Bsr { displacement } => {
+            b.run = bsr;
+            b.target = branch_target(displacement);
+        }
+        InstructionKind::Jsr { mode } => {
+            b.run = jsr;
+            b.src = control(mode)?;
+        }
+        InstructionKind::Jmp { mode } => {
+            b.run = jmp;
+            b.src = control(mode)?;
+        }
+        InstructionKind::Rts => b.run = rts,
+        _ => return None,
+    }
+    Some(b)
+}
+
+fn binary_handler(kind: &InstructionKind) -> Handler {
+    match kind {
+        InstructionKind::Add(_) | InstructionKind::Addi(_) => add,
+        InstructionKind::Sub(_) | InstructionKind::Subi(_) => sub,
+        InstructionKind::And(_) | InstructionKind::Andi(_) => and,
+        InstructionKind::Or(_) | InstructionKind::Ori(_) => or,
+        InstructionKind::Eor(_) | InstructionKind::Eori(_) => eor,
+        _ => unreachable!("not a binary operation: {kind:?}"),
+    }
+}
+
+fn immediate(value: u32) -> AddressingMode {
+    AddressingMode {
+        resolved: ResolvedEa::Imm(value),
+        ..NO_OPERAND
+    }
+}
+
+/// A readable operand, or None if the decoder could not resolve it.
+fn operand(mode: AddressingMode) -> Option<AddressingMode> {
+    (mode.resolved != ResolvedEa::Unresolved).then_some(mode)
+}
+
+/// A writable operand. PC-relative and immediate modes are left to the
+/// interpreter to reject.
+fn dest(mode: AddressingMode) -> Option<AddressingMode> {
+    match mode.ea {
+        EffectiveAddress::PCDisplace | EffectiveAddress::PCIndex | EffectiveAddress::Immediate => {
+            None
+        }
+        _ => operand(mode),
+    }
+}
+
+/// An operand used by address, as for LEA and JMP.
+fn control(mode: AddressingMode) -> Option<AddressingMode> {
+    match mode.resolved {
+        ResolvedEa::Ind(_)
+        | ResolvedEa::DispAn { .. }
+        | ResolvedEa::Index { .. }
+        | ResolvedEa::MemIndirectPre { .. }
+        | ResolvedEa::MemIndirectPost { .. }
+        | ResolvedEa::Abs(_) => Some(mode),
+        _ => None,
+    }
+}
+
+fn fallback(cpu: &mut Cpu, _: &Bound, inst: &Instruction) -> Result<()> {
+    cpu.pc = inst.address;
+    cpu.execute(inst)
+}
+
+fn nop(_: &mut Cpu, _: &Bound, _: &Instruction) -> Result<()> {
+    Ok(())
+}
+
+fn moveq(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    cpu.data_regs[r] = b.imm;
+    cpu.logic_flags(b.imm, Size::Long);
+    Ok(())
+}
+
+fn move_(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let value = cpu.read_op(&b.src, b.size)?;
+    let dst = cpu.locate(&b.dst, b.size)?;
+    cpu.write_loc(dst, b.size, value)?;
+    cpu.logic_flags(value, b.size);
+    Ok(())
+}
+
+fn movea(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let value = sign_extend_word(cpu.read_op(&b.src, b.size)?, b.size);
+    let r = b.reg;
+    cpu.addr_regs[r] = value;
+    Ok(())
+}
+
+fn lea(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    cpu.addr_regs[r] = cpu.compute_effective_address(&b.src)? as u32;
+    Ok(())
+}
+
+fn pea(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let addr = cpu.compute_effective_address(&b.src)? as u32;
+    cpu.push_long(addr)
+}
+
+fn clr(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let dst = cpu.locate(&b.dst, b.size)?;
+    cpu.write_loc(dst, b.size, 0)?;
+    cpu.logic_flags(0, b.size);
+    Ok(())
+}
+
+fn tst(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let value = cpu.read_op(&b.src, b.size)?;
+    cpu.logic_flags(value, b.size);
+    Ok(())
+}
+
+fn ext_bw(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    let value = cpu.data_regs[r];
+    let result = (value & 0xFFFF_0000) | (value as i8 as i16 as u16 as u32);
+    cpu.data_regs[r] = result;
+    cpu.logic_flags(result, Size::Word);
+    Ok(())
+}
+
+fn ext_wl(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    let result = cpu.data_regs[r] as i16 as i32 as u32;
+    cpu.data_regs[r] = result;
+    cpu.logic_flags(result, Size::Long);
+    Ok(())
+}
+
+fn ext_bl(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    let result = cpu.data_regs[r] as i8 as i32 as u32;
+    cpu.data_regs[r] = result;
+    cpu.logic_flags(result, Size::Long);
+    Ok(())
+}
+
+fn swap(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    let result = cpu.data_regs[r].rotate_left(16);
+    cpu.data_regs[r] = result;
+    cpu.logic_flags(result, Size::Long);
+    Ok(())
+}
+
+/// Read-modify-write of `dst` with `src`, resolving each operand once.
+fn modify(cpu: &mut Cpu, b: &Bound, op: fn(&mut Cpu, u32, u32, Size) -> u32) -> Result<()> {
+    let src = cpu.read_op(&b.src, b.size)?;
+    let dst = cpu.locate(&b.dst, b.size)?;
+    let value = cpu.read_loc(dst, b.size)?;
+    let result = op(cpu, src, value, b.size);
+    cpu.write_loc(dst, b.size, result)
+}
+
+fn add(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    modify(cpu, b, |cpu, src, dst, size| {
+        add_with_flags(src, dst, size, cpu)
+    })
+}
+
+fn sub(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    modify(cpu, b, |cpu, src, dst, size| {
+        sub_with_flags(dst, src, size, cpu)
+    })
+}
+
+fn and(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    modify(cpu, b, |cpu, src, dst, size| {
+        let result = src & dst;
+        cpu.logic_flags(result, size);
+        result
+    })
+}
+
+fn or(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    modify(cpu, b, |cpu, src, dst, size| {
+        let result = src | dst;
+        cpu.logic_flags(result, size);
+        result
+    })
+}
+
+fn eor(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    modify(cpu, b, |cpu, src, dst, size| {
+        let result = src ^ dst;
+        cpu.logic_flags(result, size);
+        result
+    })
+}
+
+fn sign_extend_word(value: u32, size: Size) -> u32 {
+    if size == Size::Word {
+        value as i16 as i32 as u32
+    } else {
+        value
+    }
+}
+
+fn adda(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let src = sign_extend_word(cpu.read_op(&b.src, b.size)?, b.size);
+    let r = b.reg;
+    cpu.addr_regs[r] = cpu.addr_regs[r].wrapping_add(src);
+    Ok(())
+}
+
+fn suba(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let src = sign_extend_word(cpu.read_op(&b.src, b.size)?, b.size);
+    let r = b.reg;
+    cpu.addr_regs[r] = cpu.addr_regs[r].wrapping_sub(src);
+    Ok(())
+}
+
+fn cmp(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let src = cpu.read_op(&b.src, b.size)?;
+    let dst = cpu.read_op(&b.dst, b.size)?;
+    cmp_with_flags(dst, src, b.size, cpu);
+    Ok(())
+}
+
+fn cmpa(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let src = sign_extend_word(cpu.read_op(&b.src, b.size)?, b.size);
+    let r = b.reg;
+    cmp_with_flags(cpu.addr_regs[r], src, Size::Long, cpu);
+    Ok(())
+}
+
+fn scc(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let value = if cpu.test_condition(b.cond) { 0xFF } else { 0 };
+    let dst = cpu.locate(&b.dst, b.size)?;
+    cpu.write_loc(dst, Size::Byte, value)
+}
+
+fn link(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    cpu.push_long(cpu.addr_regs[r])?;
+    cpu.addr_regs[r] = cpu.addr_regs[7];
+    cpu.addr_regs[7] = cpu.addr_regs[7].wrapping_add(b.imm);
+    Ok(())
+}
+
+fn unlk(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let r = b.reg;
+    cpu.addr_regs[7] = cpu.addr_regs[r];
+    cpu.addr_regs[r] = cpu.pop_long()?;
+    Ok(())
+}
+
+fn bra(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    cpu.pc = b.target;
+    Ok(())
+}
+
+fn bcc(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    if cpu.test_condition(b.cond) {
+        cpu.pc = b.target;
+    }
+    Ok(())
+}
+
+fn dbcc(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    if cpu.test_condition(b.cond) {
+        return Ok(());
+    }
+    let r = b.reg;
+    let count = (cpu.data_regs[r] as u16).wrapping_sub(1);
+    cpu.data_regs[r] = write_sized_data_reg(cpu.data_regs[r], count as u32, Size::Word);
+    if count != 0xFFFF {
+        cpu.pc = b.target;
+    }
+    Ok(())
+}
+
+fn bsr(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    cpu.push_long(b.next as u32)?;
+    cpu.pc = b.target;
+    Ok(())
+}
+
+fn jsr(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    let target = cpu.compute_effective_address(&b.src)?;
+    cpu.push_long(b.next as u32)?;
+    cpu.pc = target;
+    Ok(())
+}
+
+fn jmp(cpu: &mut Cpu, b: &Bound, _: &Instruction) -> Result<()> {
+    cpu.pc = cpu.compute_effective_address(&b.src)?;
+    Ok(())
+}
+
+fn rts(cpu: &mut Cpu, _: &Bound, _: &Instruction) -> Result<()> {
+    cpu.pc = cpu.pop_long()? as usize;
+    Ok(())
+}
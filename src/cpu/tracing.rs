@@ -0,0 +1,54 @@
+use anyhow::{Context, Result};
+
+use super::Cpu;
+use crate::{syscall::m68k_syscall_name, trace::TraceWriter};
+
+impl Cpu {
+    /// Open the `--trace` file requested on the command line.
+    pub(super) fn start_trace(&mut self) -> Result<()> {
+        if let Some(path) = &self.options.trace {
+            let writer = TraceWriter::create(path, &self.exe_path)
+                .with_context(|| format!("creating trace {path}"))?;
+            self.trace = Some(Box::new(writer));
+            self.trace_pid = std::process::id();
+        }
+        Ok(())
+    }
+
+    /// Record a syscall's result. A forked child switches to its own
+    /// `<path>.<pid>`; what was buffered before the fork is the parent's.
+    pub(super) fn trace_result(&mut self, number: u32, result: i64) {
+        let Some(trace) = &mut self.trace else {
+            return;
+        };
+        if result == 0
+            && matches!(
+                m68k_syscall_name(number),
+                Some("fork" | "vfork" | "clone" | "clone3")
+            )
+            && std::process::id() != self.trace_pid
+            && let Some(path) = &self.options.trace
+        {
+            let path = format!("{path}.{}", std::process::id());
+            match TraceWriter::create(&path, &self.exe_path) {
+                Ok(writer) => **trace = writer,
+                Err(e) => {
+                    eprintln!("creating trace {path}: {e}");
+                    self.trace = None;
+                    return;
+                }
+            }
+            self.trace_pid = std::process::id();
+        }
+        trace.result(result as i32);
+    }
+
+    /// Write out the rest of the trace on the way out of the guest.
+    pub(super) fn finish_trace(&mut self) {
+        if let Some(trace) = &mut self.trace
+            && let Err(e) = trace.flush()
+        {
+            eprintln!("warning: writing trace {}: {e}", trace.path());
+        }
+    }
+}
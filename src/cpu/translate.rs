@@ -0,0 +1,687 @@
+// Code cache and block translation pipeline shared by the execution tiers.
+// The guest thread looks blocks up in its own map and translates
+// synchronously on a miss. Once a block tier has missed often enough to
+// be worth it, it also posts each new block's static successors (branch
+// targets, fall-throughs, call returns) to a pool of worker threads.
+// Workers decode ahead from those entries and hand finished blocks back over
+// a channel, which the guest drains on its next miss. The guest never waits on
+// a worker, so a worker falling behind only costs the decode-ahead, never
+// correctness.
+//
+// The map is held to a byte budget. When a new translation would exceed it,
+// blocks are evicted by the configured `EvictPolicy`; blocks prefetched by
+// workers are dropped instead of forcing an eviction. Syscalls that change
+// what guest code looks like (execve, munmap, mremap, making pages
+// executable) queue a `StaleCode` range on the CPU, and the run loop drops the
+// affected blocks before running the next one.
+//
+// With `--profile-in`, the blocks the profile saw most often are translated
+// in parallel before the guest starts, and block builders keep going through
+// conditional branches the profile found strongly biased, so the usual path
+// runs as one block with a side exit for the rare one.
+
+use std::{
+    collections::{HashMap, HashSet},
+    mem,
+    ops::Range,
+    process,
+    sync::{
+        Arc, Mutex,
+        atomic::{AtomicU64, Ordering},
+        mpsc::{self, Receiver, Sender},
+    },
+    thread,
+};
+
+use anyhow::Result;
+
+use super::{Cpu, EvictPolicy, ExecTier, discover, ends_block};
+use crate::{
+    decoder::{Decoder, Instruction, InstructionKind, ResolvedEa},
+    memory::MemoryImage,
+    options::Options,
+};
+
+/// How many blocks past a posted entry a worker follows successors.
+const DECODE_AHEAD_DEPTH: usize = 4;
+
+/// Worker count used by the block tiers when `--translate-threads` is not
+/// given.
+const DEFAULT_MAX_THREADS: usize = 2;
+
+/// Synchronous translations before the workers are started, so short-lived
+/// processes never pay for spawning them.
+const SPAWN_AFTER_MISSES: u64 = 256;
+
+/// Byte budget used when `--code-cache-size` is not given.
+const DEFAULT_BUDGET: usize = 64 << 20;
+
+/// The generation policy starts a new generation each time this fraction of
+/// the budget has been translated.
+const GENERATIONS: usize = 4;
+
+/// Conditional branches `--profile-in` found strongly biased, by address:
+/// true if the branch is almost always taken.
+pub(super) type BranchBias = HashMap<usize, bool>;
+
+/// Where a block builder keeps decoding past a biased conditional branch.
+pub(super) enum Layout {
+    FallThrough,
+    /// The branch target, which lies past the branch so the block's
+    /// instructions stay in address order.
+    Taken(usize),
+}
+
+/// How to lay out `inst` if it is a conditional branch with a known bias.
+pub(super) fn branch_layout(bias: &BranchBias, inst: &Instruction) -> Option<Layout> {
+    let InstructionKind::Bcc { displacement, .. } = inst.kind else {
+        return None;
+    };
+    if !*bias.get(&inst.address)? {
+        return Some(Layout::FallThrough);
+    }
+    let target = (inst.address as i64 + 2 + displacement as i64) as usize;
+    (target >= inst.address + inst.len()).then_some(Layout::Taken(target))
+}
+
+/// A translated block the pipeline can build off the guest thread.
+pub(super) trait Translate: Sized + Send + 'static {
+    fn translate(decoder: &Decoder, bias: &BranchBias, start: usize) -> Result<Self>;
+
+    /// Guest instructions covered by the block, in address order.
+    fn insts(&self) -> &[Instruction];
+
+    /// Approximate heap and inline size, charged against the cache budget.
+    fn footprint(&self) -> usize;
+}
+
+impl Translate for Instruction {
+    fn translate(decoder: &Decoder, _: &BranchBias, start: usize) -> Result<Self> {
+        decoder.decode_instruction(start)
+    }
+
+    fn insts(&self) -> &[Instruction] {
+        std::slice::from_ref(self)
+    }
+
+    fn footprint(&self) -> usize {
+        mem::size_of::<Self>() + self.bytes.capacity()
+    }
+}
+
+/// Guest addresses whose translations must be dropped. With `reload`, the
+/// decoder also takes a fresh copy of guest memory because new code may have
+/// appeared there.
+pub(super) struct StaleCode {
+    pub(super) range: Range<usize>,
+    pub(super) reload: bool,
+}
+
+/// Counters kept by a `CodeCache`, shared with the CPU so they can be
+/// reported on exit.
+#[derive(Default)]
+pub(super) struct CacheStats {
+    blocks: AtomicU64,
+    bytes: AtomicU64,
+    peak_bytes: AtomicU64,
+    budget: AtomicU64,
+    translations: AtomicU64,
+    retranslations: AtomicU64,
+    prefetched: AtomicU64,
+    evictions: AtomicU64,
+    eviction_passes: AtomicU64,
+    invalidated: AtomicU64,
+}
+
+impl CacheStats {
+    pub(super) fn report(&self) {
+        let get = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        eprintln!(
+            "code cache: {} blocks, {} of {} (peak {})",
+            get(&self.blocks),
+            human_bytes(get(&self.bytes)),
+            human_bytes(get(&self.budget)),
+            human_bytes(get(&self.peak_bytes)),
+        );
+        eprintln!(
+            "  translated {} ({} retranslated, {} by workers), evicted {} in {} passes, invalidated {}",
+            get(&self.translations),
+            get(&self.retranslations),
+            get(&self.prefetched),
+            get(&self.evictions),
+            get(&self.eviction_passes),
+            get(&self.invalidated),
+        );
+    }
+
+    /// (name, help, is gauge, value) for `--metrics`.
+    pub(super) fn counters(&self) -> Vec<(&'static str, &'static str, bool, u64)> {
+        let get = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        vec![
+            (
+                "code_cache_blocks",
+                "Blocks in the code cache",
+                true,
+                get(&self.blocks),
+            ),
+            (
+                "code_cache_bytes",
+                "Bytes of translated code",
+                true,
+                get(&self.bytes),
+            ),
+            (
+                "code_cache_peak_bytes",
+                "Largest code cache size",
+                true,
+                get(&self.peak_bytes),
+            ),
+            (
+                "code_cache_translations",
+                "Blocks translated",
+                false,
+                get(&self.translations),
+            ),
+            (
+                "code_cache_retranslations",
+                "Blocks translated again after eviction or invalidation",
+                false,
+                get(&self.retranslations),
+            ),
+            (
+                "code_cache_prefetched",
+                "Blocks translated by background workers",
+                false,
+                get(&self.prefetched),
+            ),
+            (
+                "code_cache_evictions",
+                "Blocks evicted",
+                false,
+                get(&self.evictions),
+            ),
+            (
+                "code_cache_invalidated",
+                "Blocks dropped because guest code changed",
+                false,
+                get(&self.invalidated),
+            ),
+        ]
+    }
+
+    fn bump(counter: &AtomicU64, by: usize) {
+        counter.fetch_add(by as u64, Ordering::Relaxed);
+    }
+}
+
+fn human_bytes(bytes: u64) -> String {
+    if bytes >= 1 << 20 {
+        format!("{:.1} MiB", bytes as f64 / (1 << 20) as f64)
+    } else {
+        format!("{:.1} KiB", bytes as f64 / 1024.0)
+    }
+}
+
+/// Translated blocks keyed by guest entry address.
+pub(super) struct CodeCache<B> {
+    decoder: Arc<Decoder>,
+    bias: Arc<BranchBias>,
+    blocks: HashMap<usize, Cached<B>>,
+    workers: Option<Workers<B>>,
+    threads: usize,
+    /// Blocks translated on the guest thread; the workers start once this
+    /// reaches `SPAWN_AFTER_MISSES`.
+    misses: u64,
+    policy: EvictPolicy,
+    budget: usize,
+    /// Bytes currently charged against `budget`.
+    bytes: usize,
+    /// Advances on every lookup; the LRU policy evicts the smallest stamps.
+    tick: u64,
+    generation: u32,
+    generation_bytes: usize,
+    /// Entry addresses translated at least once, to count retranslations.
+    translated: HashSet<usize>,
+    stats: Arc<CacheStats>,
+}
+
+struct Cached<B> {
+    block: B,
+    /// End of the guest code the block covers.
+    end: usize,
+    bytes: usize,
+    last_used: u64,
+    generation: u32,
+}
+
+struct Workers<B> {
+    requests: Sender<usize>,
+    ready: Receiver<(usize, B)>,
+    /// Entries the workers have already translated, so decode-ahead does
+    /// not repeat itself. Cleared whenever blocks are evicted, since those
+    /// are worth prefetching again.
+    seen: Arc<Mutex<HashSet<usize>>>,
+    /// Process that spawned the workers. A forked child keeps only the
+    /// calling thread, so it stops talking to the (now absent) workers.
+    pid: u32,
+}
+
+impl<B: Translate> CodeCache<B> {
+    pub(super) fn new(memory: &MemoryImage, options: &Options, bias: Arc<BranchBias>) -> Self {
+        let decoder = Arc::new(Decoder::new(memory.code_view()));
+        // Decoding single instructions ahead costs more than it saves.
+        let threads = options
+            .translate_threads
+            .unwrap_or_else(|| match options.tier {
+                ExecTier::Interpreter => 0,
+                ExecTier::Ir | ExecTier::Threaded => thread::available_parallelism()
+                    .map_or(0, |n| n.get().saturating_sub(1))
+                    .min(DEFAULT_MAX_THREADS),
+            });
+        let budget = options.code_cache_size.unwrap_or(DEFAULT_BUDGET);
+        let stats = Arc::new(CacheStats::default());
+        CacheStats::bump(&stats.budget, budget);
+        Self {
+            workers: None,
+            decoder,
+            bias,
+            blocks: HashMap::new(),
+            threads,
+            misses: 0,
+            policy: options.code_cache_policy,
+            budget,
+            bytes: 0,
+            tick: 0,
+            generation: 0,
+            generation_bytes: 0,
+            translated: HashSet::new(),
+            stats,
+        }
+    }
+
+    pub(super) fn stats(&self) -> Arc<CacheStats> {
+        Arc::clone(&self.stats)
+    }
+
+    /// Entry points of the cached blocks, most recently entered first.
+    pub(super) fn entries(&self) -> Vec<usize> {
+        let mut entries: Vec<(u64, usize)> = self
+            .blocks
+            .iter()
+            .map(|(&pc, cached)| (cached.last_used, pc))
+            .collect();
+        entries.sort_unstable_by(|a, b| b.cmp(a));
+        entries.into_iter().map(|(_, pc)| pc).collect()
+    }
+
+    /// Block starting at `pc`, translating it now if no worker got there
+    /// first.
+    pub(super) fn get(&mut self, pc: usize) -> Result<&B> {
+        if !self.blocks.contains_key(&pc) {
+            self.collect();
+            if !self.blocks.contains_key(&pc) {
+                let block = B::translate(&self.decoder, &self.bias, pc)?;
+                self.misses += 1;
+                if self.misses == SPAWN_AFTER_MISSES {
+                    self.workers = Workers::spawn(&self.decoder, &self.bias, self.threads);
+                }
+                self.post(&block);
+                self.insert(pc, block, false);
+            }
+        }
+        self.tick += 1;
+        let cached = self.blocks.get_mut(&pc).expect("block was just inserted");
+        cached.last_used = self.tick;
+        Ok(&cached.block)
+    }
+
+    /// Drop blocks overlapping the queued ranges, reloading the decoder's
+    /// view of guest memory when a range asks for it or lost any blocks.
+    pub(super) fn invalidate(&mut self, stale: &mut Vec<StaleCode>, memory: &MemoryImage) {
+        let mut reload = false;
+        for StaleCode {
+            range,
+            reload: wants_reload,
+        } in stale.drain(..)
+        {
+            if range == (0..usize::MAX) {
+                // A new image (execve): the profile's addresses were the
+                // old one's.
+                self.bias = Arc::default();
+            }
+            let before = self.blocks.len();
+            let bytes = &mut self.bytes;
+            self.blocks.retain(|&pc, cached| {
+                let keep = cached.end <= range.start || pc >= range.end;
+                if !keep {
+                    *bytes -= cached.bytes;
+                }
+                keep
+            });
+            let dropped = before - self.blocks.len();
+            CacheStats::bump(&self.stats.invalidated, dropped);
+            reload |= wants_reload || dropped > 0;
+        }
+        if reload {
+            // Workers hold the old decoder; replacing them also discards any
+            // blocks they built from it.
+            self.decoder = Arc::new(Decoder::new(memory.code_view()));
+            if self.workers.is_some() {
+                self.workers = Workers::spawn(&self.decoder, &self.bias, self.threads);
+            }
+        }
+        self.update_occupancy();
+    }
+
+    /// Translate `pcs`, hottest first, on every host core before the guest
+    /// starts. Stops at half the budget so code the profile never saw still
+    /// has room.
+    fn warm(&mut self, pcs: &[usize]) {
+        let threads = thread::available_parallelism().map_or(1, |n| n.get());
+        let (decoder, bias) = (&*self.decoder, &*self.bias);
+        let blocks: Vec<(usize, B)> = thread::scope(|scope| {
+            let handles: Vec<_> = pcs
+                .chunks(pcs.len().div_ceil(threads).max(1))
+                .map(|chunk| {
+                    scope.spawn(move || {
+                        chunk
+                            .iter()
+                            .filter_map(|&pc| Some((pc, B::translate(decoder, bias, pc).ok()?)))
+                            .collect::<Vec<_>>()
+                    })
+                })
+                .collect();
+            handles
+                .into_iter()
+                .flat_map(|handle| handle.join().unwrap_or_default())
+                .collect()
+        });
+        self.fill(blocks);
+    }
+
+    /// Translate everything reachable from `roots` before the guest starts
+    /// (`--predecode`), following the same exits as `behistun aot`.
+    fn predecode(&mut self, roots: &[usize]) {
+        let (decoder, bias) = (&*self.decoder, &*self.bias);
+        let memory = decoder.memory();
+        let blocks = discover::walk(memory, roots, |pc| {
+            let block = B::translate(decoder, bias, pc).ok()?;
+            let insts = block.insts();
+            // Side exits of blocks laid out by bias count too.
+            let mut next: Vec<usize> = insts
+                .iter()
+                .filter(|inst| ends_block(&inst.kind))
+                .flat_map(|inst| discover::exits(memory, inst))
+                .collect();
+            if let Some(last) = insts.last()
+                && !ends_block(&last.kind)
+            {
+                next.push(last.address + last.len());
+            }
+            Some((block, next))
+        });
+        self.fill(blocks);
+    }
+
+    /// Insert blocks translated before the guest started, stopping at half
+    /// the budget so code nobody predicted still has room.
+    fn fill(&mut self, blocks: Vec<(usize, B)>) {
+        for (pc, block) in blocks {
+            if self.bytes + block.footprint() > self.budget / 2 {
+                break;
+            }
+            if !self.blocks.contains_key(&pc) {
+                self.insert(pc, block, true);
+            }
+        }
+    }
+
+    /// Move blocks finished by workers into the map, unless they would push
+    /// it over budget.
+    fn collect(&mut self) {
+        let Some(workers) = self.workers.as_ref().filter(|w| w.pid == process::id()) else {
+            return;
+        };
+        let ready: Vec<_> = workers.ready.try_iter().collect();
+        for (pc, block) in ready {
+            if !self.blocks.contains_key(&pc) && self.bytes + block.footprint() <= self.budget {
+                self.insert(pc, block, true);
+            }
+        }
+    }
+
+    /// Queue the successors of a freshly translated block for decode-ahead.
+    fn post(&self, block: &B) {
+        let Some(workers) = self.workers.as_ref().filter(|w| w.pid == process::id()) else {
+            return;
+        };
+        for pc in successors(block.insts()) {
+            if !self.blocks.contains_key(&pc) {
+                let _ = workers.requests.send(pc);
+            }
+        }
+    }
+
+    fn insert(&mut self, pc: usize, block: B, prefetched: bool) {
+        let bytes = block.footprint() + mem::size_of::<(usize, Cached<B>)>();
+        if self.bytes + bytes > self.budget {
+            self.evict(bytes);
+        }
+        if self.generation_bytes >= self.budget / GENERATIONS {
+            self.generation += 1;
+            self.generation_bytes = 0;
+        }
+        self.generation_bytes += bytes;
+        self.bytes += bytes;
+
+        CacheStats::bump(&self.stats.translations, 1);
+        if prefetched {
+            CacheStats::bump(&self.stats.prefetched, 1);
+        }
+        if !self.translated.insert(pc) {
+            CacheStats::bump(&self.stats.retranslations, 1);
+        }
+
+        let end = block.insts().last().map_or(pc, |i| i.address + i.len());
+        self.blocks.insert(
+            pc,
+            Cached {
+                block,
+                end,
+                bytes,
+                last_used: self.tick,
+                generation: self.generation,
+            },
+        );
+        self.update_occupancy();
+    }
+
+    /// Make room for `needed` more bytes.
+    fn evict(&mut self, needed: usize) {
+        let before = self.blocks.len();
+        match self.policy {
+            EvictPolicy::Flush => {
+                self.blocks.clear();
+                self.bytes = 0;
+            }
+            EvictPolicy::Lru => {
+                // Evict down to three quarters of the budget so the next few
+                // misses do not each pay for a pass.
+                let target = (self.budget / 4 * 3).saturating_sub(needed);
+                let mut by_age: Vec<_> = self
+                    .blocks
+                    .iter()
+                    .map(|(&pc, cached)| (cached.last_used, pc))
+                    .collect();
+                by_age.sort_unstable();
+                for (_, pc) in by_age {
+                    if self.bytes <= target {
+                        break;
+                    }
+                    if let Some(cached) = self.blocks.remove(&pc) {
+                        self.bytes -= cached.bytes;
+                    }
+                }
+            }
+            EvictPolicy::Generation => {
+                while self.bytes + needed > self.budget {
+                    let Some(oldest) = self.blocks.values().map(|c| c.generation).min() else {
+                        break;
+                    };
+                    let bytes = &mut self.bytes;
+                    self.blocks.retain(|_, cached| {
+                        let keep = cached.generation != oldest;
+                        if !keep {
+                            *bytes -= cached.bytes;
+                        }
+                        keep
+                    });
+                }
+            }
+        }
+        if let Some(workers) = &self.workers
+            && let Ok(mut seen) = workers.seen.lock()
+        {
+            seen.clear();
+        }
+        CacheStats::bump(&self.stats.evictions, before - self.blocks.len());
+        CacheStats::bump(&self.stats.eviction_passes, 1);
+    }
+
+    fn update_occupancy(&self) {
+        let stats = &self.stats;
+        stats
+            .blocks
+            .store(self.blocks.len() as u64, Ordering::Relaxed);
+        stats.bytes.store(self.bytes as u64, Ordering::Relaxed);
+        stats
+            .peak_bytes
+            .fetch_max(self.bytes as u64, Ordering::Relaxed);
+    }
+}
+
+impl<B: Translate> Workers<B> {
+    fn spawn(decoder: &Arc<Decoder>, bias: &Arc<BranchBias>, threads: usize) -> Option<Self> {
+        if threads == 0 {
+            return None;
+        }
+        let (requests, queue) = mpsc::channel();
+        let (done, ready) = mpsc::channel();
+        let queue = Arc::new(Mutex::new(queue));
+        let seen = Arc::new(Mutex::new(HashSet::new()));
+        for _ in 0..threads {
+            let decoder = Arc::clone(decoder);
+            let bias = Arc::clone(bias);
+            let queue = Arc::clone(&queue);
+            let seen = Arc::clone(&seen);
+            let done = done.clone();
+            // Running without workers is always correct, so a failed spawn
+            // just leaves fewer of them.
+            let _ = thread::Builder::new()
+                .name("translate".into())
+                .spawn(move || worker::<B>(&decoder, &bias, &queue, &seen, &done));
+        }
+        Some(Self {
+            requests,
+            ready,
+            seen,
+            pid: process::id(),
+        })
+    }
+}
+
+/// Translate posted entries and up to `DECODE_AHEAD_DEPTH` blocks of their
+/// successors. Exits once the guest side drops its channel ends.
+fn worker<B: Translate>(
+    decoder: &Decoder,
+    bias: &BranchBias,
+    queue: &Mutex<Receiver<usize>>,
+    seen: &Mutex<HashSet<usize>>,
+    done: &Sender<(usize, B)>,
+) {
+    loop {
+        let start = match queue.lock() {
+            Ok(queue) => queue.recv(),
+            Err(_) => return,
+        };
+        let Ok(start) = start else {
+            return;
+        };
+        let mut pending = vec![(start, 0)];
+        while let Some((pc, depth)) = pending.pop() {
+            let Ok(mut seen) = seen.lock() else {
+                return;
+            };
+            if !seen.insert(pc) {
+                continue;
+            }
+            drop(seen);
+            // Errors surface again if the guest ever reaches this address.
+            let Ok(block) = B::translate(decoder, bias, pc) else {
+                continue;
+            };
+            if depth < DECODE_AHEAD_DEPTH {
+                pending.extend(successors(block.insts()).map(|next| (next, depth + 1)));
+            }
+            if done.send((pc, block)).is_err() {
+                return;
+            }
+        }
+    }
+}
+
+/// Statically known addresses control can reach from the end of a block.
+fn successors(insts: &[Instruction]) -> impl Iterator<Item = usize> {
+    let (taken, fall_through) = match insts.last() {
+        Some(last) => {
+            let next = last.address + last.len();
+            let branch =
+                |displacement: i32| (last.address as i64 + 2 + displacement as i64) as usize;
+            let absolute = |resolved: ResolvedEa| match resolved {
+                ResolvedEa::Abs(target) => Some(target as usize),
+                _ => None,
+            };
+            match last.kind {
+                InstructionKind::Bra { displacement } => (Some(branch(displacement)), None),
+                InstructionKind::Bcc { displacement, .. }
+                | InstructionKind::Bsr { displacement } => (Some(branch(displacement)), Some(next)),
+                InstructionKind::DBcc { displacement, .. } => {
+                    (Some(branch(displacement as i32)), Some(next))
+                }
+                InstructionKind::Jsr { mode } => (absolute(mode.resolved), Some(next)),
+                InstructionKind::Jmp { mode } => (absolute(mode.resolved), None),
+                InstructionKind::Rts
+                | InstructionKind::Rtd { .. }
+                | InstructionKind::Rtr
+                | InstructionKind::Rte
+                | InstructionKind::Illegal
+                | InstructionKind::Reset => (None, None),
+                _ => (None, Some(next)),
+            }
+        }
+        None => (None, None),
+    };
+    taken.into_iter().chain(fall_through)
+}
+
+impl Cpu {
+    /// Code cache for a run loop, warmed and laid out from `--profile-in`
+    /// and filled by `--predecode`.
+    pub(super) fn code_cache<B: Translate>(&mut self) -> CodeCache<B> {
+        let hints = self.profile_hints.take();
+        let bias = hints
+            .as_ref()
+            .map_or_else(Arc::default, |h| Arc::clone(&h.bias));
+        let mut cache = CodeCache::new(&self.memory, &self.options, bias);
+        if let Some(hints) = hints {
+            cache.warm(&hints.hot);
+            cache.predecode(&hints.predecode);
+        }
+        self.code_cache_stats = Some(cache.stats());
+        // Setup is over; the run loop executes the entry point next.
+        if let Some(started) = self.options.startup_time.take() {
+            eprintln!("first instruction: {} us", started.elapsed().as_micros());
+        }
+        cache
+    }
+}
@@ -526,6 +526,7 @@ pub enum AddressModeData {
     IndexExt {
         ext_word: u16,
         base_disp: i32,
+        outer_disp: i32,
     },
 }
 
@@ -543,6 +544,7 @@ impl AddressModeData {
             AddressModeData::IndexExt {
                 ext_word,
                 base_disp,
+                outer_disp,
             } => {
                 let mut bytes = ext_word.to_be_bytes().to_vec();
                 // BD size is in bits 5-4: 00=reserved, 01=null, 10=word, 11=long
@@ -552,12 +554,29 @@ impl AddressModeData {
                     0b11 => bytes.extend(base_disp.to_be_bytes()),
                     _ => {}
                 }
+                // OD size is in bits 1-0 of I/IS for memory indirect forms
+                match outer_disp_size(ext_word) {
+                    0b10 => bytes.extend((outer_disp as i16).to_be_bytes()),
+                    0b11 => bytes.extend(outer_disp.to_be_bytes()),
+                    _ => {}
+                }
                 bytes
             }
         }
     }
 }
 
+/// Size field of the outer displacement in a full extension word: 0 when
+/// there is no memory indirection, else 01=null, 10=word, 11=long.
+fn outer_disp_size(ext_word: u16) -> u16 {
+    let i_is = ext_word & 0x7;
+    if i_is == 0 || i_is == 0x4 {
+        0
+    } else {
+        i_is & 0x3
+    }
+}
+
 #[derive(Debug, Clone, PartialEq, Copy)]
 pub enum Immediate {
     Byte(u8),
@@ -565,6 +584,16 @@ pub enum Immediate {
     Long(u32),
 }
 
+impl Immediate {
+    pub fn as_u32(self) -> u32 {
+        match self {
+            Immediate::Byte(v) => v as u32,
+            Immediate::Word(v) => v as u32,
+            Immediate::Long(v) => v,
+        }
+    }
+}
+
 pub struct Decoder {
     memory: MemoryImage,
 }
@@ -574,27 +603,40 @@ impl Decoder {
         Self { memory }
     }
 
+    pub fn memory(&self) -> &MemoryImage {
+        &self.memory
+    }
+
     fn resolve_ea(
         &self,
         mode: AddressingMode,
         offset: usize,
         immediate_size: Option<Size>,
+    ) -> Result<AddressingMode> {
+        let mut mode = self.read_ea_data(mode, offset, immediate_size)?;
+        mode.resolved = ResolvedEa::new(mode.ea, mode.data, offset as u32);
+        Ok(mode)
+    }
+
+    /// Read the extension words for `mode`, starting at `offset`.
+    fn read_ea_data(
+        &self,
+        mode: AddressingMode,
+        offset: usize,
+        immediate_size: Option<Size>,
     ) -> Result<AddressingMode> {
         match mode.ea {
             EffectiveAddress::Dr(_)
             | EffectiveAddress::Ar(_)
             | EffectiveAddress::Addr(_)
             | EffectiveAddress::AddrPostIncr(_)
-            | EffectiveAddress::AddrPreDecr(_) => Ok(AddressingMode {
-                ea: mode.ea,
-                data: None,
-            }),
+            | EffectiveAddress::AddrPreDecr(_) => Ok(AddressingMode { data: None, ..mode }),
             EffectiveAddress::AddrDisplace(_) | EffectiveAddress::PCDisplace => {
                 let word = self.memory.read_word(offset)?;
                 let value = Immediate::Word(word);
                 Ok(AddressingMode {
-                    ea: mode.ea,
                     data: Some(AddressModeData::Imm(value)),
+                    ..mode
                 })
             }
             EffectiveAddress::AddrIndex(_) | EffectiveAddress::PCIndex => {
@@ -617,18 +659,30 @@ impl Decoder {
                         }
                         _ => 0i32, // Reserved, treat as null
                     };
+                    let bd_len = match bd_size {
+                        0b10 => 2,
+                        0b11 => 4,
+                        _ => 0,
+                    };
+                    let od_offset = offset + 2 + bd_len;
+                    let outer_disp = match outer_disp_size(ext_word) {
+                        0b10 => self.memory.read_word(od_offset)? as i16 as i32,
+                        0b11 => self.memory.read_long(od_offset)? as i32,
+                        _ => 0,
+                    };
                     Ok(AddressingMode {
-                        ea: mode.ea,
                         data: Some(AddressModeData::IndexExt {
                             ext_word,
                             base_disp,
+                            outer_disp,
                         }),
+                        ..mode
                     })
                 } else {
                     // Brief extension word format (68000 compatible)
                     Ok(AddressingMode {
-                        ea: mode.ea,
                         data: Some(AddressModeData::Short(ext_word)),
+                        ..mode
                     })
                 }
             }
@@ -650,22 +704,22 @@ impl Decoder {
                     }
                 };
                 Ok(AddressingMode {
-                    ea: mode.ea,
                     data: Some(AddressModeData::Imm(value)),
+                    ..mode
                 })
             }
             EffectiveAddress::AbsShort => {
                 let word = self.memory.read_word(offset)?;
                 Ok(AddressingMode {
-                    ea: mode.ea,
                     data: Some(AddressModeData::Short(word)),
+                    ..mode
                 })
             }
             EffectiveAddress::AbsLong => {
                 let long = self.memory.read_long(offset)?;
                 Ok(AddressingMode {
-                    ea: mode.ea,
                     data: Some(AddressModeData::Long(long)),
+                    ..mode
                 })
             }
         }
@@ -2470,6 +2524,9 @@ impl AddrReg {
 pub struct AddressingMode {
     pub ea: EffectiveAddress,
     pub data: Option<AddressModeData>,
+    /// The operand with its extension words decoded, filled in by the
+    /// decoder so execution does not need to look at `data`.
+    pub resolved: ResolvedEa,
 }
 
 impl From<EffectiveAddress> for AddressingMode {
@@ -2477,6 +2534,139 @@ impl From<EffectiveAddress> for AddressingMode {
         Self {
             ea: value,
             data: None,
+            resolved: ResolvedEa::new(value, None, 0),
+        }
+    }
+}
+
+/// Index register of an indexed operand, as `reg.size * (1 << shift)`.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub struct IndexReg {
+    /// D0-D7 are 0-7, A0-A7 are 8-15.
+    pub reg: u8,
+    /// Use the whole register rather than its sign-extended low word.
+    pub long: bool,
+    pub shift: u8,
+}
+
+/// An effective address in a flat form that needs no further decoding.
+/// PC-relative operands have the PC folded in, absolute short addresses are
+/// sign-extended and extension-word fields are split out, so each variant
+/// maps directly onto an address computation.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub enum ResolvedEa {
+    /// Extension words have not been read yet.
+    Unresolved,
+    Dn(u8),
+    An(u8),
+    /// `(An)`
+    Ind(u8),
+    /// `(An)+`
+    PostInc(u8),
+    /// `-(An)`
+    PreDec(u8),
+    /// `(d16, An)`
+    DispAn {
+        reg: u8,
+        disp: i32,
+    },
+    /// `(bd, base, Xn)` without memory indirection. `base` is None for
+    /// PC-relative forms (the PC is part of `disp`) or a suppressed base.
+    Index {
+        base: Option<u8>,
+        index: Option<IndexReg>,
+        disp: u32,
+    },
+    /// `([bd, base, Xn], od)`: index applied before the pointer is read.
+    MemIndirectPre {
+        base: Option<u8>,
+        index: Option<IndexReg>,
+        disp: u32,
+        outer: u32,
+    },
+    /// `([bd, base], Xn, od)`: index applied after the pointer is read.
+    MemIndirectPost {
+        base: Option<u8>,
+        index: Option<IndexReg>,
+        disp: u32,
+        outer: u32,
+    },
+    /// Absolute and `(d16, PC)` addresses.
+    Abs(u32),
+    Imm(u32),
+}
+
+impl ResolvedEa {
+    /// Flatten `ea` and its extension `data`; `ext_addr` is the address of
+    /// the first extension word, which is the PC for PC-relative forms.
+    fn new(ea: EffectiveAddress, data: Option<AddressModeData>, ext_addr: u32) -> Self {
+        match (ea, data) {
+            (EffectiveAddress::Dr(reg), _) => Self::Dn(reg as u8),
+            (EffectiveAddress::Ar(reg), _) => Self::An(reg as u8),
+            (EffectiveAddress::Addr(reg), _) => Self::Ind(reg as u8),
+            (EffectiveAddress::AddrPostIncr(reg), _) => Self::PostInc(reg as u8),
+            (EffectiveAddress::AddrPreDecr(reg), _) => Self::PreDec(reg as u8),
+            (EffectiveAddress::AddrDisplace(reg), Some(AddressModeData::Imm(imm))) => {
+                Self::DispAn {
+                    reg: reg as u8,
+                    disp: imm.as_u32() as i16 as i32,
+                }
+            }
+            (EffectiveAddress::PCDisplace, Some(AddressModeData::Imm(imm))) => {
+                Self::Abs(ext_addr.wrapping_add(imm.as_u32() as i16 as i32 as u32))
+            }
+            (EffectiveAddress::AddrIndex(reg), Some(data)) => {
+                Self::indexed(Some(reg as u8), 0, data)
+            }
+            (EffectiveAddress::PCIndex, Some(data)) => Self::indexed(None, ext_addr, data),
+            (EffectiveAddress::AbsShort, Some(AddressModeData::Short(addr))) => {
+                Self::Abs(addr as i16 as i32 as u32)
+            }
+            (EffectiveAddress::AbsLong, Some(AddressModeData::Long(addr))) => Self::Abs(addr),
+            (EffectiveAddress::Immediate, Some(AddressModeData::Imm(imm))) => {
+                Self::Imm(imm.as_u32())
+            }
+            _ => Self::Unresolved,
+        }
+    }
+
+    fn indexed(base: Option<u8>, pc: u32, data: AddressModeData) -> Self {
+        let (ext_word, base_disp, outer_disp) = match data {
+            // Brief format: 8-bit displacement in the low byte
+            AddressModeData::Short(ext_word) => (ext_word, ext_word as u8 as i8 as i32, 0),
+            AddressModeData::IndexExt {
+                ext_word,
+                base_disp,
+                outer_disp,
+            } => (ext_word, base_disp, outer_disp),
+            _ => return Self::Unresolved,
+        };
+        let full = ext_word & 0x0100 != 0;
+        let index = (!(full && ext_word & 0x0040 != 0)).then_some(IndexReg {
+            reg: ((ext_word >> 12) & 0x7) as u8 | if ext_word & 0x8000 != 0 { 8 } else { 0 },
+            long: ext_word & 0x0800 != 0,
+            shift: ((ext_word >> 9) & 0x3) as u8,
+        });
+        let (base, disp) = if full && ext_word & 0x0080 != 0 {
+            (None, base_disp as u32)
+        } else {
+            (base, pc.wrapping_add(base_disp as u32))
+        };
+        let outer = outer_disp as u32;
+        match ext_word & 0x7 {
+            i_is if !full || i_is == 0 => Self::Index { base, index, disp },
+            i_is if i_is & 0x4 != 0 => Self::MemIndirectPost {
+                base,
+                index,
+                disp,
+                outer,
+            },
+            _ => Self::MemIndirectPre {
+                base,
+                index,
+                disp,
+                outer,
+            },
         }
     }
 }
@@ -2512,22 +2702,6 @@ impl AddressingMode {
             _ => None,
         }
     }
-
-    /// Get index extension data (for 68020+ full format or 68000 brief format)
-    pub fn index_ext(&self) -> Option<(u16, i32)> {
-        match self.data {
-            Some(AddressModeData::IndexExt {
-                ext_word,
-                base_disp,
-            }) => Some((ext_word, base_disp)),
-            Some(AddressModeData::Short(ext_word)) => {
-                // Brief format: 8-bit displacement in low byte
-                let disp = (ext_word & 0xFF) as i8 as i32;
-                Some((ext_word, disp))
-            }
-            _ => None,
-        }
-    }
 }
 
 #[derive(Debug, PartialEq, Clone, Copy)]
@@ -2627,6 +2801,13 @@ pub enum Condition {
     LessOrEqual,    // LE  b1111
 }
 
+impl Condition {
+    /// The opposite condition; encodings pair up on the low bit.
+    pub fn negate(self) -> Self {
+        Self::from(self as u8 ^ 1)
+    }
+}
+
 impl From<u8> for Condition {
     fn from(value: u8) -> Self {
         match value {
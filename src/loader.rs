@@ -1,10 +1,148 @@
-use anyhow::{Result, bail};
+use std::{fs::File, ops::Deref, os::fd::AsRawFd, sync::Arc};
+
+use anyhow::{Context, Result, anyhow, bail};
 
 use goblin::elf::{Elf, program_header};
 
-use crate::memory::{MemoryImage, MemorySegment};
+use crate::memory::{MemoryData, MemoryImage, MemorySegment};
+
+const PAGE_SIZE: usize = 4096;
+
+/// A guest binary mapped read-only. Parsing reads only the pages goblin
+/// looks at, and segments are mapped from the same file rather than copied
+/// out of it.
+pub struct ElfFile {
+    ptr: *const u8,
+    len: usize,
+    file: Arc<File>,
+}
 
-pub fn load_memory_image(elf: &Elf, file_bytes: &[u8]) -> Result<MemoryImage> {
+impl ElfFile {
+    pub fn open(path: impl AsRef<std::path::Path>) -> Result<Self> {
+        let path = path.as_ref();
+        let file = File::open(path).with_context(|| format!("opening {}", path.display()))?;
+        let len = file.metadata()?.len() as usize;
+        if len == 0 {
+            bail!("{}: empty file", path.display());
+        }
+        // SAFETY: a fresh read-only mapping aliases no Rust memory.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error())
+                .with_context(|| format!("mapping {}", path.display()));
+        }
+        Ok(Self {
+            ptr: ptr.cast(),
+            len,
+            file: Arc::new(file),
+        })
+    }
+}
+
+impl Deref for ElfFile {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        // SAFETY: the mapping lives as long as `self`.
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+}
+
+impl Drop for ElfFile {
+    fn drop(&mut self) {
+        // SAFETY: nothing borrowed from the mapping outlives `self`.
+        unsafe { libc::munmap(self.ptr as *mut libc::c_void, self.len) };
+    }
+}
+
+pub fn load_memory_image(elf: &Elf, file: &ElfFile) -> Result<MemoryImage> {
+    // The program is loaded at its link addresses, which for a PIE start
+    // at 0 on top of the null page below.
+    if elf.header.e_type == goblin::elf::header::ET_DYN {
+        bail!("position-independent executables are not supported; link the guest with -no-pie");
+    }
+    let mut segments = load_segments(elf, file, 0)?;
+    segments.sort_by_key(|seg| seg.vaddr);
+
+    // Add a null page at address 0 to handle buggy library code that writes to NULL
+    // This is a workaround for uclibc's __tunable_get_val which has a code path
+    // that writes to a NULL pointer
+    segments.insert(
+        0,
+        MemorySegment {
+            vaddr: 0,
+            data: MemoryData::Owned(vec![0u8; 4096]),
+            flags: program_header::PF_R | program_header::PF_W,
+            align: 0x1000,
+        },
+    );
+
+    // Place a stack segment high in the 32-bit address space so the heap
+    // (brk) can grow upward from the program data/BSS.
+    // `vec![0; n]` comes from calloc, so the kernel zero-fills these pages
+    // on first touch instead of us clearing the whole stack up front.
+    let stack_size = 1024 * 1024; // 1MB stack
+    // Leave a small guard gap below the top of user space to mimic Linux.
+    let stack_top: usize = 0xfffff000;
+    let stack_base = stack_top - stack_size;
+
+    segments.push(MemorySegment {
+        vaddr: stack_base,
+        data: MemoryData::Owned(vec![0u8; stack_size]),
+        flags: program_header::PF_R | program_header::PF_W, // Read + Write
+        align: 0x1000,
+    });
+
+    Ok(MemoryImage::new(segments))
+}
+
+/// Load the dynamic loader named by `elf`'s PT_INTERP from `file` into
+/// `memory` at the first free range, like the kernel does, returning its
+/// base address and entry point.
+pub fn load_interpreter(
+    elf: &Elf,
+    file: &ElfFile,
+    memory: &mut MemoryImage,
+) -> Result<(usize, usize)> {
+    if elf.header.e_type != goblin::elf::header::ET_DYN {
+        bail!("the program interpreter is not position independent");
+    }
+    let loads = || {
+        elf.program_headers
+            .iter()
+            .filter(|ph| ph.p_type == program_header::PT_LOAD && ph.p_memsz > 0)
+    };
+    let align = loads()
+        .map(|ph| ph.p_align.max(PAGE_SIZE as u64) as usize)
+        .max()
+        .unwrap_or(PAGE_SIZE);
+    let start = loads().map(|ph| ph.p_vaddr as usize & !(align - 1)).min();
+    let end = loads().map(|ph| (ph.p_vaddr + ph.p_memsz) as usize).max();
+    let (Some(start), Some(end)) = (start, end) else {
+        bail!("the program interpreter has no loadable segments");
+    };
+    let base = memory
+        .find_free_range(end - start + align)
+        .map(|addr| addr.next_multiple_of(align) - start)
+        .ok_or_else(|| anyhow!("no room for the program interpreter"))?;
+    for segment in load_segments(elf, file, base)? {
+        memory.add_segment(segment);
+    }
+    Ok((base, base + elf.entry as usize))
+}
+
+/// The PT_LOAD segments of `elf`, moved up by `bias`.
+fn load_segments(elf: &Elf, file: &ElfFile, bias: usize) -> Result<Vec<MemorySegment>> {
+    let file_bytes: &[u8] = file;
     let mut segments = Vec::new();
 
     for ph in &elf.program_headers {
@@ -39,14 +177,29 @@ pub fn load_memory_image(elf: &Elf, file_bytes: &[u8]) -> Result<MemoryImage> {
 
         // Align segment start down to at least 4KB (common for ELF PT_LOAD)
         let align = ph.p_align.max(0x1000) as usize;
-        let seg_start = (ph.p_vaddr as usize) & !(align - 1);
-        let pad = ph.p_vaddr as usize - seg_start;
-
-        let mut data = vec![0u8; pad + mem_size];
-        if file_size > 0 {
-            let end = offset + file_size;
-            data[pad..pad + file_size].copy_from_slice(&file_bytes[offset..end]);
-        }
+        let vaddr = bias + ph.p_vaddr as usize;
+        let seg_start = vaddr & !(align - 1);
+        let pad = vaddr - seg_start;
+
+        // A segment with no BSS tail whose file offset lines up with its
+        // page is mapped straight from the file, like the kernel does;
+        // anything else is copied.
+        let data =
+            if mem_size == file_size && offset >= pad && (offset - pad).is_multiple_of(PAGE_SIZE) {
+                MemoryData::map_file(
+                    Arc::clone(&file.file),
+                    (offset - pad) as u64,
+                    pad + mem_size,
+                )
+                .with_context(|| format!("mapping segment at vaddr {vaddr:#x}"))?
+            } else {
+                let mut data = vec![0u8; pad + mem_size];
+                if file_size > 0 {
+                    let end = offset + file_size;
+                    data[pad..pad + file_size].copy_from_slice(&file_bytes[offset..end]);
+                }
+                MemoryData::Owned(data)
+            };
 
         // Some static binaries (e.g., uClibc-built) self-patch code/PLT areas; allow writes.
         let mut flags = ph.p_flags;
@@ -56,40 +209,11 @@ pub fn load_memory_image(elf: &Elf, file_bytes: &[u8]) -> Result<MemoryImage> {
 
         segments.push(MemorySegment {
             vaddr: seg_start,
-            data: crate::memory::MemoryData::Owned(data),
+            data,
             flags,
             align: ph.p_align as usize,
         });
     }
 
-    segments.sort_by_key(|seg| seg.vaddr);
-
-    // Add a null page at address 0 to handle buggy library code that writes to NULL
-    // This is a workaround for uclibc's __tunable_get_val which has a code path
-    // that writes to a NULL pointer
-    segments.insert(
-        0,
-        MemorySegment {
-            vaddr: 0,
-            data: crate::memory::MemoryData::Owned(vec![0u8; 4096]),
-            flags: program_header::PF_R | program_header::PF_W,
-            align: 0x1000,
-        },
-    );
-
-    // Place a stack segment high in the 32-bit address space so the heap
-    // (brk) can grow upward from the program data/BSS.
-    let stack_size = 1024 * 1024; // 1MB stack
-    // Leave a small guard gap below the top of user space to mimic Linux.
-    let stack_top: usize = 0xfffff000;
-    let stack_base = stack_top - stack_size;
-
-    segments.push(MemorySegment {
-        vaddr: stack_base,
-        data: crate::memory::MemoryData::Owned(vec![0u8; stack_size]),
-        flags: program_header::PF_R | program_header::PF_W, // Read + Write
-        align: 0x1000,
-    });
-
-    Ok(MemoryImage::new(segments))
+    Ok(segments)
 }
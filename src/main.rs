@@ -2,17 +2,22 @@ mod cpu;
 mod decoder;
 mod loader;
 mod memory;
+mod options;
+mod symbols;
 mod syscall;
+mod trace;
 
-use std::{env, fs, path::PathBuf};
+use std::{env, path::PathBuf};
 
 use goblin::Object;
 
 use crate::{
-    cpu::{Cpu, ElfInfo},
-    loader::load_memory_image,
+    cpu::{Cpu, ElfInfo, save_code_map},
+    loader::{ElfFile, load_memory_image},
+    options::Options,
+    symbols::Symbols,
 };
-use anyhow::bail;
+use anyhow::{Context, bail};
 
 fn main() {
     if let Err(err) = run() {
@@ -22,8 +27,21 @@ fn main() {
 }
 
 fn run() -> anyhow::Result<()> {
-    let (binary_path, program_args) = parse_args()?;
-    let data = fs::read(&binary_path)?;
+    if env::args().nth(1).as_deref() == Some("aot") {
+        return run_aot(env::args().skip(2));
+    }
+    let mut args: Vec<String> = env::args().skip(1).collect();
+    let options = Options::parse(&mut args)?;
+    if let Some(path) = options.restore.clone() {
+        if !args.is_empty() {
+            bail!("--restore resumes the snapshot's own program and arguments; got {args:?}");
+        }
+        let mut cpu = Cpu::restore(&path, options)?;
+        cpu.run(vec![])?;
+        return Ok(());
+    }
+    let (binary_path, program_args) = guest_args(args)?;
+    let data = ElfFile::open(&binary_path)?;
     let elf = match Object::parse(&data)? {
         Object::Elf(elf) => elf,
         other => {
@@ -32,49 +50,57 @@ fn run() -> anyhow::Result<()> {
     };
 
     let memory = load_memory_image(&elf, &data)?;
+    let elf_info = ElfInfo::from_elf(&elf);
 
-    // Find where program headers are loaded in memory
-    // They're typically at the start of the first PT_LOAD segment + e_phoff
-    let first_load_vaddr = elf
-        .program_headers
-        .iter()
-        .find(|ph| ph.p_type == goblin::elf::program_header::PT_LOAD)
-        .map(|ph| ph.p_vaddr)
-        .unwrap_or(0x80000000);
-
-    // Program headers are at file offset e_phoff, which maps to vaddr + (e_phoff - p_offset)
-    // For typical ELFs, program headers are at vaddr + e_phoff when first segment starts at offset 0
-    let phdr_addr = first_load_vaddr + elf.header.e_phoff;
-
-    let elf_info = ElfInfo {
-        entry_point: elf.entry as u32,
-        phdr_addr: phdr_addr as u32,
-        phent_size: elf.header.e_phentsize as u32,
-        phnum: elf.header.e_phnum as u32,
-        tls_vaddr: elf
-            .program_headers
-            .iter()
-            .find(|ph| ph.p_type == goblin::elf::program_header::PT_TLS)
-            .map(|ph| ph.p_vaddr as u32),
-        tls_memsz: elf
-            .program_headers
-            .iter()
-            .find(|ph| ph.p_type == goblin::elf::program_header::PT_TLS)
-            .map(|ph| ph.p_memsz as u32)
-            .unwrap_or(0),
-    };
-
-    let mut cpu = Cpu::new(memory.clone(), &elf_info, &program_args)?;
+    let mut cpu = Cpu::new(memory, &elf_info, &program_args, options)?;
 
     // Use JIT mode - decode instructions on-the-fly as they're executed
     cpu.run(vec![])?;
     Ok(())
 }
 
-fn parse_args() -> anyhow::Result<(PathBuf, Vec<String>)> {
-    let mut args: Vec<String> = env::args().skip(1).collect();
+/// `behistun aot [--out PATH] BINARY`: find the guest's code statically and
+/// save the block list as `BINARY.aot`, which later runs of the same build
+/// translate up front.
+fn run_aot(mut args: impl Iterator<Item = String>) -> anyhow::Result<()> {
+    let mut out = None;
+    let mut binary = None;
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--out" => out = Some(args.next().context("--out expects a path")?),
+            _ if arg.starts_with("--") => bail!("unknown aot option {arg}"),
+            _ if binary.is_none() => binary = Some(arg),
+            _ => bail!("unexpected argument {arg}"),
+        }
+    }
+    let Some(binary) = binary else {
+        bail!("usage: behistun aot [--out PATH] BINARY");
+    };
+    // Runs look for the map next to the canonical path, as they report it
+    // in /proc/self/exe.
+    let binary = PathBuf::from(binary).canonicalize()?;
+    let binary = binary.to_string_lossy();
+    let data = ElfFile::open(&*binary)?;
+    let Object::Elf(elf) = Object::parse(&data)? else {
+        bail!("{binary}: not an ELF file");
+    };
+    let memory = load_memory_image(&elf, &data)?;
+    let roots: Vec<usize> = std::iter::once(elf.entry as usize)
+        .chain(Symbols::from_elf(&elf).starts())
+        .collect();
+    let out = out.unwrap_or_else(|| format!("{binary}.aot"));
+    let blocks = save_code_map(&binary, &memory, &roots, &out)?;
+    eprintln!("{out}: {blocks} blocks");
+    Ok(())
+}
+
+/// Split what follows the interpreter's flags into the guest binary and
+/// its argv.
+fn guest_args(mut args: Vec<String>) -> anyhow::Result<(PathBuf, Vec<String>)> {
     if args.is_empty() {
-        bail!("expected path to an ELF binary (usage: m68k-interp <binary> [args...])");
+        bail!(
+            "expected path to an ELF binary (usage: m68k-interp [options] <binary> [args...], options are listed in the README)"
+        );
     }
     let binary_path = PathBuf::from(args.remove(0));
     // Canonicalize the path to get an absolute path (for /proc/self/exe)
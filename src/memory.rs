@@ -1,12 +1,30 @@
 #![allow(dead_code)]
-use std::{error::Error, fmt};
+use std::{
+    error::Error,
+    fmt,
+    fs::File,
+    io,
+    os::fd::AsRawFd,
+    sync::{
+        Arc,
+        atomic::{AtomicU64, Ordering},
+    },
+};
 
 use goblin::elf::program_header;
 
-/// Memory data can be either owned (Vec<u8>) or foreign (from shmat)
+/// Memory data can be either owned (Vec<u8>), a private mapping of a file
+/// (ELF segments) or foreign (from shmat)
 #[derive(Debug)]
 pub enum MemoryData {
     Owned(Vec<u8>),
+    Mapped {
+        ptr: *mut u8,
+        len: usize,
+        /// File and offset the pages were mapped from, while they still
+        /// hold the file's bytes. Cleared on the first mutable access.
+        source: Option<(Arc<File>, u64)>,
+    },
     Foreign {
         ptr: *mut u8,
         len: usize,
@@ -14,10 +32,50 @@ pub enum MemoryData {
     },
 }
 
+impl MemoryData {
+    /// Map `len` bytes of `file` from `offset` (page-aligned) copy-on-write,
+    /// so pages are only read in, and only copied, when the guest touches
+    /// them.
+    pub fn map_file(file: Arc<File>, offset: u64, len: usize) -> io::Result<Self> {
+        // SAFETY: a fresh private mapping aliases no Rust memory.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                offset as libc::off_t,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(MemoryData::Mapped {
+            ptr: ptr.cast(),
+            len,
+            source: Some((file, offset)),
+        })
+    }
+}
+
 impl Clone for MemoryData {
     fn clone(&self) -> Self {
         match self {
             MemoryData::Owned(v) => MemoryData::Owned(v.clone()),
+            // Untouched file pages are mapped again rather than copied.
+            MemoryData::Mapped {
+                ptr,
+                len,
+                source: Some((file, offset)),
+            } => MemoryData::map_file(Arc::clone(file), *offset, *len).unwrap_or_else(|_| {
+                // SAFETY: the mapping is live for as long as `self`.
+                MemoryData::Owned(unsafe { std::slice::from_raw_parts(*ptr, *len) }.to_vec())
+            }),
+            MemoryData::Mapped { ptr, len, .. } => {
+                // SAFETY: the mapping is live for as long as `self`.
+                MemoryData::Owned(unsafe { std::slice::from_raw_parts(*ptr, *len) }.to_vec())
+            }
             // Foreign memory can't be safely cloned - would need re-attach
             // For now, panic if we try to clone foreign memory
             MemoryData::Foreign { .. } => {
@@ -31,15 +89,26 @@ impl Clone for MemoryData {
 
 impl Drop for MemoryData {
     fn drop(&mut self) {
-        if let MemoryData::Foreign { ptr, .. } = self {
+        match self {
             // Detach shared memory when segment is dropped
-            unsafe {
+            MemoryData::Foreign { ptr, .. } => unsafe {
                 libc::shmdt(*ptr as *const libc::c_void);
-            }
+            },
+            MemoryData::Mapped { ptr, len, .. } => unsafe {
+                libc::munmap(ptr.cast(), *len);
+            },
+            MemoryData::Owned(_) => {}
         }
     }
 }
 
+// Mapped and foreign segments stay attached until the MemoryData is
+// dropped, and their bytes are only reached through `&self`/`&mut self`
+// like an owned Vec, so the usual borrow rules keep cross-thread access
+// sound.
+unsafe impl Send for MemoryData {}
+unsafe impl Sync for MemoryData {}
+
 #[derive(Debug)]
 pub struct MemorySegment {
     pub vaddr: usize,
@@ -63,22 +132,50 @@ impl MemorySegment {
     pub fn len(&self) -> usize {
         match &self.data {
             MemoryData::Owned(v) => v.len(),
-            MemoryData::Foreign { len, .. } => *len,
+            MemoryData::Mapped { len, .. } | MemoryData::Foreign { len, .. } => *len,
         }
     }
 
-    fn as_slice(&self) -> &[u8] {
+    pub fn as_slice(&self) -> &[u8] {
         match &self.data {
             MemoryData::Owned(v) => v.as_slice(),
-            MemoryData::Foreign { ptr, len, .. } => unsafe {
+            MemoryData::Mapped { ptr, len, .. } | MemoryData::Foreign { ptr, len, .. } => unsafe {
                 std::slice::from_raw_parts(*ptr, *len)
             },
         }
     }
 
+    /// A copy of `range` (relative to the segment's start) as a segment of
+    /// its own. Untouched file pages are mapped again rather than copied.
+    fn piece(&self, range: std::ops::Range<usize>) -> MemorySegment {
+        let remapped = match &self.data {
+            MemoryData::Mapped {
+                source: Some((file, offset)),
+                ..
+            } if range.start.is_multiple_of(4096) => {
+                MemoryData::map_file(Arc::clone(file), offset + range.start as u64, range.len())
+                    .ok()
+            }
+            _ => None,
+        };
+        MemorySegment {
+            vaddr: self.vaddr + range.start,
+            data: remapped.unwrap_or_else(|| MemoryData::Owned(self.as_slice()[range].to_vec())),
+            flags: self.flags,
+            align: self.align,
+        }
+    }
+
     fn as_mut_slice(&mut self) -> &mut [u8] {
         match &mut self.data {
             MemoryData::Owned(v) => v.as_mut_slice(),
+            MemoryData::Mapped {
+                ptr, len, source, ..
+            } => unsafe {
+                // The caller may write; a clone must copy from now on.
+                *source = None;
+                std::slice::from_raw_parts_mut(*ptr, *len)
+            },
             MemoryData::Foreign { ptr, len, .. } => unsafe {
                 std::slice::from_raw_parts_mut(*ptr, *len)
             },
@@ -86,20 +183,144 @@ impl MemorySegment {
     }
 }
 
-#[derive(Debug, Clone)]
+/// Source of `MemoryImage::layout` ids, unique across all images so a window
+/// taken from one image never validates against another.
+static NEXT_LAYOUT: AtomicU64 = AtomicU64::new(1);
+
+fn next_layout() -> u64 {
+    NEXT_LAYOUT.fetch_add(1, Ordering::Relaxed)
+}
+
+#[derive(Debug)]
 pub struct MemoryImage {
     segments: Vec<MemorySegment>,
+    /// Changes whenever a segment is added, resized or removed, which is
+    /// when host pointers into segment data may move.
+    layout: u64,
+    /// Ranges written since `open_journal`, for `--record`.
+    journal: Option<Vec<JournalEntry>>,
+}
+
+/// A guest range that may have been written while a journal was open.
+#[derive(Debug)]
+pub struct JournalEntry {
+    pub addr: usize,
+    pub len: usize,
+    /// Contents when the range was handed out as a host pointer, so that
+    /// only the bytes the host actually changed need to be kept.
+    pub before: Option<Vec<u8>>,
+}
+
+impl Clone for MemoryImage {
+    fn clone(&self) -> Self {
+        Self::new(self.segments.clone())
+    }
+}
+
+/// Host view of one readable and writable segment, valid for as long as the
+/// image's layout id is unchanged.
+#[derive(Debug, Clone, Copy)]
+pub struct HostWindow {
+    start: usize,
+    end: usize,
+    ptr: *mut u8,
+    layout: u64,
+}
+
+impl Default for HostWindow {
+    fn default() -> Self {
+        Self {
+            start: 0,
+            end: 0,
+            ptr: std::ptr::null_mut(),
+            layout: 0,
+        }
+    }
+}
+
+impl HostWindow {
+    /// Host pointer to `size` bytes at `addr` if they lie inside the window
+    /// and `layout` is still the image's current layout.
+    #[inline]
+    pub fn get(&self, addr: usize, size: usize, layout: u64) -> Option<*mut u8> {
+        if addr >= self.start && addr + size <= self.end && layout == self.layout {
+            // SAFETY: the range is inside the segment the window was taken
+            // from, and an unchanged layout means its data has not moved.
+            Some(unsafe { self.ptr.add(addr - self.start) })
+        } else {
+            None
+        }
+    }
 }
 
 impl MemoryImage {
     pub fn new(segments: Vec<MemorySegment>) -> Self {
-        Self { segments }
+        Self {
+            segments,
+            layout: next_layout(),
+            journal: None,
+        }
+    }
+
+    /// Start noting every range written through `write_data` or handed out
+    /// by `guest_to_host_mut`.
+    pub fn open_journal(&mut self) {
+        self.journal = Some(Vec::new());
+    }
+
+    /// Stop journaling and return what was noted.
+    pub fn take_journal(&mut self) -> Vec<JournalEntry> {
+        self.journal.take().unwrap_or_default()
+    }
+
+    /// Note that all of `[addr, addr + len)` was filled in, as a new file
+    /// mapping is.
+    pub fn journal_range(&mut self, addr: usize, len: usize) {
+        if let Some(journal) = &mut self.journal {
+            journal.push(JournalEntry {
+                addr,
+                len,
+                before: None,
+            });
+        }
+    }
+
+    pub fn layout(&self) -> u64 {
+        self.layout
+    }
+
+    /// Window over the readable and writable segment containing `addr`.
+    pub fn window(&mut self, addr: usize) -> Option<HostWindow> {
+        let layout = self.layout;
+        let rw = program_header::PF_R | program_header::PF_W;
+        let segment = self
+            .segments
+            .iter_mut()
+            .find(|s| s.flags & rw == rw && addr >= s.vaddr && addr < s.vaddr + s.len())?;
+        Some(HostWindow {
+            start: segment.vaddr,
+            end: segment.vaddr + segment.len(),
+            ptr: segment.as_mut_slice().as_mut_ptr(),
+            layout,
+        })
     }
 
     pub fn segments(&self) -> &[MemorySegment] {
         &self.segments
     }
 
+    /// Copy of the executable segments only, which is all a decoder reads.
+    /// File pages the guest has not touched are shared, not copied.
+    pub fn code_view(&self) -> MemoryImage {
+        Self::new(
+            self.segments
+                .iter()
+                .filter(|s| s.flags & program_header::PF_X != 0)
+                .cloned()
+                .collect(),
+        )
+    }
+
     pub fn fetch_instruction(&self, addr: usize, size: usize) -> Result<&[u8], MemoryError> {
         self.read_range(addr, size, program_header::PF_X, "execute")
     }
@@ -158,6 +379,13 @@ impl MemoryImage {
         let offset = addr - segment.vaddr;
         let slice = segment.as_mut_slice();
         slice[offset..offset + size].copy_from_slice(data);
+        if let Some(journal) = &mut self.journal {
+            journal.push(JournalEntry {
+                addr,
+                len: size,
+                before: None,
+            });
+        }
         Ok(())
     }
 
@@ -232,10 +460,20 @@ impl MemoryImage {
             return Some(std::ptr::null_mut());
         }
         let end = addr.checked_add(size)?;
+        let journaling = self.journal.is_some();
         let segment = self.segment_containing_mut(addr, end)?;
         let offset = addr - segment.vaddr;
         let slice = segment.as_mut_slice();
-        Some(slice[offset..].as_mut_ptr())
+        let before = journaling.then(|| slice[offset..offset + size].to_vec());
+        let ptr = slice[offset..].as_mut_ptr();
+        if let Some(journal) = &mut self.journal {
+            journal.push(JournalEntry {
+                addr,
+                len: size,
+                before,
+            });
+        }
+        Some(ptr)
     }
 
     /// Get an immutable host pointer for a guest address range.
@@ -254,6 +492,7 @@ impl MemoryImage {
     pub fn add_segment(&mut self, segment: MemorySegment) {
         self.segments.push(segment);
         self.segments.sort_by_key(|s| s.vaddr);
+        self.layout = next_layout();
     }
 
     /// Resize an existing segment identified by its base address.
@@ -291,12 +530,17 @@ impl MemoryImage {
             });
         }
 
-        // Only owned segments can be resized
+        // Only owned segments can be resized; a mapped one is copied first.
+        if let MemoryData::Mapped { .. } = segment.data {
+            segment.data = MemoryData::Owned(segment.as_slice().to_vec());
+        }
         match &mut segment.data {
             MemoryData::Owned(v) => {
                 v.resize(new_size, 0);
+                self.layout = next_layout();
                 Ok(())
             }
+            MemoryData::Mapped { .. } => unreachable!("mapped segment was just copied"),
             MemoryData::Foreign { .. } => Err(MemoryError::AccessViolation {
                 addr: base,
                 access: "resize foreign segment",
@@ -317,7 +561,73 @@ impl MemoryImage {
     pub fn remove_segment(&mut self, idx: usize) {
         if idx < self.segments.len() {
             self.segments.remove(idx);
+            self.layout = next_layout();
+        }
+    }
+
+    /// Whether no segment overlaps `[addr, addr + size)`.
+    pub fn is_free(&self, addr: usize, size: usize) -> bool {
+        let end = addr.saturating_add(size);
+        !self
+            .segments
+            .iter()
+            .any(|s| s.vaddr < end && addr < s.vaddr + s.len())
+    }
+
+    /// Add `flags` to every segment overlapping `[addr, addr + size)`, for
+    /// mprotect. Segments aren't split and permissions are never taken
+    /// away, so guests can still write wherever they always could.
+    pub fn protect(&mut self, addr: usize, size: usize, flags: u32) {
+        let end = addr.saturating_add(size);
+        for segment in &mut self.segments {
+            if segment.vaddr < end && addr < segment.vaddr + segment.len() {
+                segment.flags |= flags;
+            }
+        }
+    }
+
+    /// Remove `[addr, addr + size)` from the image like munmap, splitting
+    /// segments that straddle either end. Shared memory is only detached
+    /// when the range covers the whole attachment.
+    pub fn unmap(&mut self, addr: usize, size: usize) {
+        self.remove_range(addr, size, false);
+    }
+
+    /// Clear `[addr, addr + size)` for a MAP_FIXED mapping. Unlike `unmap`
+    /// this also splits shared memory straddling the range; the pages that
+    /// survive become private copies, since part of an attachment can't be
+    /// detached on its own.
+    pub fn unmap_fixed(&mut self, addr: usize, size: usize) {
+        self.remove_range(addr, size, true);
+    }
+
+    fn remove_range(&mut self, addr: usize, size: usize, split_foreign: bool) {
+        if self.is_free(addr, size) {
+            return;
+        }
+        let end = addr.saturating_add(size);
+        let mut kept = Vec::with_capacity(self.segments.len() + 1);
+        for segment in std::mem::take(&mut self.segments) {
+            let (start, seg_end) = (segment.vaddr, segment.vaddr + segment.len());
+            let straddles = start < addr || seg_end > end;
+            if seg_end <= addr
+                || start >= end
+                || (straddles
+                    && !split_foreign
+                    && matches!(segment.data, MemoryData::Foreign { .. }))
+            {
+                kept.push(segment);
+                continue;
+            }
+            if start < addr {
+                kept.push(segment.piece(0..addr - start));
+            }
+            if seg_end > end {
+                kept.push(segment.piece(end - start..seg_end - start));
+            }
         }
+        self.segments = kept;
+        self.layout = next_layout();
     }
 
     /// Find a free address range of the given size (page-aligned)
@@ -0,0 +1,181 @@
+use std::time::Instant;
+
+use anyhow::{Result, anyhow, bail};
+
+use crate::cpu::{EvictPolicy, ExecTier, MetricsFormat};
+
+/// Interpreter options parsed from the flags that precede the guest binary.
+#[derive(Debug, Clone, Default)]
+pub struct Options {
+    pub tier: ExecTier,
+    /// Background translation workers for the block tiers; `None` picks a
+    /// default from the host's core count.
+    pub translate_threads: Option<usize>,
+    /// Byte budget for translated code; `None` uses the default.
+    pub code_cache_size: Option<usize>,
+    pub code_cache_policy: EvictPolicy,
+    /// Print code cache statistics when the guest exits.
+    pub code_cache_stats: bool,
+    /// Print executed instruction and syscall counts when the guest exits.
+    pub exec_stats: bool,
+    /// Print per-syscall counts and host time on exit and on SIGUSR1.
+    pub syscall_summary: bool,
+    /// Print the dynamic instruction mix on exit (`stats` feature).
+    pub inst_stats: bool,
+    /// Write the instruction mix as JSON to this path on exit.
+    pub inst_stats_json: Option<String>,
+    /// Write sampled guest call stacks (folded) to this path on exit.
+    pub guest_profile: Option<String>,
+    /// Instructions between profile samples; `None` uses the default.
+    pub guest_profile_every: Option<u64>,
+    /// Sample on a host timer at this rate instead of by instruction count.
+    pub guest_profile_hz: Option<u32>,
+    /// Run guest blocks through named host stubs and write a perf map.
+    pub perf_map: bool,
+    /// Write a binary execution trace to this path.
+    pub trace: Option<String>,
+    /// Also record the address and size of every guest store in the trace.
+    pub trace_writes: bool,
+    /// Log syscall results and their guest memory effects to this path.
+    pub record: Option<String>,
+    /// Feed syscall results back from a `--record` log instead of the host.
+    pub replay: Option<String>,
+    /// Dump the metrics registry here (`-` for stderr) on exit, on SIGUSR2
+    /// and every `metrics_interval` seconds.
+    pub metrics: Option<String>,
+    pub metrics_format: MetricsFormat,
+    pub metrics_interval: Option<u64>,
+    /// Write hot block entries and branch bias to this path on exit.
+    pub profile_out: Option<String>,
+    /// Pre-translate and lay out blocks from a `profile_out` file.
+    pub profile_in: Option<String>,
+    /// Discover and translate the guest's code on all cores before it runs.
+    pub predecode: bool,
+    /// Set by `--startup-time` to when the flag was parsed, at the top of
+    /// `main`; the time from there to the first guest instruction is
+    /// printed.
+    pub startup_time: Option<Instant>,
+    /// Write a process snapshot here at `snapshot_at` or when the guest
+    /// makes the snapshot hypercall.
+    pub snapshot: Option<String>,
+    /// Guest address (`0x...`) or function name to snapshot at.
+    pub snapshot_at: Option<String>,
+    /// Resume from this snapshot instead of loading a binary.
+    pub restore: Option<String>,
+    /// m68k root filesystem holding the dynamic loader and shared
+    /// libraries of dynamically linked guests.
+    pub sysroot: Option<String>,
+    /// Coalesce guest writes to stdout and stderr on the host side.
+    pub buffer_output: bool,
+}
+
+impl Options {
+    /// Consume leading `--flag value` / `--flag=value` arguments from `args`,
+    /// stopping at the first argument that is not a flag (the guest binary)
+    /// or after a literal `--`.
+    pub fn parse(args: &mut Vec<String>) -> Result<Self> {
+        let mut options = Options::default();
+        while let Some(arg) = args.first() {
+            if arg == "--" {
+                args.remove(0);
+                break;
+            }
+            if !arg.starts_with("--") {
+                break;
+            }
+            let arg = args.remove(0);
+            let (name, inline_value) = match arg.split_once('=') {
+                Some((name, value)) => (name.to_string(), Some(value.to_string())),
+                None => (arg, None),
+            };
+            let mut value = || -> Result<String> {
+                match &inline_value {
+                    Some(v) => Ok(v.clone()),
+                    None if !args.is_empty() => Ok(args.remove(0)),
+                    None => Err(anyhow!("option {name} expects a value")),
+                }
+            };
+            match name.as_str() {
+                "--tier" => options.tier = value()?.parse()?,
+                "--translate-threads" => {
+                    let value = value()?;
+                    let threads = value
+                        .parse()
+                        .map_err(|_| anyhow!("invalid thread count {value:?}"))?;
+                    options.translate_threads = Some(threads);
+                }
+                "--code-cache-size" => options.code_cache_size = Some(parse_size(&value()?)?),
+                "--code-cache-policy" => options.code_cache_policy = value()?.parse()?,
+                "--code-cache-stats" => options.code_cache_stats = true,
+                "--exec-stats" => options.exec_stats = true,
+                "--syscall-summary" => options.syscall_summary = true,
+                "--inst-stats" | "--inst-stats-json" if !cfg!(feature = "stats") => {
+                    bail!("{name} needs a build with `--features stats`")
+                }
+                "--inst-stats" => options.inst_stats = true,
+                "--inst-stats-json" => options.inst_stats_json = Some(value()?),
+                "--perf-map" => options.perf_map = true,
+                "--trace" => options.trace = Some(value()?),
+                "--trace-writes" => options.trace_writes = true,
+                "--record" => options.record = Some(value()?),
+                "--replay" => options.replay = Some(value()?),
+                "--metrics" => options.metrics = Some(value()?),
+                "--metrics-format" => options.metrics_format = value()?.parse()?,
+                "--metrics-interval" => {
+                    let value = value()?;
+                    let secs = value
+                        .parse()
+                        .ok()
+                        .filter(|&n| n > 0)
+                        .ok_or_else(|| anyhow!("invalid metrics interval {value:?}"))?;
+                    options.metrics_interval = Some(secs);
+                }
+                "--profile-out" => options.profile_out = Some(value()?),
+                "--profile-in" => options.profile_in = Some(value()?),
+                "--predecode" => options.predecode = true,
+                "--startup-time" => options.startup_time = Some(Instant::now()),
+                "--snapshot" => options.snapshot = Some(value()?),
+                "--snapshot-at" => options.snapshot_at = Some(value()?),
+                "--restore" => options.restore = Some(value()?),
+                "--sysroot" => options.sysroot = Some(value()?),
+                "--buffer-output" => options.buffer_output = true,
+                "--guest-profile" => options.guest_profile = Some(value()?),
+                "--guest-profile-every" => {
+                    let value = value()?;
+                    let every = value
+                        .parse()
+                        .ok()
+                        .filter(|&n| n > 0)
+                        .ok_or_else(|| anyhow!("invalid sample interval {value:?}"))?;
+                    options.guest_profile_every = Some(every);
+                }
+                "--guest-profile-hz" => {
+                    let value = value()?;
+                    let hz = value
+                        .parse()
+                        .ok()
+                        .filter(|&n| n > 0)
+                        .ok_or_else(|| anyhow!("invalid sample rate {value:?}"))?;
+                    options.guest_profile_hz = Some(hz);
+                }
+                _ => bail!("unknown option {name}"),
+            }
+        }
+        Ok(options)
+    }
+}
+
+/// Parse a byte count with an optional K, M or G suffix.
+fn parse_size(value: &str) -> Result<usize> {
+    let (digits, shift) = match value.as_bytes().last() {
+        Some(b'k' | b'K') => (&value[..value.len() - 1], 10),
+        Some(b'm' | b'M') => (&value[..value.len() - 1], 20),
+        Some(b'g' | b'G') => (&value[..value.len() - 1], 30),
+        _ => (value, 0),
+    };
+    digits
+        .parse::<usize>()
+        .ok()
+        .and_then(|n| n.checked_mul(1 << shift))
+        .ok_or_else(|| anyhow!("invalid size {value:?}"))
+}
@@ -0,0 +1,77 @@
+use goblin::elf::Elf;
+
+/// Function symbols from the guest ELF's `.symtab`, used to name guest
+/// code in profiles.
+#[derive(Debug, Default)]
+pub struct Symbols {
+    /// Sorted by start address.
+    funcs: Vec<Func>,
+}
+
+#[derive(Debug)]
+struct Func {
+    start: usize,
+    /// Zero when the symbol table did not record a size; such a symbol
+    /// covers everything up to the next one.
+    size: usize,
+    name: String,
+}
+
+impl Symbols {
+    pub fn from_elf(elf: &Elf) -> Self {
+        let mut funcs: Vec<Func> = elf
+            .syms
+            .iter()
+            .filter(|sym| sym.is_function() && sym.st_value != 0)
+            .filter_map(|sym| {
+                let name = elf.strtab.get_at(sym.st_name)?;
+                (!name.is_empty()).then(|| Func {
+                    start: sym.st_value as usize,
+                    size: sym.st_size as usize,
+                    name: name.to_string(),
+                })
+            })
+            .collect();
+        funcs.sort_by_key(|f| f.start);
+        // Aliases share an address; keep the first name.
+        funcs.dedup_by_key(|f| f.start);
+        Self { funcs }
+    }
+
+    /// Start addresses of all functions, in address order.
+    pub fn starts(&self) -> impl Iterator<Item = usize> + '_ {
+        self.funcs.iter().map(|f| f.start)
+    }
+
+    /// Function containing `addr` and the offset into it.
+    pub fn lookup(&self, addr: usize) -> Option<(&str, usize)> {
+        let index = self
+            .funcs
+            .partition_point(|f| f.start <= addr)
+            .checked_sub(1)?;
+        let func = &self.funcs[index];
+        let offset = addr - func.start;
+        if func.size != 0 && offset >= func.size {
+            return None;
+        }
+        Some((&func.name, offset))
+    }
+
+    /// `name` at a function entry, `name+0x10` inside one, or the raw
+    /// address when no symbol covers it.
+    pub fn describe(&self, addr: usize) -> String {
+        match self.lookup(addr) {
+            Some((name, 0)) => name.to_string(),
+            Some((name, offset)) => format!("{name}+{offset:#x}"),
+            None => format!("{addr:#010x}"),
+        }
+    }
+
+    /// Function name only, or the raw address when no symbol covers it.
+    pub fn function(&self, addr: usize) -> String {
+        match self.lookup(addr) {
+            Some((name, _)) => name.to_string(),
+            None => format!("{addr:#010x}"),
+        }
+    }
+}
@@ -0,0 +1,167 @@
+// Binary execution trace format shared by `--trace` and `behistun-trace`.
+//
+// A trace file is a header followed by chunks:
+//
+//   header: MAGIC, VERSION, varint len, exe path bytes
+//   chunk:  u32 little-endian payload length, payload
+//
+// A payload is a sequence of events, each starting with a varint whose low
+// TAG_BITS are the event tag and whose remaining bits are its value. Block
+// and write addresses are zigzag deltas from the previous block or write,
+// and every chunk starts from zero, so a trace cut short by a crash still
+// decodes up to its last complete chunk.
+
+use std::{
+    fs::File,
+    io::{self, Write},
+};
+
+pub const MAGIC: &[u8; 4] = b"BHTR";
+pub const VERSION: u8 = 1;
+pub const TAG_BITS: u32 = 3;
+
+/// Block entry; value is the pc delta.
+pub const TAG_BLOCK: u64 = 0;
+/// Byte, word and long stores; value is the address delta.
+pub const TAG_WRITE_BYTE: u64 = 1;
+pub const TAG_WRITE_WORD: u64 = 2;
+pub const TAG_WRITE_LONG: u64 = 3;
+/// Syscall entry; value is the m68k number, followed by six varint args.
+pub const TAG_SYSCALL: u64 = 4;
+/// Syscall return; value is the zigzag result.
+pub const TAG_RESULT: u64 = 5;
+/// Successful execve; value is the path length, followed by the path.
+pub const TAG_EXEC: u64 = 6;
+
+/// Payload bytes buffered before a chunk is written out.
+const CHUNK_SIZE: usize = 1 << 20;
+
+pub fn zigzag(value: i64) -> u64 {
+    ((value << 1) ^ (value >> 63)) as u64
+}
+
+fn put_varint(buf: &mut Vec<u8>, mut value: u64) {
+    while value >= 0x80 {
+        buf.push(value as u8 | 0x80);
+        value >>= 7;
+    }
+    buf.push(value as u8);
+}
+
+/// Buffered writer for one process's trace.
+pub struct TraceWriter {
+    file: File,
+    path: String,
+    /// Set once a chunk fails to write. The file then ends at its last
+    /// complete chunk, and later events are dropped instead of appended
+    /// after a gap.
+    failed: bool,
+    chunk: Vec<u8>,
+    last_pc: u32,
+    last_write: u32,
+}
+
+impl TraceWriter {
+    pub fn create(path: &str, exe_path: &str) -> io::Result<Self> {
+        let mut file = File::create(path)?;
+        let mut header = MAGIC.to_vec();
+        header.push(VERSION);
+        put_varint(&mut header, exe_path.len() as u64);
+        header.extend_from_slice(exe_path.as_bytes());
+        file.write_all(&header)?;
+        Ok(Self {
+            file,
+            path: path.to_string(),
+            failed: false,
+            chunk: Self::empty_chunk(),
+            last_pc: 0,
+            last_write: 0,
+        })
+    }
+
+    pub fn path(&self) -> &str {
+        &self.path
+    }
+
+    /// Chunk buffer with room for the length prefix.
+    fn empty_chunk() -> Vec<u8> {
+        let mut chunk = Vec::with_capacity(CHUNK_SIZE + 64);
+        chunk.extend_from_slice(&[0; 4]);
+        chunk
+    }
+
+    #[inline]
+    fn event(&mut self, tag: u64, value: u64) {
+        put_varint(&mut self.chunk, (value << TAG_BITS) | tag);
+    }
+
+    #[inline]
+    fn end_event(&mut self) {
+        if self.chunk.len() >= CHUNK_SIZE + 4
+            && let Err(e) = self.flush()
+        {
+            eprintln!(
+                "warning: writing trace {}: {e}; the trace stops here",
+                self.path
+            );
+        }
+    }
+
+    #[inline]
+    pub fn block(&mut self, pc: u32) {
+        let delta = pc.wrapping_sub(self.last_pc) as i32;
+        self.last_pc = pc;
+        self.event(TAG_BLOCK, zigzag(delta.into()));
+        self.end_event();
+    }
+
+    #[inline]
+    pub fn write(&mut self, addr: u32, size: u32) {
+        let tag = match size {
+            1 => TAG_WRITE_BYTE,
+            2 => TAG_WRITE_WORD,
+            _ => TAG_WRITE_LONG,
+        };
+        let delta = addr.wrapping_sub(self.last_write) as i32;
+        self.last_write = addr;
+        self.event(tag, zigzag(delta.into()));
+        self.end_event();
+    }
+
+    pub fn syscall(&mut self, number: u32, args: &[u32]) {
+        self.event(TAG_SYSCALL, u64::from(number));
+        for &arg in args {
+            put_varint(&mut self.chunk, u64::from(arg));
+        }
+        self.end_event();
+    }
+
+    /// `result` as the guest sees it in D0.
+    pub fn result(&mut self, result: i32) {
+        self.event(TAG_RESULT, zigzag(result.into()));
+        self.end_event();
+    }
+
+    pub fn exec(&mut self, path: &str) {
+        self.event(TAG_EXEC, path.len() as u64);
+        self.chunk.extend_from_slice(path.as_bytes());
+        self.end_event();
+    }
+
+    /// Write the buffered events as one chunk. Only the first failure is
+    /// reported; after it, events are discarded.
+    pub fn flush(&mut self) -> io::Result<()> {
+        let len = self.chunk.len() - 4;
+        if len == 0 || self.failed {
+            self.chunk.truncate(4);
+            return Ok(());
+        }
+        self.chunk[..4].copy_from_slice(&(len as u32).to_le_bytes());
+        let result = self.file.write_all(&self.chunk);
+        self.failed = result.is_err();
+        self.chunk.truncate(4);
+        self.last_pc = 0;
+        self.last_write = 0;
+        result
+    }
+}
@@ -0,0 +1,328 @@
+// Condensed port of the CoreMark kernels: linked-list find/reverse/sort,
+// small integer matrix algebra and a numeric-string state machine, each
+// folded into a CRC-16. This is not the certified EEMBC source; it keeps
+// the same mix of pointer chasing, multiply/accumulate and branchy byte
+// scanning. Usage: coremark [iterations]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 200
+#endif
+
+#define LIST_LEN 64
+#define MATRIX_N 12
+#define STATE_LEN 256
+
+// Result for the fixed seeds below, independent of the iteration count.
+#define EXPECTED_CRC 0xedde
+
+static uint16_t crcu8(uint8_t data, uint16_t crc) {
+  for (int i = 0; i < 8; ++i) {
+    uint8_t x16 = (data & 1) ^ (crc & 1);
+    data >>= 1;
+    if (x16 == 1) {
+      crc ^= 0x4002;
+      crc = (crc >> 1) | 0x8000;
+    } else {
+      crc >>= 1;
+    }
+  }
+  return crc;
+}
+
+static uint16_t crcu16(uint16_t value, uint16_t crc) {
+  crc = crcu8((uint8_t)value, crc);
+  return crcu8((uint8_t)(value >> 8), crc);
+}
+
+static uint16_t crcu32(uint32_t value, uint16_t crc) {
+  crc = crcu16((uint16_t)value, crc);
+  return crcu16((uint16_t)(value >> 16), crc);
+}
+
+// List kernel
+
+struct list_data {
+  int16_t data16;
+  int16_t idx;
+};
+
+struct list_head {
+  struct list_head *next;
+  struct list_data *info;
+};
+
+static int cmp_data(const struct list_data *a, const struct list_data *b) {
+  return a->data16 - b->data16;
+}
+
+static int cmp_idx(const struct list_data *a, const struct list_data *b) {
+  return a->idx - b->idx;
+}
+
+static struct list_head *list_reverse(struct list_head *list) {
+  struct list_head *next = NULL;
+  while (list) {
+    struct list_head *tmp = list->next;
+    list->next = next;
+    next = list;
+    list = tmp;
+  }
+  return next;
+}
+
+static struct list_head *list_find(struct list_head *list, int16_t data16) {
+  while (list && (list->info->data16 & 0xff) != data16) {
+    list = list->next;
+  }
+  return list;
+}
+
+// Bottom-up merge sort, as in core_list_mergesort.
+static struct list_head *
+list_sort(struct list_head *list,
+          int (*cmp)(const struct list_data *, const struct list_data *)) {
+  int insize = 1;
+  for (;;) {
+    struct list_head *p = list, *tail = NULL;
+    int nmerges = 0;
+    list = NULL;
+    while (p) {
+      struct list_head *q = p;
+      int psize = 0, qsize = insize;
+      ++nmerges;
+      for (int i = 0; i < insize && q; ++i) {
+        ++psize;
+        q = q->next;
+      }
+      while (psize > 0 || (qsize > 0 && q)) {
+        struct list_head *e;
+        if (psize == 0) {
+          e = q;
+          q = q->next;
+          --qsize;
+        } else if (qsize == 0 || !q || cmp(p->info, q->info) <= 0) {
+          e = p;
+          p = p->next;
+          --psize;
+        } else {
+          e = q;
+          q = q->next;
+          --qsize;
+        }
+        if (tail) {
+          tail->next = e;
+        } else {
+          list = e;
+        }
+        tail = e;
+      }
+      p = q;
+    }
+    tail->next = NULL;
+    if (nmerges <= 1) {
+      return list;
+    }
+    insize *= 2;
+  }
+}
+
+static uint16_t bench_list(struct list_head *nodes, struct list_data *data,
+                           int16_t seed) {
+  uint16_t crc = 0;
+  struct list_head *list = NULL;
+
+  for (int i = LIST_LEN - 1; i >= 0; --i) {
+    data[i].idx = i;
+    data[i].data16 = (int16_t)(((seed ^ (i * 0x1d)) * 0x3a7) & 0x7fff);
+    nodes[i].info = &data[i];
+    nodes[i].next = list;
+    list = &nodes[i];
+  }
+  for (int16_t i = 0; i < 16; ++i) {
+    struct list_head *found = list_find(list, (int16_t)((i * 37) & 0xff));
+    list = list_reverse(list);
+    crc = crcu16(found ? (uint16_t)found->info->idx : 0xffff, crc);
+  }
+  list = list_sort(list, cmp_data);
+  for (struct list_head *p = list; p; p = p->next) {
+    crc = crcu16((uint16_t)p->info->data16, crc);
+  }
+  list = list_sort(list, cmp_idx);
+  for (struct list_head *p = list; p; p = p->next) {
+    crc = crcu16((uint16_t)p->info->idx, crc);
+  }
+  return crc;
+}
+
+// Matrix kernel
+
+static uint16_t bench_matrix(int16_t a[MATRIX_N][MATRIX_N],
+                             int16_t b[MATRIX_N][MATRIX_N],
+                             int32_t c[MATRIX_N][MATRIX_N], int16_t seed) {
+  uint16_t crc = 0;
+
+  for (int i = 0; i < MATRIX_N; ++i) {
+    for (int j = 0; j < MATRIX_N; ++j) {
+      a[i][j] = (int16_t)((seed * (i + 1) + j) % 251 - 125);
+      b[i][j] = (int16_t)((seed * (j + 3) - i) % 127);
+    }
+  }
+  // Multiply by a constant, then matrix-vector, then matrix-matrix, then
+  // the bit-extracted product, checksumming after each step.
+  for (int i = 0; i < MATRIX_N; ++i) {
+    for (int j = 0; j < MATRIX_N; ++j) {
+      c[i][j] = (int32_t)a[i][j] * seed;
+      crc = crcu32((uint32_t)c[i][j], crc);
+    }
+  }
+  for (int i = 0; i < MATRIX_N; ++i) {
+    int32_t sum = 0;
+    for (int j = 0; j < MATRIX_N; ++j) {
+      sum += (int32_t)a[i][j] * b[0][j];
+    }
+    crc = crcu32((uint32_t)sum, crc);
+  }
+  for (int i = 0; i < MATRIX_N; ++i) {
+    for (int j = 0; j < MATRIX_N; ++j) {
+      int32_t sum = 0;
+      for (int k = 0; k < MATRIX_N; ++k) {
+        sum += (int32_t)a[i][k] * b[k][j];
+      }
+      c[i][j] = sum;
+      crc = crcu32((uint32_t)sum, crc);
+    }
+  }
+  for (int i = 0; i < MATRIX_N; ++i) {
+    for (int j = 0; j < MATRIX_N; ++j) {
+      int32_t sum = 0;
+      for (int k = 0; k < MATRIX_N; ++k) {
+        int32_t tmp = (int32_t)a[i][k] * b[k][j];
+        sum += ((tmp >> 2) & 0xf) * ((tmp >> 5) & 0x7f);
+      }
+      crc = crcu32((uint32_t)sum, crc);
+    }
+  }
+  return crc;
+}
+
+// State machine kernel
+
+enum state { START, INVALID, S1, S2, INT, FLOAT, EXPONENT, SCIENTIFIC };
+
+static enum state next_state(const char **instr, uint32_t *transitions) {
+  const char *str = *instr;
+  enum state state = START;
+
+  for (; *str && state != INVALID; ++str) {
+    char c = *str;
+    if (c == ',') {
+      ++str;
+      break;
+    }
+    int digit = c >= '0' && c <= '9';
+    switch (state) {
+    case START:
+      if (digit) {
+        state = INT;
+      } else if (c == '+' || c == '-') {
+        state = S1;
+      } else if (c == '.') {
+        state = FLOAT;
+      } else {
+        state = INVALID;
+      }
+      break;
+    case S1:
+      state = digit ? INT : c == '.' ? FLOAT : INVALID;
+      break;
+    case INT:
+      state = digit ? INT : c == '.' ? FLOAT : INVALID;
+      break;
+    case FLOAT:
+      state = digit                  ? FLOAT
+              : c == 'E' || c == 'e' ? S2
+                                     : INVALID;
+      break;
+    case S2:
+      state = c == '+' || c == '-' ? EXPONENT : INVALID;
+      break;
+    case EXPONENT:
+      state = digit ? SCIENTIFIC : INVALID;
+      break;
+    case SCIENTIFIC:
+      state = digit ? SCIENTIFIC : INVALID;
+      break;
+    case INVALID:
+      break;
+    }
+    ++transitions[state];
+  }
+  *instr = str;
+  return state;
+}
+
+static uint16_t bench_state(char *buf, int16_t seed) {
+  static const char *const patterns[] = {"5012", "1234", "-874", "+122",
+                                         "35.54400", ".1234500", "-110.700",
+                                         "+0.64400", "5.500e+3", "-.123e-2",
+                                         "-87e+832", "+0.6e-12", "T0.3e-1F",
+                                         "-T.T++Tq", "1T3.4e4z", "34.0e-T^"};
+  uint32_t final_counts[8] = {0}, transitions[8] = {0};
+  uint16_t crc = 0;
+  size_t len = 0;
+
+  while (len + 10 < STATE_LEN) {
+    const char *p = patterns[(seed + len) % 16];
+    memcpy(buf + len, p, 8);
+    buf[len + 8] = ',';
+    len += 9;
+  }
+  buf[len] = '\0';
+
+  for (int pass = 0; pass < 2; ++pass) {
+    const char *p = buf;
+    while (*p) {
+      ++final_counts[next_state(&p, transitions)];
+    }
+    // Corrupt every 7th byte and scan again.
+    for (size_t i = 0; i < len; i += 7) {
+      buf[i] ^= (char)(seed & 0xff) | 1;
+    }
+  }
+  for (int i = 0; i < 8; ++i) {
+    crc = crcu32(final_counts[i], crc);
+    crc = crcu32(transitions[i], crc);
+  }
+  return crc;
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  static struct list_head nodes[LIST_LEN];
+  static struct list_data data[LIST_LEN];
+  static int16_t a[MATRIX_N][MATRIX_N], b[MATRIX_N][MATRIX_N];
+  static int32_t c[MATRIX_N][MATRIX_N];
+  static char buf[STATE_LEN];
+  uint16_t first = 0;
+  int fail = 0;
+
+  for (long i = 0; i < iterations; ++i) {
+    uint16_t crc = 0;
+    crc = crcu16(bench_list(nodes, data, 0x66), crc);
+    crc = crcu16(bench_matrix(a, b, c, 0x15), crc);
+    crc = crcu16(bench_state(buf, 0x3b), crc);
+    if (i == 0) {
+      first = crc;
+    }
+    fail |= crc != first;
+  }
+  fail |= iterations > 0 && first != EXPECTED_CRC;
+
+  printf("coremark: %ld iterations crc %#06x %s\n", iterations, first,
+         fail ? "FAILED" : "ok");
+  return fail;
+}
@@ -0,0 +1,67 @@
+// Table-driven CRC-32 (IEEE 802.3) over a fixed buffer, checked against a
+// bitwise reference and the standard "123456789" check value.
+// Usage: crc32 [iterations]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 200
+#endif
+
+#define BUF_LEN 16384
+
+static uint32_t table[256];
+
+static void crc32_init(void) {
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int j = 0; j < 8; ++j) {
+      c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+    }
+    table[i] = c;
+  }
+}
+
+static uint32_t crc32_table(const uint8_t *p, size_t len) {
+  uint32_t crc = 0xffffffff;
+  while (len--) {
+    crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  }
+  return crc ^ 0xffffffff;
+}
+
+static uint32_t crc32_bitwise(const uint8_t *p, size_t len) {
+  uint32_t crc = 0xffffffff;
+  while (len--) {
+    crc ^= *p++;
+    for (int j = 0; j < 8; ++j) {
+      crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+    }
+  }
+  return crc ^ 0xffffffff;
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  static uint8_t buf[BUF_LEN];
+  uint32_t seed = 1, expected, crc = 0;
+  int fail = 0;
+
+  crc32_init();
+  fail |= crc32_table((const uint8_t *)"123456789", 9) != 0xcbf43926;
+
+  for (size_t i = 0; i < BUF_LEN; ++i) {
+    seed = seed * 1103515245 + 12345;
+    buf[i] = (uint8_t)(seed >> 16);
+  }
+  expected = crc32_bitwise(buf, BUF_LEN);
+  for (long i = 0; i < iterations; ++i) {
+    crc = crc32_table(buf, BUF_LEN);
+    fail |= crc != expected;
+  }
+
+  printf("crc32: %ld iterations %#010x %s\n", iterations, expected,
+         fail ? "FAILED" : "ok");
+  return fail;
+}
@@ -0,0 +1,187 @@
+// Recursive-descent parser for a JSON subset (objects, arrays, integers,
+// strings, true/false/null) over a generated document. The generator
+// records the node count and integer sum the parser must reproduce.
+// Usage: json [iterations]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 100
+#endif
+
+#define DOC_LEN 65536
+
+struct stats {
+  long nodes;
+  long sum;
+  long strings;
+};
+
+struct parser {
+  const char *p;
+  int error;
+};
+
+static char doc[DOC_LEN];
+static size_t doc_len;
+static uint32_t seed = 42;
+
+static uint32_t next_rand(void) {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+static void emit(const char *s) {
+  size_t n = strlen(s);
+  memcpy(doc + doc_len, s, n);
+  doc_len += n;
+}
+
+static void gen_value(int depth, struct stats *st) {
+  char tmp[32];
+  uint32_t kind = depth > 3 ? next_rand() % 3 : next_rand() % 5;
+
+  ++st->nodes;
+  switch (kind) {
+  case 0: {
+    long v = (long)(next_rand() % 20001) - 10000;
+    st->sum += v;
+    sprintf(tmp, "%ld", v);
+    emit(tmp);
+    break;
+  }
+  case 1:
+    ++st->strings;
+    sprintf(tmp, "\"s%u\\\"x\"", next_rand() % 1000);
+    emit(tmp);
+    break;
+  case 2:
+    emit(next_rand() % 2 ? "true" : "null");
+    break;
+  case 3: {
+    int n = (int)(next_rand() % 5);
+    emit("[");
+    for (int i = 0; i < n; ++i) {
+      emit(i ? ", " : "");
+      gen_value(depth + 1, st);
+    }
+    emit("]");
+    break;
+  }
+  default: {
+    int n = (int)(next_rand() % 5);
+    emit("{");
+    for (int i = 0; i < n; ++i) {
+      sprintf(tmp, "%s\"k%d\": ", i ? ", " : "", i);
+      emit(tmp);
+      gen_value(depth + 1, st);
+    }
+    emit("}");
+    break;
+  }
+  }
+}
+
+static void skip_ws(struct parser *ps) {
+  while (*ps->p == ' ' || *ps->p == '\n' || *ps->p == '\t') {
+    ++ps->p;
+  }
+}
+
+static int expect(struct parser *ps, char c) {
+  skip_ws(ps);
+  if (*ps->p != c) {
+    ps->error = 1;
+    return 0;
+  }
+  ++ps->p;
+  return 1;
+}
+
+static void parse_string(struct parser *ps) {
+  if (!expect(ps, '"')) {
+    return;
+  }
+  while (*ps->p && *ps->p != '"') {
+    if (*ps->p == '\\' && ps->p[1]) {
+      ++ps->p;
+    }
+    ++ps->p;
+  }
+  expect(ps, '"');
+}
+
+static void parse_value(struct parser *ps, struct stats *st) {
+  skip_ws(ps);
+  ++st->nodes;
+  char c = *ps->p;
+  if (c == '"') {
+    ++st->strings;
+    parse_string(ps);
+  } else if (c == '-' || (c >= '0' && c <= '9')) {
+    char *end;
+    st->sum += strtol(ps->p, &end, 10);
+    ps->p = end;
+  } else if (strncmp(ps->p, "true", 4) == 0 || strncmp(ps->p, "null", 4) == 0) {
+    ps->p += 4;
+  } else if (c == '[') {
+    ++ps->p;
+    skip_ws(ps);
+    if (*ps->p == ']') {
+      ++ps->p;
+      return;
+    }
+    do {
+      parse_value(ps, st);
+      skip_ws(ps);
+    } while (!ps->error && *ps->p == ',' && ++ps->p);
+    expect(ps, ']');
+  } else if (c == '{') {
+    ++ps->p;
+    skip_ws(ps);
+    if (*ps->p == '}') {
+      ++ps->p;
+      return;
+    }
+    do {
+      parse_string(ps);
+      expect(ps, ':');
+      parse_value(ps, st);
+      skip_ws(ps);
+    } while (!ps->error && *ps->p == ',' && ++ps->p);
+    expect(ps, '}');
+  } else {
+    ps->error = 1;
+  }
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  struct stats expected = {0}, got = {0};
+  int fail = 0;
+
+  emit("[");
+  // Leave room for the largest value gen_value can produce.
+  while (doc_len < DOC_LEN / 2) {
+    emit(expected.nodes ? ",\n" : "");
+    gen_value(0, &expected);
+  }
+  emit("]");
+  doc[doc_len] = '\0';
+  // The outer array is a node too.
+  ++expected.nodes;
+
+  for (long i = 0; i < iterations; ++i) {
+    struct parser ps = {doc, 0};
+    memset(&got, 0, sizeof(got));
+    parse_value(&ps, &got);
+    fail |= ps.error || got.nodes != expected.nodes ||
+            got.sum != expected.sum || got.strings != expected.strings;
+  }
+
+  printf("json: %ld iterations %zu bytes %ld nodes sum %ld %s\n", iterations,
+         doc_len, expected.nodes, expected.sum, fail ? "FAILED" : "ok");
+  return fail;
+}
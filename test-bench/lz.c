@@ -0,0 +1,158 @@
+// LZ77-style compressor with a hash-chained match finder (LZ4-like token
+// format) and its decompressor, round-tripping generated text.
+// Usage: lz [iterations]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 50
+#endif
+
+#define INPUT_LEN 16384
+#define HASH_BITS 12
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+
+static uint32_t hash4(const uint8_t *p) {
+  uint32_t v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+               (uint32_t)p[3] << 24;
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *out, size_t len) {
+  while (len >= 255) {
+    *out++ = 255;
+    len -= 255;
+  }
+  *out++ = (uint8_t)len;
+  return out;
+}
+
+// Each sequence is a token (literal count << 4 | match length - 4), extra
+// length bytes, the literals, then a 16-bit little-endian offset. The last
+// sequence has literals only.
+static size_t compress(const uint8_t *in, size_t len, uint8_t *out) {
+  static int32_t head[1 << HASH_BITS];
+  const uint8_t *anchor = in, *p = in, *end = in + len;
+  uint8_t *o = out;
+
+  for (size_t i = 0; i < (1 << HASH_BITS); ++i) {
+    head[i] = -1;
+  }
+  while (p + MIN_MATCH <= end) {
+    uint32_t h = hash4(p);
+    int32_t cand = head[h];
+    head[h] = (int32_t)(p - in);
+    if (cand < 0 || p - (in + cand) > MAX_OFFSET ||
+        memcmp(in + cand, p, MIN_MATCH) != 0) {
+      ++p;
+      continue;
+    }
+    const uint8_t *m = in + cand;
+    size_t match = MIN_MATCH;
+    while (p + match < end && m[match] == p[match]) {
+      ++match;
+    }
+    size_t lits = (size_t)(p - anchor);
+    size_t ml = match - MIN_MATCH;
+    uint8_t *token = o++;
+    *token = (uint8_t)((lits < 15 ? lits : 15) << 4 | (ml < 15 ? ml : 15));
+    if (lits >= 15) {
+      o = put_length(o, lits - 15);
+    }
+    memcpy(o, anchor, lits);
+    o += lits;
+    size_t offset = (size_t)(p - m);
+    *o++ = (uint8_t)offset;
+    *o++ = (uint8_t)(offset >> 8);
+    if (ml >= 15) {
+      o = put_length(o, ml - 15);
+    }
+    p += match;
+    anchor = p;
+  }
+  size_t lits = (size_t)(end - anchor);
+  *o++ = (uint8_t)((lits < 15 ? lits : 15) << 4);
+  if (lits >= 15) {
+    o = put_length(o, lits - 15);
+  }
+  memcpy(o, anchor, lits);
+  o += lits;
+  return (size_t)(o - out);
+}
+
+static size_t get_length(const uint8_t **p, size_t len) {
+  if (len == 15) {
+    uint8_t b;
+    do {
+      b = *(*p)++;
+      len += b;
+    } while (b == 255);
+  }
+  return len;
+}
+
+static size_t decompress(const uint8_t *in, size_t len, uint8_t *out) {
+  const uint8_t *p = in, *end = in + len;
+  uint8_t *o = out;
+
+  while (p < end) {
+    uint8_t token = *p++;
+    size_t lits = get_length(&p, token >> 4);
+    memcpy(o, p, lits);
+    o += lits;
+    p += lits;
+    if (p >= end) {
+      break;
+    }
+    size_t offset = (size_t)p[0] | (size_t)p[1] << 8;
+    p += 2;
+    size_t match = get_length(&p, token & 15) + MIN_MATCH;
+    // Byte by byte: matches may overlap their own output.
+    const uint8_t *m = o - offset;
+    while (match--) {
+      *o++ = *m++;
+    }
+  }
+  return (size_t)(o - out);
+}
+
+static size_t generate(uint8_t *buf, size_t len) {
+  static const char *const words[] = {
+      "the ",    "quick ",  "brown ",     "fox ",   "jumps ",   "over ",
+      "lazy ",   "dog ",    "interpret ", "m68k ",  "guest ",   "host ",
+      "syscall ", "block ", "register ",  "flags ", "memory\n", "stack "};
+  uint32_t seed = 12345;
+  size_t n = 0;
+  while (n < len) {
+    seed = seed * 1103515245 + 12345;
+    const char *w = words[(seed >> 16) % 18];
+    while (*w && n < len) {
+      buf[n++] = (uint8_t)*w++;
+    }
+  }
+  return n;
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  static uint8_t input[INPUT_LEN];
+  static uint8_t packed[INPUT_LEN + INPUT_LEN / 255 + 16];
+  static uint8_t output[INPUT_LEN];
+  size_t len = generate(input, INPUT_LEN), packed_len = 0;
+  int fail = 0;
+
+  for (long i = 0; i < iterations; ++i) {
+    packed_len = compress(input, len, packed);
+    size_t out_len = decompress(packed, packed_len, output);
+    fail |= out_len != len || memcmp(input, output, len) != 0;
+    // Vary the input so every iteration does fresh work.
+    input[(size_t)i % len] ^= 0x20;
+  }
+
+  printf("lz: %ld iterations %zu -> %zu bytes %s\n", iterations, len,
+         packed_len, fail ? "FAILED" : "ok");
+  return fail;
+}
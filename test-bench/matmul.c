@@ -0,0 +1,50 @@
+// Double-precision matrix multiply. Built with -msoft-float, so this
+// mostly measures the libgcc soft-float routines and the calls into them.
+// Inputs are chosen so every product is exact. Usage: matmul [iterations]
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 10
+#endif
+
+#define N 32
+
+static double a[N][N], b[N][N], c[N][N];
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  double trace = 0.0;
+  int fail = 0;
+
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j < N; ++j) {
+      a[i][j] = (i + 1) * 0.5;
+      b[i][j] = (j + 1) * 0.25;
+    }
+  }
+  for (long it = 0; it < iterations; ++it) {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        double sum = 0.0;
+        for (int k = 0; k < N; ++k) {
+          sum += a[i][k] * b[k][j];
+        }
+        c[i][j] = sum;
+      }
+    }
+    // c[i][j] = N * (i + 1) * (j + 1) / 8
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        fail |= c[i][j] != N * (i + 1) * (j + 1) / 8.0;
+      }
+    }
+  }
+  for (int i = 0; i < N; ++i) {
+    trace += c[i][i];
+  }
+
+  printf("matmul: %ld iterations %dx%d trace %.1f %s\n", iterations, N, N,
+         trace, fail ? "FAILED" : "ok");
+  return fail;
+}
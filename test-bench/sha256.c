@@ -0,0 +1,171 @@
+// SHA-256 over a fixed buffer, chaining each digest into the next input.
+// Checks the FIPS 180-2 test vectors first. Usage: sha256 [iterations]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 200
+#endif
+
+#define BUF_LEN 4096
+
+struct sha256 {
+  uint32_t h[8];
+  uint8_t block[64];
+  size_t used;
+  uint64_t total;
+};
+
+static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_init(struct sha256 *s) {
+  static const uint32_t iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                 0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                 0x1f83d9ab, 0x5be0cd19};
+  memcpy(s->h, iv, sizeof(iv));
+  s->used = 0;
+  s->total = 0;
+}
+
+static void sha256_block(struct sha256 *s, const uint8_t *p) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 |
+           (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+  }
+  for (int i = 16; i < 64; ++i) {
+    uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = s->h[0], b = s->h[1], c = s->h[2], d = s->h[3];
+  uint32_t e = s->h[4], f = s->h[5], g = s->h[6], h = s->h[7];
+  for (int i = 0; i < 64; ++i) {
+    uint32_t t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) +
+                  ((e & f) ^ (~e & g)) + k[i] + w[i];
+    uint32_t t2 =
+        (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  s->h[0] += a;
+  s->h[1] += b;
+  s->h[2] += c;
+  s->h[3] += d;
+  s->h[4] += e;
+  s->h[5] += f;
+  s->h[6] += g;
+  s->h[7] += h;
+}
+
+static void sha256_update(struct sha256 *s, const uint8_t *p, size_t len) {
+  s->total += len;
+  while (len > 0) {
+    size_t n = 64 - s->used;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(s->block + s->used, p, n);
+    s->used += n;
+    p += n;
+    len -= n;
+    if (s->used == 64) {
+      sha256_block(s, s->block);
+      s->used = 0;
+    }
+  }
+}
+
+static void sha256_final(struct sha256 *s, uint8_t out[32]) {
+  uint64_t bits = s->total * 8;
+  uint8_t pad = 0x80;
+  sha256_update(s, &pad, 1);
+  pad = 0;
+  while (s->used != 56) {
+    sha256_update(s, &pad, 1);
+  }
+  for (int i = 7; i >= 0; --i) {
+    uint8_t byte = (uint8_t)(bits >> (8 * i));
+    sha256_update(s, &byte, 1);
+  }
+  for (int i = 0; i < 8; ++i) {
+    out[4 * i] = (uint8_t)(s->h[i] >> 24);
+    out[4 * i + 1] = (uint8_t)(s->h[i] >> 16);
+    out[4 * i + 2] = (uint8_t)(s->h[i] >> 8);
+    out[4 * i + 3] = (uint8_t)s->h[i];
+  }
+}
+
+static void to_hex(const uint8_t digest[32], char out[65]) {
+  for (int i = 0; i < 32; ++i) {
+    sprintf(out + 2 * i, "%02x", digest[i]);
+  }
+}
+
+static int check_vector(const char *msg, const char *expected) {
+  struct sha256 s;
+  uint8_t digest[32];
+  char hex[65];
+  sha256_init(&s);
+  sha256_update(&s, (const uint8_t *)msg, strlen(msg));
+  sha256_final(&s, digest);
+  to_hex(digest, hex);
+  if (strcmp(hex, expected) != 0) {
+    fprintf(stderr, "sha256(\"%s\") = %s, expected %s\n", msg, hex, expected);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  static uint8_t buf[BUF_LEN];
+  uint8_t digest[32] = {0};
+  char hex[65];
+  int fail = 0;
+
+  fail |= check_vector("", "e3b0c44298fc1c149afbf4c8996fb924"
+                           "27ae41e4649b934ca495991b7852b855");
+  fail |= check_vector("abc", "ba7816bf8f01cfea414140de5dae2223"
+                              "b00361a396177a9cb410ff61f20015ad");
+  fail |= check_vector(
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  for (size_t i = 0; i < BUF_LEN; ++i) {
+    buf[i] = (uint8_t)(i * 131 + 7);
+  }
+  for (long i = 0; i < iterations; ++i) {
+    struct sha256 s;
+    memcpy(buf, digest, sizeof(digest));
+    sha256_init(&s);
+    sha256_update(&s, buf, BUF_LEN);
+    sha256_final(&s, digest);
+  }
+  to_hex(digest, hex);
+
+  printf("sha256: %ld iterations %s %s\n", iterations, hex,
+         fail ? "FAILED" : "ok");
+  return fail;
+}
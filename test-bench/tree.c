@@ -0,0 +1,76 @@
+// Allocator stress in the style of the binary-trees benchmark: build and
+// free many short-lived trees alongside one long-lived tree, checking node
+// counts. Usage: tree [iterations]
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef ITERATIONS
+#define ITERATIONS 4
+#endif
+
+#define MIN_DEPTH 4
+#define MAX_DEPTH 12
+
+struct node {
+  struct node *left;
+  struct node *right;
+  int value;
+};
+
+static struct node *build(int depth, int value) {
+  struct node *n = malloc(sizeof(*n));
+  if (!n) {
+    perror("malloc");
+    exit(1);
+  }
+  n->value = value;
+  if (depth > 0) {
+    n->left = build(depth - 1, 2 * value - 1);
+    n->right = build(depth - 1, 2 * value);
+  } else {
+    n->left = n->right = NULL;
+  }
+  return n;
+}
+
+static long check(const struct node *n) {
+  if (!n->left) {
+    return 1;
+  }
+  return 1 + check(n->left) + check(n->right);
+}
+
+static void release(struct node *n) {
+  if (n->left) {
+    release(n->left);
+    release(n->right);
+  }
+  free(n);
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+  long total = 0;
+  int fail = 0;
+
+  struct node *long_lived = build(MAX_DEPTH, 1);
+  for (long it = 0; it < iterations; ++it) {
+    for (int depth = MIN_DEPTH; depth <= MAX_DEPTH; depth += 2) {
+      int trees = 1 << (MAX_DEPTH - depth + MIN_DEPTH - 2);
+      for (int i = 0; i < trees; ++i) {
+        struct node *t = build(depth, i);
+        long count = check(t);
+        fail |= count != (2L << depth) - 1;
+        total += count;
+        release(t);
+      }
+    }
+  }
+  long count = check(long_lived);
+  fail |= count != (2L << MAX_DEPTH) - 1;
+  release(long_lived);
+
+  printf("tree: %ld iterations %ld nodes allocated %s\n", iterations, total,
+         fail ? "FAILED" : "ok");
+  return fail;
+}
@@ -0,0 +1,70 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define PAGE 4096
+
+int main(void) {
+  char path[] = "/tmp/mmap_file_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return 1;
+  }
+  unlink(path);
+
+  // Two full pages and a partial third one.
+  static char buf[2 * PAGE + 100];
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = 'a' + i % 26;
+  }
+  if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+    return 2;
+  }
+
+  char *p = mmap(NULL, 3 * PAGE, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) {
+    return 3;
+  }
+  printf("start %c%c%c\n", p[0], p[1], p[2]);
+  printf("page 1 %c, page 2 %c\n", p[PAGE], p[2 * PAGE]);
+  printf("past eof %d\n", p[2 * PAGE + 100]);
+
+  // Mapping from an offset.
+  char *q = mmap(NULL, PAGE, PROT_READ, MAP_PRIVATE, fd, PAGE);
+  if (q == MAP_FAILED) {
+    return 4;
+  }
+  printf("offset %c, same %d\n", q[0], memcmp(q, p + PAGE, PAGE) == 0);
+
+  // A private mapping made writable doesn't write through to the file.
+  if (mprotect(p, PAGE, PROT_READ | PROT_WRITE) != 0) {
+    return 5;
+  }
+  p[0] = 'Z';
+  char c;
+  if (pread(fd, &c, 1, 0) != 1) {
+    return 6;
+  }
+  printf("mapped %c, file %c\n", p[0], c);
+
+  // Unmap the middle page; the others stay.
+  if (munmap(p + PAGE, PAGE) != 0) {
+    return 7;
+  }
+  printf("after munmap %c %c\n", p[0], p[2 * PAGE]);
+
+  // Map the file again over the hole.
+  char *r = mmap(p + PAGE, PAGE, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+  if (r != p + PAGE) {
+    return 8;
+  }
+  printf("refilled %c%c\n", r[0], r[1]);
+
+  munmap(p, 3 * PAGE);
+  munmap(q, PAGE);
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,118 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// struct mmsghdr, spelled out so the test doesn't depend on _GNU_SOURCE.
+struct batch_msg {
+  struct msghdr hdr;
+  unsigned int len;
+};
+
+static void set_iov(struct batch_msg *m, struct iovec *iov, void *buf,
+                    size_t len) {
+  memset(m, 0, sizeof(*m));
+  iov->iov_base = buf;
+  iov->iov_len = len;
+  m->hdr.msg_iov = iov;
+  m->hdr.msg_iovlen = 1;
+}
+
+static int batch(void) {
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) != 0) {
+    return 1;
+  }
+
+  const char *payloads[] = {"one", "three", "fifteen chars!!", "", "last"};
+  enum { N = sizeof(payloads) / sizeof(payloads[0]) };
+  struct batch_msg out[N];
+  struct iovec out_iov[N];
+  for (int i = 0; i < N; i++) {
+    set_iov(&out[i], &out_iov[i], (void *)payloads[i], strlen(payloads[i]));
+  }
+  long sent = syscall(SYS_sendmmsg, sv[0], out, N, 0);
+  printf("sent %ld:", sent);
+  for (int i = 0; i < N; i++) {
+    printf(" %u", out[i].len);
+  }
+  printf("\n");
+
+  // Room for more messages than were sent; MSG_DONTWAIT stops at the end.
+  struct batch_msg in[N + 2];
+  struct iovec in_iov[N + 2];
+  char bufs[N + 2][32];
+  for (int i = 0; i < N + 2; i++) {
+    set_iov(&in[i], &in_iov[i], bufs[i], sizeof(bufs[i]));
+  }
+  long got = syscall(SYS_recvmmsg, sv[1], in, N + 2, MSG_DONTWAIT, NULL);
+  printf("received %ld\n", got);
+  for (int i = 0; i < got; i++) {
+    printf("  %u '%.*s'\n", in[i].len, (int)in[i].len, bufs[i]);
+  }
+
+  // A buffer shorter than the datagram truncates it.
+  syscall(SYS_sendmmsg, sv[0], out, 3, 0);
+  for (int i = 0; i < 3; i++) {
+    set_iov(&in[i], &in_iov[i], bufs[i], 4);
+  }
+  got = syscall(SYS_recvmmsg, sv[1], in, 3, MSG_DONTWAIT, NULL);
+  printf("short buffers %ld:", got);
+  for (int i = 0; i < got; i++) {
+    printf(" %u%s", in[i].len,
+           in[i].hdr.msg_flags & MSG_TRUNC ? " (truncated)" : "");
+  }
+  printf("\n");
+
+  close(sv[0]);
+  close(sv[1]);
+  return 0;
+}
+
+static int vectored(void) {
+  char path[] = "/tmp/preadv2_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return 10;
+  }
+  unlink(path);
+
+  char a[] = "hello ", b[] = "world";
+  struct iovec iov[2] = {{a, 6}, {b, 5}};
+  // Offset -1 writes at, and advances, the file position.
+  long n = syscall(SYS_pwritev2, fd, iov, 2, -1L, -1L, 0);
+  printf("pwritev2 at -1: %ld, position %ld\n", n,
+         (long)lseek(fd, 0, SEEK_CUR));
+  // An explicit offset leaves the position alone.
+  struct iovec one = {"W", 1};
+  n = syscall(SYS_pwritev2, fd, &one, 1, 6L, 0L, 0);
+  printf("pwritev2 at 6: %ld, position %ld\n", n, (long)lseek(fd, 0, SEEK_CUR));
+
+  char x[4] = {0}, y[8] = {0};
+  struct iovec rd[2] = {{x, 3}, {y, 7}};
+  n = syscall(SYS_preadv2, fd, rd, 2, 2L, 0L, 0);
+  printf("preadv2 at 2: %ld '%s' '%s', position %ld\n", n, x, y,
+         (long)lseek(fd, 0, SEEK_CUR));
+
+  lseek(fd, 4, SEEK_SET);
+  memset(x, 0, sizeof(x));
+  memset(y, 0, sizeof(y));
+  n = syscall(SYS_preadv2, fd, rd, 2, -1L, -1L, 0);
+  printf("preadv2 at -1: %ld '%s' '%s', position %ld\n", n, x, y,
+         (long)lseek(fd, 0, SEEK_CUR));
+
+  close(fd);
+  return 0;
+}
+
+int main(void) {
+  int rc = batch();
+  if (rc != 0) {
+    return rc;
+  }
+  return vectored();
+}
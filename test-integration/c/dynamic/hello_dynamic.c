@@ -0,0 +1,11 @@
+// Linked against the shared uClibc and run with --sysroot, so the dynamic
+// loader maps libc from the file.
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%s %d", "dynamic", argc);
+  puts(buf);
+  return strcmp(buf, "dynamic 1") == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Run with the sysroot tests/integration.rs builds, which holds
+// /etc/behistun-marker and /tmp/behistun-overlay, each reading "sysroot",
+// a relative symlink /up -> ../../.. and an absolute one /abs -> /etc.
+// Neither link may lead out of the sysroot, and opens that write must go
+// to the host.
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define OVERLAY "/tmp/behistun-overlay"
+
+// Whether `path`, opened with `flags`, starts with `want`.
+static int reads(const char *path, int flags, const char *want) {
+  char buf[16] = {0};
+  int fd = open(path, flags);
+  if (fd < 0) {
+    return 0;
+  }
+  read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  return strncmp(buf, want, strlen(want)) == 0;
+}
+
+int main(void) {
+  if (!reads("/etc/behistun-marker", O_RDONLY, "sysroot")) {
+    return 1;
+  }
+  // `..` stops at the sysroot's root.
+  if (!reads("/up/etc/behistun-marker", O_RDONLY, "sysroot")) {
+    return 2;
+  }
+  // An absolute link target is taken inside the sysroot.
+  if (!reads("/abs/behistun-marker", O_RDONLY, "sysroot")) {
+    return 3;
+  }
+
+  // A read-only open sees the sysroot's copy...
+  if (!reads(OVERLAY, O_RDONLY, "sysroot")) {
+    return 4;
+  }
+  // ...but creating and truncating reaches the host's file,
+  int fd = open(OVERLAY, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || write(fd, "host\n", 5) != 5) {
+    return 5;
+  }
+  close(fd);
+  // which a writable open reads back,
+  if (!reads(OVERLAY, O_RDWR, "host")) {
+    return 6;
+  }
+  // while the sysroot's copy is untouched.
+  if (!reads(OVERLAY, O_RDONLY, "sysroot")) {
+    return 7;
+  }
+  // Removing goes to the host too.
+  if (unlink(OVERLAY) != 0 || reads(OVERLAY, O_RDWR, "host")) {
+    return 8;
+  }
+  return 0;
+}
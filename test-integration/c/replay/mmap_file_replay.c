@@ -0,0 +1,45 @@
+// Run once normally, and once recorded and replayed: the replay has no file
+// behind the fd, so the mapped bytes must come from the recording.
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define PAGE 4096
+
+int main(void) {
+  char path[] = "/tmp/mmap_replay_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return 1;
+  }
+  unlink(path);
+
+  static char buf[PAGE + 10];
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = i * 7;
+  }
+  if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+    return 2;
+  }
+
+  char *p = mmap(NULL, 2 * PAGE, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) {
+    return 3;
+  }
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    if (p[i] != buf[i]) {
+      return 4;
+    }
+  }
+  if (p[sizeof(buf)] != 0) {
+    return 5;
+  }
+
+  char *q = mmap(NULL, PAGE, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, PAGE);
+  if (q == MAP_FAILED || q[9] != buf[PAGE + 9]) {
+    return 6;
+  }
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Snapshot and restore, driven by tests/integration.rs. Without arguments
+// the guest asks for the snapshot with the 0x4253 hypercall; with "at" the
+// harness takes it with --snapshot-at snapshot_checkpoint. Either way the
+// restored process must find the global, heap and stack state it had when
+// the snapshot was taken.
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SNAPSHOT_SYSCALL 0x4253
+
+static int counter = 41;
+
+__attribute__((noinline)) void snapshot_checkpoint(void) {
+  __asm__ volatile("");
+}
+
+static int state_intact(int local, const char *heap) {
+  if (counter != 42 || local != 7 || strcmp(heap, "heap survives") != 0) {
+    printf("state lost: counter %d, local %d, heap '%s'\n", counter, local,
+           heap);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  volatile int local = 7;
+  char *heap = malloc(64);
+  strcpy(heap, "heap survives");
+  counter++;
+
+  if (argc > 1 && strcmp(argv[1], "at") == 0) {
+    snapshot_checkpoint();
+    if (!state_intact(local, heap)) {
+      return 1;
+    }
+    printf("past checkpoint\n");
+  } else {
+    // uClibc's syscall() turns -errno into -1 and errno.
+    long r = syscall(SNAPSHOT_SYSCALL);
+    if (r < 0) {
+      printf("no snapshot: errno %d\n", errno);
+      return 0;
+    }
+    if (r == 1) {
+      if (!state_intact(local, heap)) {
+        return 2;
+      }
+      printf("restored\n");
+      return 0;
+    }
+    printf("taken\n");
+  }
+
+  // Nothing done after the snapshot may show up in a restored process.
+  counter = 0;
+  local = 0;
+  strcpy(heap, "clobbered");
+  return 0;
+}
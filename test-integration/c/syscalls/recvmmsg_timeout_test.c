@@ -0,0 +1,82 @@
+// recvmmsg writes the time left back into its timeout. qemu ignores the
+// timeout altogether, so this can't be checked against it.
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// struct mmsghdr, spelled out so the test doesn't depend on _GNU_SOURCE.
+struct batch_msg {
+  struct msghdr hdr;
+  unsigned int len;
+};
+
+// The timespec recvmmsg takes, with a 32-bit time_t.
+struct timespec32 {
+  int32_t tv_sec;
+  int32_t tv_nsec;
+};
+
+// The one recvmmsg_time64 takes.
+struct timespec64 {
+  int64_t tv_sec;
+  int64_t tv_nsec;
+};
+
+static int sv[2];
+static struct batch_msg msgs[4];
+static struct iovec iovs[4];
+static char bufs[4][16];
+
+// Send three datagrams and get the receive side ready for four.
+static void prepare(void) {
+  for (int i = 0; i < 3; i++) {
+    write(sv[0], "datagram", 8);
+  }
+  for (int i = 0; i < 4; i++) {
+    memset(&msgs[i], 0, sizeof(msgs[i]));
+    iovs[i].iov_base = bufs[i];
+    iovs[i].iov_len = sizeof(bufs[i]);
+    msgs[i].hdr.msg_iov = &iovs[i];
+    msgs[i].hdr.msg_iovlen = 1;
+  }
+}
+
+int main(void) {
+  if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) != 0) {
+    return 1;
+  }
+
+  // MSG_WAITFORONE returns once the queue is empty instead of waiting
+  // for the fourth datagram.
+  prepare();
+  struct timespec32 t32 = {1, 0};
+  if (syscall(SYS_recvmmsg, sv[1], msgs, 4, MSG_WAITFORONE, &t32) != 3) {
+    return 2;
+  }
+  if (msgs[2].len != 8) {
+    return 3;
+  }
+  // Less than the full second is left.
+  if (t32.tv_sec != 0 || t32.tv_nsec < 0 || t32.tv_nsec >= 1000000000) {
+    return 4;
+  }
+
+#ifdef SYS_recvmmsg_time64
+  prepare();
+  struct timespec64 t64 = {1, 0};
+  if (syscall(SYS_recvmmsg_time64, sv[1], msgs, 4, MSG_WAITFORONE, &t64) !=
+      3) {
+    return 5;
+  }
+  if (t64.tv_sec != 0 || t64.tv_nsec < 0 || t64.tv_nsec >= 1000000000) {
+    return 6;
+  }
+#endif
+
+  close(sv[0]);
+  close(sv[1]);
+  return 0;
+}
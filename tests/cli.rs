@@ -1,6 +1,8 @@
 use datatest_stable as datatest;
 use std::{
-    fs, io,
+    ffi::OsString,
+    fs,
+    io::{self, Read},
     path::{Path, PathBuf},
     process::{Command, Output, Stdio},
     sync::Once,
@@ -37,16 +39,37 @@ fn tool_available(bin: &str) -> bool {
         .unwrap_or(false)
 }
 
-fn run_qemu(exe: &Path, args: &[String]) -> io::Result<Output> {
+fn run_qemu(exe: &Path, args: &[String], merged: bool) -> io::Result<Output> {
     let mut cmd = Command::new(QEMU);
     cmd.arg(exe).args(args);
-    cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output()
+    output(cmd, merged)
 }
 
-fn run_interp(exe: &Path, args: &[String]) -> io::Result<Output> {
+fn run_interp(exe: &Path, args: &[String], flags: &[OsString], merged: bool) -> io::Result<Output> {
     let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
-    cmd.arg(exe).args(args);
-    cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output()
+    cmd.args(flags).arg(exe).args(args);
+    output(cmd, merged)
+}
+
+/// Run `cmd` to completion. A `merged` run writes stdout and stderr into
+/// one pipe, so the output holds both in the order they were written and
+/// an empty stderr.
+fn output(mut cmd: Command, merged: bool) -> io::Result<Output> {
+    if !merged {
+        return cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output();
+    }
+    let (mut reader, writer) = io::pipe()?;
+    cmd.stdout(writer.try_clone()?).stderr(writer);
+    let mut child = cmd.spawn()?;
+    // The command holds the write ends; close them so the read sees EOF.
+    drop(cmd);
+    let mut stdout = Vec::new();
+    reader.read_to_end(&mut stdout)?;
+    Ok(Output {
+        status: child.wait()?,
+        stdout,
+        stderr: Vec::new(),
+    })
 }
 
 fn to_runlog(out: Output) -> RunLog {
@@ -68,6 +91,109 @@ fn source_to_binary(src_path: &Path) -> PathBuf {
     PathBuf::from(bin_path_str)
 }
 
+/// A configuration of the emulator whose run must match qemu's.
+struct Variant {
+    flags: &'static [&'static str],
+    /// Run once with `--profile-out` first, then check the run laid out
+    /// from that profile with `--profile-in`.
+    profiled: bool,
+    /// Compare stdout and stderr as one stream, so that their
+    /// interleaving has to match as well.
+    merged: bool,
+    /// Save the binary's code map with `behistun aot` first, for the run
+    /// to pick up.
+    aot: bool,
+}
+
+impl Variant {
+    fn describe(&self) -> String {
+        let profiled = if self.profiled { ", profiled" } else { "" };
+        let merged = if self.merged {
+            ", stdout and stderr merged"
+        } else {
+            ""
+        };
+        format!("{}{profiled}{merged}", self.flags.join(" "))
+    }
+}
+
+const VARIANTS: &[Variant] = &[
+    Variant {
+        flags: &["--tier", "interp"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "ir"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "ir"],
+        profiled: true,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded"],
+        profiled: true,
+        merged: false,
+        aot: false,
+    },
+    // Both fill the code cache before the guest starts, from a static walk
+    // that splits blocks differently from the entries reached at run time.
+    Variant {
+        flags: &["--tier", "ir", "--predecode"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded", "--predecode"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded"],
+        profiled: false,
+        merged: false,
+        aot: true,
+    },
+    // --buffer-output coalesces writes to fds 1 and 2 but must keep their
+    // order, both on separate pipes and on a shared one.
+    Variant {
+        flags: &["--tier", "interp", "--buffer-output"],
+        profiled: false,
+        merged: false,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "interp", "--buffer-output"],
+        profiled: false,
+        merged: true,
+        aot: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded", "--buffer-output"],
+        profiled: false,
+        merged: true,
+        aot: false,
+    },
+];
+
+/// Check `path` against qemu in every variant. qemu runs once for each
+/// way of collecting output, and the variants run one after another,
+/// since many tests use fixed paths under /tmp that concurrent runs of
+/// the same binary would clobber.
 fn run_case(path: &Path) -> datatest::Result<()> {
     ensure_test_bins();
 
@@ -88,40 +214,95 @@ fn run_case(path: &Path) -> datatest::Result<()> {
 
     let args = load_args(path);
 
-    let run_out_ref = run_qemu(&exe, &args)?;
-    let reference = to_runlog(run_out_ref);
-
-    let run_out_interp = run_interp(&exe, &args)?;
-    let mine = to_runlog(run_out_interp);
-
-    if mine != reference {
-        let mut msg = String::new();
-        use std::fmt::Write;
-        writeln!(&mut msg, "\n=== MISMATCH for {} ===", path.display()).ok();
+    let reference = to_runlog(run_qemu(&exe, &args, false)?);
+    let mut merged_reference = None;
 
-        if mine.status != reference.status {
-            writeln!(
-                &mut msg,
-                "Exit code differs: interp={} qemu={}",
-                mine.status, reference.status
-            )
-            .ok();
-        }
-        if mine.stdout != reference.stdout {
-            writeln!(&mut msg, "\n--- stdout (interp) ---\n{}", mine.stdout).ok();
-            writeln!(&mut msg, "\n--- stdout (qemu)  ---\n{}", reference.stdout).ok();
-        }
-        if mine.stderr != reference.stderr {
-            writeln!(&mut msg, "\n--- stderr (interp) ---\n{}", mine.stderr).ok();
-            writeln!(&mut msg, "\n--- stderr (qemu)  ---\n{}", reference.stderr).ok();
+    for variant in VARIANTS {
+        let mut flags: Vec<OsString> = variant.flags.iter().map(OsString::from).collect();
+        let dir = variant.profiled.then(tempfile::tempdir).transpose()?;
+        if let Some(dir) = &dir {
+            let profile = dir.path().join("profile");
+            let mut record = flags.clone();
+            record.extend(["--profile-out".into(), profile.clone().into()]);
+            run_interp(&exe, &args, &record, false)?;
+            flags.extend(["--profile-in".into(), profile.into()]);
         }
 
-        panic!("{msg}");
+        let _code_map = variant.aot.then(|| save_code_map(&exe)).transpose()?;
+        let reference = if variant.merged {
+            match &merged_reference {
+                Some(reference) => reference,
+                None => merged_reference.insert(to_runlog(run_qemu(&exe, &args, true)?)),
+            }
+        } else {
+            &reference
+        };
+        let mine = to_runlog(run_interp(&exe, &args, &flags, variant.merged)?);
+        check(path, &variant.describe(), &mine, reference);
     }
 
     Ok(())
 }
 
+/// The `behistun aot` code map of a binary, deleted when dropped so that
+/// only the variant that asked for it picks it up.
+struct CodeMap(PathBuf);
+
+impl Drop for CodeMap {
+    fn drop(&mut self) {
+        let _ = fs::remove_file(&self.0);
+    }
+}
+
+/// Run `behistun aot` on `exe`, which saves the map next to the binary.
+fn save_code_map(exe: &Path) -> io::Result<CodeMap> {
+    let mut path = exe.canonicalize()?.into_os_string();
+    path.push(".aot");
+    let map = CodeMap(path.into());
+    let status = Command::new(env!("CARGO_BIN_EXE_behistun"))
+        .arg("aot")
+        .arg(exe)
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()?;
+    assert!(status.success(), "behistun aot {} failed", exe.display());
+    Ok(map)
+}
+
+/// Panic with a diff of whatever differs between the two runs.
+fn check(path: &Path, variant: &str, mine: &RunLog, reference: &RunLog) {
+    if mine == reference {
+        return;
+    }
+    let mut msg = String::new();
+    use std::fmt::Write;
+    writeln!(
+        &mut msg,
+        "\n=== MISMATCH for {} ({variant}) ===",
+        path.display()
+    )
+    .ok();
+
+    if mine.status != reference.status {
+        writeln!(
+            &mut msg,
+            "Exit code differs: interp={} qemu={}",
+            mine.status, reference.status
+        )
+        .ok();
+    }
+    if mine.stdout != reference.stdout {
+        writeln!(&mut msg, "\n--- stdout (interp) ---\n{}", mine.stdout).ok();
+        writeln!(&mut msg, "\n--- stdout (qemu)  ---\n{}", reference.stdout).ok();
+    }
+    if mine.stderr != reference.stderr {
+        writeln!(&mut msg, "\n--- stderr (interp) ---\n{}", mine.stderr).ok();
+        writeln!(&mut msg, "\n--- stderr (qemu)  ---\n{}", reference.stderr).ok();
+    }
+
+    panic!("{msg}");
+}
+
 datatest::harness! {
     { test = run_case, root = "./test-files", pattern = r#"^.*\.(c|S)$"# },
 }
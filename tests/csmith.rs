@@ -1,5 +1,6 @@
 use datatest_stable as datatest;
 use std::{
+    ffi::OsString,
     fs, io,
     path::{Path, PathBuf},
     process::{Command, Output, Stdio},
@@ -43,9 +44,9 @@ fn run_qemu(exe: &Path, args: &[String]) -> io::Result<Output> {
     cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output()
 }
 
-fn run_interp(exe: &Path, args: &[String]) -> io::Result<Output> {
+fn run_interp(exe: &Path, args: &[String], flags: &[OsString]) -> io::Result<Output> {
     let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
-    cmd.arg(exe).args(args);
+    cmd.args(flags).arg(exe).args(args);
     cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output()
 }
 
@@ -69,6 +70,47 @@ fn source_to_binary(src_path: &Path) -> PathBuf {
     PathBuf::from(bin_path_str)
 }
 
+/// A configuration of the emulator whose run must match qemu's.
+struct Variant {
+    flags: &'static [&'static str],
+    /// Run once with `--profile-out` first, then check the run laid out
+    /// from that profile with `--profile-in`.
+    profiled: bool,
+}
+
+impl Variant {
+    fn describe(&self) -> String {
+        let profiled = if self.profiled { ", profiled" } else { "" };
+        format!("{}{profiled}", self.flags.join(" "))
+    }
+}
+
+const VARIANTS: &[Variant] = &[
+    Variant {
+        flags: &["--tier", "interp"],
+        profiled: false,
+    },
+    Variant {
+        flags: &["--tier", "ir"],
+        profiled: false,
+    },
+    Variant {
+        flags: &["--tier", "threaded"],
+        profiled: false,
+    },
+    Variant {
+        flags: &["--tier", "ir"],
+        profiled: true,
+    },
+    Variant {
+        flags: &["--tier", "threaded"],
+        profiled: true,
+    },
+];
+
+/// Check `path` against qemu in every variant. qemu runs once, and the
+/// variants run one after another, since many tests use fixed paths
+/// under /tmp that concurrent runs of the same binary would clobber.
 fn run_case(path: &Path) -> datatest::Result<()> {
     ensure_csmith_bins();
 
@@ -89,40 +131,60 @@ fn run_case(path: &Path) -> datatest::Result<()> {
 
     let args = load_args(path);
 
-    let run_out_ref = run_qemu(&exe, &args)?;
-    let reference = to_runlog(run_out_ref);
-
-    let run_out_interp = run_interp(&exe, &args)?;
-    let mine = to_runlog(run_out_interp);
-
-    if mine != reference {
-        let mut msg = String::new();
-        use std::fmt::Write;
-        writeln!(&mut msg, "\n=== MISMATCH for {} ===", path.display()).ok();
-
-        if mine.status != reference.status {
-            writeln!(
-                &mut msg,
-                "Exit code differs: interp={} qemu={}",
-                mine.status, reference.status
-            )
-            .ok();
-        }
-        if mine.stdout != reference.stdout {
-            writeln!(&mut msg, "\n--- stdout (interp) ---\n{}", mine.stdout).ok();
-            writeln!(&mut msg, "\n--- stdout (qemu)  ---\n{}", reference.stdout).ok();
-        }
-        if mine.stderr != reference.stderr {
-            writeln!(&mut msg, "\n--- stderr (interp) ---\n{}", mine.stderr).ok();
-            writeln!(&mut msg, "\n--- stderr (qemu)  ---\n{}", reference.stderr).ok();
+    let reference = to_runlog(run_qemu(&exe, &args)?);
+
+    for variant in VARIANTS {
+        let mut flags: Vec<OsString> = variant.flags.iter().map(OsString::from).collect();
+        let dir = variant.profiled.then(tempfile::tempdir).transpose()?;
+        if let Some(dir) = &dir {
+            let profile = dir.path().join("profile");
+            let mut record = flags.clone();
+            record.extend(["--profile-out".into(), profile.clone().into()]);
+            run_interp(&exe, &args, &record)?;
+            flags.extend(["--profile-in".into(), profile.into()]);
         }
 
-        panic!("{msg}");
+        let mine = to_runlog(run_interp(&exe, &args, &flags)?);
+        check(path, &variant.describe(), &mine, &reference);
     }
 
     Ok(())
 }
 
+/// Panic with a diff of whatever differs between the two runs.
+fn check(path: &Path, variant: &str, mine: &RunLog, reference: &RunLog) {
+    if mine == reference {
+        return;
+    }
+    let mut msg = String::new();
+    use std::fmt::Write;
+    writeln!(
+        &mut msg,
+        "\n=== MISMATCH for {} ({variant}) ===",
+        path.display()
+    )
+    .ok();
+
+    if mine.status != reference.status {
+        writeln!(
+            &mut msg,
+            "Exit code differs: interp={} qemu={}",
+            mine.status, reference.status
+        )
+        .ok();
+    }
+    if mine.stdout != reference.stdout {
+        writeln!(&mut msg, "\n--- stdout (interp) ---\n{}", mine.stdout).ok();
+        writeln!(&mut msg, "\n--- stdout (qemu)  ---\n{}", reference.stdout).ok();
+    }
+    if mine.stderr != reference.stderr {
+        writeln!(&mut msg, "\n--- stderr (interp) ---\n{}", mine.stderr).ok();
+        writeln!(&mut msg, "\n--- stderr (qemu)  ---\n{}", reference.stderr).ok();
+    }
+
+    panic!("{msg}");
+}
+
 datatest::harness! {
     { test = run_case, root = "./test-csmith", pattern = r#"^.*\.c$"# },
 }
@@ -1,9 +1,10 @@
 use datatest_stable as datatest;
 use std::{
+    ffi::OsString,
     fs,
     path::{Path, PathBuf},
     process::{Command, Stdio},
-    sync::Once,
+    sync::{Once, OnceLock},
 };
 
 static INIT: Once = Once::new();
@@ -18,9 +19,53 @@ fn ensure_integration_bins() {
     });
 }
 
-fn run_interp(exe: &Path, args: &[String]) -> std::io::Result<std::process::Output> {
+/// The sysroot the dynamically linked tests run against: a copy of the
+/// cross compiler's `lib`, plus the files and symlinks that
+/// test-integration/c/dynamic/sysroot_test.c expects.
+fn sysroot() -> &'static Path {
+    static SYSROOT: OnceLock<PathBuf> = OnceLock::new();
+    SYSROOT.get_or_init(|| {
+        let output = Command::new("m68k-unknown-linux-uclibc-gcc")
+            .arg("-print-sysroot")
+            .output()
+            .expect("Failed to run 'm68k-unknown-linux-uclibc-gcc -print-sysroot'");
+        let compiler = PathBuf::from(String::from_utf8_lossy(&output.stdout).trim());
+
+        let root = Path::new(env!("CARGO_TARGET_TMPDIR")).join("sysroot");
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("etc")).unwrap();
+        fs::create_dir_all(root.join("tmp")).unwrap();
+        let status = Command::new("cp")
+            .arg("-a")
+            .arg(compiler.join("lib"))
+            .arg(&root)
+            .status()
+            .expect("Failed to run 'cp'");
+        assert!(
+            status.success(),
+            "copying {}/lib failed",
+            compiler.display()
+        );
+
+        fs::write(root.join("etc/behistun-marker"), "sysroot\n").unwrap();
+        fs::write(root.join("tmp/behistun-overlay"), "sysroot\n").unwrap();
+        // Both must resolve inside the sysroot, not on the host.
+        std::os::unix::fs::symlink("../../..", root.join("up")).unwrap();
+        std::os::unix::fs::symlink("/etc", root.join("abs")).unwrap();
+        root
+    })
+}
+
+fn run_interp(
+    exe: &Path,
+    args: &[String],
+    flags: &[OsString],
+) -> std::io::Result<std::process::Output> {
     let mut cmd = Command::new(env!("CARGO_BIN_EXE_behistun"));
-    cmd.arg(exe).args(args);
+    if exe.components().any(|c| c.as_os_str() == "dynamic") {
+        cmd.arg("--sysroot").arg(sysroot());
+    }
+    cmd.args(flags).arg(exe).args(args);
     cmd.stdout(Stdio::piped()).stderr(Stdio::piped()).output()
 }
 
@@ -35,7 +80,7 @@ fn source_to_binary(src_path: &Path) -> PathBuf {
     PathBuf::from(bin_path_str)
 }
 
-fn run_case(path: &Path) -> datatest::Result<()> {
+fn built_binary(path: &Path) -> PathBuf {
     ensure_integration_bins();
 
     let exe = source_to_binary(path);
@@ -47,29 +92,127 @@ fn run_case(path: &Path) -> datatest::Result<()> {
             exe.display()
         );
     }
+    exe
+}
 
-    let args = load_args(path);
-
-    let output = run_interp(&exe, &args)?;
-
-    // Just check that the test returned 0 (success)
+/// Panic unless the guest exited 0.
+fn check_success(path: &Path, how: &str, output: &std::process::Output) {
     if !output.status.success() {
         let stderr = String::from_utf8_lossy(&output.stderr);
         let stdout = String::from_utf8_lossy(&output.stdout);
         panic!(
-            "Test {} failed with exit code {}\nstdout: {}\nstderr: {}",
+            "Test {} ({how}) failed with exit code {}\nstdout: {}\nstderr: {}",
             path.display(),
             output.status.code().unwrap_or(-1),
             stdout,
             stderr
         );
     }
+}
+
+/// Run `path` on every tier, one after another: tests that use fixed
+/// paths under /tmp would clobber each other's files if run concurrently.
+/// Run `path` on every tier, one after another: tests that use fixed
+/// paths under /tmp would clobber each other's files if run concurrently.
+/// Dynamically linked cases and those under `replay` are then recorded
+/// and replayed as well.
+fn run_case(path: &Path) -> datatest::Result<()> {
+    let exe = built_binary(path);
+    let args = load_args(path);
+
+    for tier in ["interp", "ir", "threaded"] {
+        let output = run_interp(&exe, &args, &["--tier".into(), tier.into()])?;
+
+        // Just check that the test returned 0 (success)
+        check_success(path, &format!("--tier {tier}"), &output);
+    }
+
+    let replayed = ["replay", "dynamic"];
+    if path
+        .components()
+        .any(|c| replayed.iter().any(|&dir| c.as_os_str() == dir))
+    {
+        check_replay(path, &exe, &args)?;
+    }
+
+    Ok(())
+}
+
+/// Record a run and replay it; both must succeed. Replay never touches
+/// the host, so this checks that everything the guest read, mapped files
+/// included, came back from the recording.
+fn check_replay(path: &Path, exe: &Path, args: &[String]) -> std::io::Result<()> {
+    let dir = tempfile::tempdir()?;
+    let log = dir.path().join("syscalls.log");
+
+    let output = run_interp(exe, args, &["--record".into(), log.clone().into()])?;
+    check_success(path, "--record", &output);
+    let output = run_interp(exe, args, &["--replay".into(), log.into()])?;
+    check_success(path, "--replay", &output);
+
+    Ok(())
+}
+
+/// Snapshot the guest with the 0x4253 hypercall and with `--snapshot-at`,
+/// and check that each restored process finds the state it was saved
+/// with. A snapshot that can't be written must leave the guest running.
+fn run_case_snapshot(path: &Path) -> datatest::Result<()> {
+    let exe = built_binary(path);
+    let dir = tempfile::tempdir()?;
+    let snapshot = dir.path().join("guest.snap");
+    let expect = |how: &str, output: &std::process::Output, line: &str| {
+        check_success(path, how, output);
+        let stdout = String::from_utf8_lossy(&output.stdout);
+        assert!(
+            stdout.lines().any(|l| l == line),
+            "Test {} ({how}) printed {stdout:?}, expected {line:?}",
+            path.display()
+        );
+    };
+
+    let cases: [(&[String], Option<&str>, &str, &str); 2] = [
+        (&[], None, "taken", "restored"),
+        (
+            &["at".to_string()],
+            Some("snapshot_checkpoint"),
+            "past checkpoint",
+            "past checkpoint",
+        ),
+    ];
+    for (args, at, taken, restored) in cases {
+        let mut flags: Vec<OsString> = vec!["--snapshot".into(), snapshot.clone().into()];
+        if let Some(at) = at {
+            flags.extend(["--snapshot-at".into(), at.into()]);
+        }
+        expect("--snapshot", &run_interp(&exe, args, &flags)?, taken);
+        assert!(
+            snapshot.exists(),
+            "no snapshot written for {}",
+            path.display()
+        );
+
+        let output = Command::new(env!("CARGO_BIN_EXE_behistun"))
+            .arg("--restore")
+            .arg(&snapshot)
+            .output()?;
+        expect("--restore", &output, restored);
+        fs::remove_file(&snapshot)?;
+    }
+
+    let unwritable = dir.path().join("missing").join("guest.snap");
+    let output = run_interp(&exe, &[], &["--snapshot".into(), unwritable.into()])?;
+    expect(
+        "--snapshot into a missing directory",
+        &output,
+        &format!("no snapshot: errno {}", libc::ENOENT),
+    );
 
     Ok(())
 }
 
 datatest::harness! {
     { test = run_case, root = "./test-integration", pattern = r#"^.*\.(c|S)$"# },
+    { test = run_case_snapshot, root = "./test-integration/c", pattern = r#"(^|/)snapshot/[^/]*\.c$"# },
 }
 
 fn load_args(path: &Path) -> Vec<String> {